@@ -0,0 +1,269 @@
+#include "batchrunner.hh"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+
+// Makes a move, counting it in telemetry, if it is given
+void step_game(PackedGame& game, Direction dir,
+               TelemetryRecorder* telemetry)
+{
+    if( telemetry == nullptr )
+    {
+        game.step(dir);
+        return;
+    }
+
+    // The slide alone, without the new tile, tells the merges
+    PackedBoard before = game.board();
+    PackedBoard after = packed::move(before, dir).board;
+    {
+        TelemetryTimer timer(telemetry, STEP_PHASE);
+        game.step(dir);
+    }
+
+    // A step that changes nothing only ends the game, it isn't a move
+    if( after != before )
+    {
+        telemetry->record_move(before, after);
+    }
+}
+
+// Result of a finished game, also ending it in telemetry, if it is
+// given
+GameRecord end_game(const PackedGame& game, std::uint32_t seed,
+                    TelemetryRecorder* telemetry)
+{
+    GameRecord record;
+    record.seed = seed;
+    record.score = game.score();
+    record.moves = game.moves();
+    record.max_exponent = packed::max_exponent(game.board());
+    record.state = game.state();
+    if( telemetry != nullptr )
+    {
+        telemetry->end_game(record.score, record.max_exponent,
+                            game.state(), game.rng().spawns(),
+                            game.rng().spawn_retries());
+    }
+    return record;
+}
+
+}
+
+GameRecord play_game(Strategy& strategy, std::uint32_t seed,
+                     int goal_exponent, std::uint32_t strategy_seed,
+                     RngMode mode, TelemetryRecorder* telemetry)
+{
+    PackedGame game;
+    game.start(seed, goal_exponent, mode);
+    strategy.start_game(strategy_seed);
+    if( telemetry != nullptr )
+    {
+        telemetry->start_game(seed);
+    }
+    while( game.state() == PLAYING )
+    {
+        // If no move changes the board, any move loses the game
+        Direction dir = UP;
+        {
+            TelemetryTimer timer(telemetry, CHOOSE_PHASE);
+            strategy.choose(game.board(), dir);
+        }
+        step_game(game, legal_move(game.board(), dir), telemetry);
+    }
+    return end_game(game, seed, telemetry);
+}
+
+void play_games(Strategy& strategy, std::uint32_t first_seed,
+                std::uint32_t count, int goal_exponent, RngMode mode,
+                GameRecord* records, TelemetryRecorder* telemetry)
+{
+    std::vector<PackedGame> games(count);
+    for( std::uint32_t i = 0; i < count; ++i )
+    {
+        games[i].start(first_seed + i, goal_exponent, mode);
+    }
+    strategy.start_game(first_seed);
+
+    // The games are counted at the same time, each by its own recorder
+    std::vector<TelemetryRecorder> recorders;
+    if( telemetry != nullptr )
+    {
+        recorders.assign(count, TelemetryRecorder(telemetry->source()));
+        for( std::uint32_t i = 0; i < count; ++i )
+        {
+            recorders[i].start_game(first_seed + i);
+        }
+    }
+
+    // The games still going on, in seed order
+    std::vector<std::uint32_t> playing(count);
+    for( std::uint32_t i = 0; i < count; ++i )
+    {
+        playing[i] = i;
+    }
+    std::vector<PackedBoard> boards(count);
+    std::vector<Direction> dirs(count);
+    while( not playing.empty() )
+    {
+        for( std::size_t p = 0; p < playing.size(); ++p )
+        {
+            boards[p] = games[playing[p]].board();
+        }
+        std::chrono::steady_clock::time_point begin =
+                std::chrono::steady_clock::now();
+        strategy.choose_batch(boards.data(), playing.size(), dirs.data());
+
+        // The time of the batch is shared evenly by its games
+        if( telemetry != nullptr )
+        {
+            double seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - begin).count()
+                    / playing.size();
+            for( std::uint32_t i : playing )
+            {
+                recorders[i].record_phase(CHOOSE_PHASE, seconds);
+            }
+        }
+
+        // Move every game, and drop the ones that ended
+        std::size_t left = 0;
+        for( std::size_t p = 0; p < playing.size(); ++p )
+        {
+            std::uint32_t i = playing[p];
+            step_game(games[i], legal_move(games[i].board(), dirs[p]),
+                      telemetry != nullptr ? &recorders[i] : nullptr);
+            if( games[i].state() == PLAYING )
+            {
+                playing[left++] = i;
+            }
+        }
+        playing.resize(left);
+    }
+
+    for( std::uint32_t i = 0; i < count; ++i )
+    {
+        records[i] = end_game(games[i], first_seed + i,
+                              telemetry != nullptr ? &recorders[i] : nullptr);
+        if( telemetry != nullptr )
+        {
+            telemetry->take_games(recorders[i]);
+        }
+    }
+}
+
+BatchRunner::BatchRunner(const std::string& strategy, int threads):
+    strategy_(strategy), threads_(threads), rng_mode_(LEGACY_RNG),
+    telemetry_(nullptr), seconds_(0.0), moves_(0)
+{
+    if( threads_ <= 0 )
+    {
+        threads_ = std::thread::hardware_concurrency();
+    }
+    if( threads_ <= 0 )
+    {
+        threads_ = 1;
+    }
+}
+
+bool BatchRunner::run(std::uint32_t first_seed, std::uint32_t count,
+                      int goal_exponent, std::vector<GameRecord>& records)
+{
+    if( not create_strategy(strategy_) )
+    {
+        return false;
+    }
+    records.resize(count);
+
+    std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+    std::atomic<std::uint32_t> next_chunk(0);
+    std::atomic<std::uint64_t> total_moves(0);
+    std::vector<std::thread> workers;
+    for( int t = 0; t < threads_; ++t )
+    {
+        workers.push_back(std::thread([&]()
+        {
+            std::unique_ptr<Strategy> strategy = create_strategy(strategy_);
+            std::unique_ptr<TelemetryRecorder> recorder;
+            if( telemetry_ != nullptr )
+            {
+                recorder.reset(new TelemetryRecorder(
+                                   telemetry_->source(strategy_)));
+            }
+            std::uint64_t moves = 0;
+            while( true )
+            {
+                std::uint32_t first = next_chunk.fetch_add(BATCH_CHUNK_SIZE);
+                if( first >= count )
+                {
+                    break;
+                }
+                std::uint32_t last = first + BATCH_CHUNK_SIZE < count ?
+                            first + BATCH_CHUNK_SIZE : count;
+
+                if( strategy->prefers_batches() )
+                {
+                    play_games(*strategy, first_seed + first, last - first,
+                               goal_exponent, rng_mode_, &records[first],
+                               recorder.get());
+                }
+                else
+                {
+                    for( std::uint32_t i = first; i < last; ++i )
+                    {
+                        records[i] = play_game(*strategy, first_seed + i,
+                                               goal_exponent, first_seed + i,
+                                               rng_mode_, recorder.get());
+                    }
+                }
+                for( std::uint32_t i = first; i < last; ++i )
+                {
+                    moves += records[i].moves;
+                }
+                if( recorder )
+                {
+                    telemetry_->flush(*recorder);
+                }
+            }
+            total_moves += moves;
+        }));
+    }
+    for( std::thread& worker : workers )
+    {
+        worker.join();
+    }
+
+    seconds_ = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+    moves_ = total_moves;
+    return true;
+}
+
+void BatchRunner::set_rng_mode(RngMode mode)
+{
+    rng_mode_ = mode;
+}
+
+void BatchRunner::set_telemetry(Telemetry* telemetry)
+{
+    telemetry_ = telemetry;
+}
+
+int BatchRunner::threads() const
+{
+    return threads_;
+}
+
+double BatchRunner::seconds() const
+{
+    return seconds_;
+}
+
+std::uint64_t BatchRunner::moves() const
+{
+    return moves_;
+}
@@ -0,0 +1,94 @@
+/* BatchRunner
+ *
+ * Plays a range of seeds with a strategy on all the cores. The seeds
+ * are handed out to the worker threads in small chunks, and every
+ * thread has its own strategy object and writes the results of its
+ * games straight to their place in the result vector, so the threads
+ * share nothing but the chunk counter.
+ *
+ * A strategy that prefers batches, e.g. a plugin, plays the games of
+ * a chunk at the same time and chooses the moves of all of them with
+ * one call. It is then started once per chunk, with the first seed.
+ *
+ * The results don't depend on the number of threads.
+*/
+
+#ifndef BATCHRUNNER_HH
+#define BATCHRUNNER_HH
+
+#include "packedgame.hh"
+#include "strategy.hh"
+#include "telemetry.hh"
+#include <string>
+#include <vector>
+
+// Number of seeds a thread takes at a time, and the games a strategy
+// that prefers batches plays at the same time
+const std::uint32_t BATCH_CHUNK_SIZE = 64;
+
+// Result of one game
+struct GameRecord
+{
+    std::uint32_t seed;
+    std::uint32_t score;
+    std::uint32_t moves;
+    std::uint8_t max_exponent;
+    std::uint8_t state;
+};
+
+// Plays one game with the given strategy until it ends. The strategy
+// is started with strategy_seed, see Strategy::start_game. The game is
+// counted in telemetry, if it is given.
+GameRecord play_game(Strategy& strategy, std::uint32_t seed,
+                     int goal_exponent, std::uint32_t strategy_seed,
+                     RngMode mode = LEGACY_RNG,
+                     TelemetryRecorder* telemetry = nullptr);
+
+// Plays the games of the seeds [first_seed, first_seed + count) at the
+// same time, choosing the moves with Strategy::choose_batch, and puts
+// their results in records. The strategy is started once, with
+// first_seed. The games are counted in telemetry, if it is given, each
+// with an even share of the time of the batch calls, so they are the
+// same games as without it.
+void play_games(Strategy& strategy, std::uint32_t first_seed,
+                std::uint32_t count, int goal_exponent, RngMode mode,
+                GameRecord* records,
+                TelemetryRecorder* telemetry = nullptr);
+
+class BatchRunner
+{
+public:
+    // Constructor, 0 threads means one per core.
+    BatchRunner(const std::string& strategy, int threads = 0);
+
+    // Plays a game for every seed in [first_seed, first_seed + count)
+    // and puts the results in records, in seed order. Returns false,
+    // if the strategy doesn't exist.
+    bool run(std::uint32_t first_seed, std::uint32_t count,
+             int goal_exponent, std::vector<GameRecord>& records);
+
+    // Chooses the generator for the new tiles. The legacy one (default)
+    // plays the same games as the GUI, the fast one is faster.
+    void set_rng_mode(RngMode mode);
+
+    // Counts the games of the next runs in telemetry, with the name of
+    // the strategy as the source. nullptr (default) counts nothing.
+    void set_telemetry(Telemetry* telemetry);
+
+    // Number of threads used.
+    int threads() const;
+
+    // Wall clock time and the total number of moves of the last run.
+    double seconds() const;
+    std::uint64_t moves() const;
+
+private:
+    std::string strategy_;
+    int threads_;
+    RngMode rng_mode_;
+    Telemetry* telemetry_;
+    double seconds_;
+    std::uint64_t moves_;
+};
+
+#endif // BATCHRUNNER_HH
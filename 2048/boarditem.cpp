@@ -0,0 +1,100 @@
+#include "boarditem.hh"
+#include <QPainter>
+
+using namespace std;
+
+BoardItem::BoardItem(int boardSize, int slotSize, QGraphicsItem* parent)
+    : QGraphicsItem(parent)
+    , boardSize(boardSize)
+    , slotSize(slotSize)
+    , exponents(boardSize * boardSize, 0)
+{
+}
+
+void BoardItem::setAtlas(const TileAtlas* atlas)
+{
+    this->atlas = atlas;
+    update();
+}
+
+void BoardItem::setFallback(function<QPixmap(int)> fallback)
+{
+    this->fallback = fallback;
+    update();
+}
+
+void BoardItem::setAtlasEnabled(bool enabled)
+{
+    atlasEnabled = enabled;
+    update();
+}
+
+bool BoardItem::setBoard(GameBoard& board)
+{
+    bool changed = false;
+    for ( int y = 0; y < boardSize; ++y ) {
+        for ( int x = 0; x < boardSize; ++x ) {
+            int exponent = board.get_item(make_pair(y,x))->get_exponent();
+            if ( exponents.at(y * boardSize + x) != exponent ) {
+                exponents.at(y * boardSize + x) = exponent;
+                changed = true;
+            }
+        }
+    }
+    if ( changed ) {
+        update();
+    }
+    return changed;
+}
+
+bool BoardItem::setBoard(PackedBoard board)
+{
+    bool changed = false;
+    for ( int y = 0; y < boardSize; ++y ) {
+        for ( int x = 0; x < boardSize; ++x ) {
+            int exponent = packed::get_exponent(board, y, x);
+            if ( exponents.at(y * boardSize + x) != exponent ) {
+                exponents.at(y * boardSize + x) = exponent;
+                changed = true;
+            }
+        }
+    }
+    if ( changed ) {
+        update();
+    }
+    return changed;
+}
+
+void BoardItem::clear()
+{
+    exponents.assign(exponents.size(), 0);
+    update();
+}
+
+QRectF BoardItem::boundingRect() const
+{
+    return QRectF(0, 0, boardSize * slotSize, boardSize * slotSize);
+}
+
+void BoardItem::paint(QPainter* painter, const QStyleOptionGraphicsItem*,
+                      QWidget*)
+{
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    for ( int y = 0; y < boardSize; ++y ) {
+        for ( int x = 0; x < boardSize; ++x ) {
+            int exponent = exponents.at(y * boardSize + x);
+            if ( exponent == 0 ) {
+                continue;
+            }
+
+            // Copy the tile from the atlas if it is there
+            QRectF target(x * slotSize, y * slotSize, slotSize, slotSize);
+            if ( atlasEnabled && atlas && atlas->contains(exponent) ) {
+                painter->drawPixmap(target, atlas->pixmap(),
+                                    atlas->sourceRect(exponent));
+            } else if ( fallback ) {
+                painter->drawPixmap(target.topLeft(), fallback(exponent));
+            }
+        }
+    }
+}
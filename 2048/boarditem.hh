@@ -0,0 +1,60 @@
+/* BoardItem
+ *
+ * Draws the tiles of a game board as a single item of the scene. The
+ * tiles that are in the tile atlas are copied from it, the others are
+ * asked from the fallback function. Setting a board that is the same
+ * as the one shown doesn't repaint anything, so a scene with many
+ * boards only repaints the ones that changed.
+*/
+
+#ifndef BOARDITEM_HH
+#define BOARDITEM_HH
+
+#include "gameboard.hh"
+#include "packedboard.hh"
+#include "tileatlas.hh"
+#include <QGraphicsItem>
+#include <functional>
+#include <vector>
+
+class BoardItem : public QGraphicsItem
+{
+public:
+    // Constructor, the board has boardSize x boardSize tiles of
+    // slotSize x slotSize pixels
+    BoardItem(int boardSize, int slotSize, QGraphicsItem* parent = nullptr);
+
+    // Atlas used for the tiles, it must outlive the item
+    void setAtlas(const TileAtlas* atlas);
+
+    // Gives the picture of a tile that is not in the atlas
+    void setFallback(std::function<QPixmap(int exponent)> fallback);
+
+    // Uses only the fallback, for example when the tiles are drawn
+    void setAtlasEnabled(bool enabled);
+
+    // Shows the tiles of the given board. Returns true, if anything
+    // changed.
+    bool setBoard(GameBoard& board);
+    bool setBoard(PackedBoard board);
+
+    // Removes all the tiles
+    void clear();
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+               QWidget* widget) override;
+
+private:
+    int boardSize;
+    int slotSize;
+
+    // Exponents of the tiles shown, row by row
+    std::vector<int> exponents;
+
+    const TileAtlas* atlas = nullptr;
+    bool atlasEnabled = true;
+    std::function<QPixmap(int)> fallback;
+};
+
+#endif // BOARDITEM_HH
@@ -0,0 +1,604 @@
+/* numbers_cli
+ *
+ * Headless front end of the game. The first argument chooses
+ * the command, run without arguments to see them all.
+*/
+
+#include "framestream.hh"
+#include "gameboard.hh"
+#include "gameclient.hh"
+#include "gameserver.hh"
+#include "ntupletrainer.hh"
+#include "oracle.hh"
+#include "quantizedntuple.hh"
+#include "seedsweep.hh"
+#include "tablebasegenerator.hh"
+#include "terminalview.hh"
+#include "tournament.hh"
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+
+const size_t DEFAULT_MAX_SESSIONS = 1 << 20;
+const int DEFAULT_BENCHMARK_SESSIONS = 1000;
+const int DEFAULT_BENCHMARK_MOVES = 1000;
+
+// The seeds the GUI allows, 0..100000
+const int DEFAULT_SWEEP_SEEDS = 100001;
+const int DEFAULT_SWEEP_RUNS = 8;
+const int DEFAULT_SWEEP_TARGET = 9;
+const char DEFAULT_SWEEP_STRATEGY[] = "noisy-greedy";
+
+const long DEFAULT_ORACLE_CASES = 10000000;
+
+const char DEFAULT_RECORD_STRATEGY[] = "greedy";
+
+const long DEFAULT_TRAIN_GAMES = 100000;
+
+// 2048, as in the GUI
+const int DEFAULT_PLAY_TARGET = 11;
+
+// Targets of the games, PackedBoard doesn't merge two 2^15 tiles
+const int MIN_TARGET = 2;
+const int MAX_TARGET = MAX_PACKED_EXPONENT;
+const long DEFAULT_NTUPLE_EVALUATIONS = 10000000;
+
+GameServer* runningServer = nullptr;
+
+void stopServer(int)
+{
+    if ( runningServer != nullptr ) {
+        runningServer->stop();
+    }
+}
+
+void printUsage()
+{
+    cerr << "Usage: numbers_cli <command> [arguments]\n"
+         << "\n"
+         << "Commands:\n"
+         << "  serve <socket> [max sessions]\n"
+         << "      Runs the game server on the given Unix socket.\n"
+         << "  serve-bench <socket> [sessions] [moves]\n"
+         << "      Measures the round trip time and throughput of a"
+            " running server.\n"
+         << "  tournament <games> [--fast-rng] [--telemetry <prefix>]"
+            " [--processes <n>]\n"
+         << "             [strategy...]\n"
+         << "      Plays seeds 0..games-1 with every strategy and compares"
+            " them.\n"
+         << "      --fast-rng uses xoshiro256** for the new tiles instead"
+            " of the\n"
+         << "      generator of the GUI.\n"
+         << "      --telemetry writes the counters of every game to"
+            " <prefix>.prom\n"
+         << "      (Prometheus text format) and <prefix>.csv.\n"
+         << "      --processes plays the games in n worker processes,"
+            " each pinned to\n"
+         << "      its own cores, so that a crashing strategy only loses"
+            " its shard.\n"
+         << "      Strategies: random, greedy, noisy-greedy,"
+            " expectimax:<depth>,\n"
+         << "      expectimax:<depth>:tt<megabytes>,"
+            " anytime:<microseconds>[:tt<megabytes>],\n"
+         << "      ntuple:<file>, tablebase:<file>, plugin:<library>"
+            " (see numbers_strategy.h).\n"
+         << "      The :tt strategies share a transposition table of the"
+            " given size\n"
+         << "      between all the threads. anytime searches deeper"
+            " until the given\n"
+         << "      time per move is up and reports the depths reached.\n"
+         << "  sweep <index file> [seeds] [runs] [strategy] [target]\n"
+         << "      Plays every seed and writes how hard they are to the"
+            " index.\n"
+         << "      Run again to continue an interrupted sweep. The target"
+            " is 2^target\n"
+         << "      (2..15).\n"
+         << "  seed-info <index file> <seed>\n"
+         << "      Shows the difficulty of a seed.\n"
+         << "  oracle [cases] [seed] [threads]\n"
+         << "      Checks that the fast engines move like the original"
+            " game on\n"
+         << "      random and corner case boards, and shows a minimized"
+            " board for\n"
+         << "      every engine that differs.\n"
+         << "  train <file> [games] [threads] [learning rate]\n"
+         << "      Trains the n-tuple network in the file by self-play,"
+            " saving it\n"
+         << "      every " << DEFAULT_CHECKPOINT_SECONDS / 60
+         << " minutes. Continues from the file, if it exists,\n"
+         << "      and finishes a run that was stopped before starting"
+            " a new one.\n"
+         << "  ntuple-quantize <file> <quantized file>\n"
+         << "      Writes the weights of a trained network as 16 bit"
+            " integers.\n"
+         << "      ntuple:<quantized file> maps them instead of loading"
+            " them.\n"
+         << "  ntuple-bench <file> <quantized file> [evaluations]\n"
+         << "      Compares the load time, speed and moves of the two"
+            " networks.\n"
+         << "  record <file> <seed> [strategy]\n"
+         << "      Plays a game with the strategy and writes its moves as"
+            " a frame\n"
+         << "      stream, which the GUI plays back.\n"
+         << "  play [seed] [target]\n"
+         << "      Plays the game in the terminal for the target"
+            " 2^target (2..15).\n"
+         << "      Redraws only the changed tiles, for slow links such as"
+            " SSH.\n"
+         << "  tablebase <file> <size> <target>\n"
+         << "      Solves all size x size games for the target 2^target"
+            " exactly.\n"
+         << "  tablebase-probe <file> <value...>\n"
+         << "      Shows the win probability and the best move of a board,"
+            " given\n"
+         << "      as the values of the cells row by row, 0 for empty.\n";
+}
+
+// Returns the argument at the given index as an integer,
+// or the default if there is no such argument
+long argumentOr(int argc, char* argv[], int index, long defaultValue)
+{
+    return index < argc ? strtol(argv[index], nullptr, 10) : defaultValue;
+}
+
+int serve(int argc, char* argv[])
+{
+    if ( argc < 3 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    GameServer server(argv[2], argumentOr(argc, argv, 3,
+                                          DEFAULT_MAX_SESSIONS));
+    if ( !server.listen() ) {
+        return EXIT_FAILURE;
+    }
+
+    // Stop cleanly, so that the socket is removed
+    runningServer = &server;
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    signal(SIGPIPE, SIG_IGN);
+
+    server.run();
+    runningServer = nullptr;
+    server.print_statistics(cout);
+    return EXIT_SUCCESS;
+}
+
+int serveBench(int argc, char* argv[])
+{
+    if ( argc < 3 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    bool ok = run_server_benchmark(argv[2],
+                                   argumentOr(argc, argv, 3,
+                                              DEFAULT_BENCHMARK_SESSIONS),
+                                   argumentOr(argc, argv, 4,
+                                              DEFAULT_BENCHMARK_MOVES),
+                                   cout);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int tournament(int argc, char* argv[])
+{
+    if ( argc < 3 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    Tournament games(0, argumentOr(argc, argv, 2, 0));
+
+    // Use the default strategies if none are given
+    vector<string> names(argv + 3, argv + argc);
+    Telemetry telemetry;
+    string telemetryPrefix;
+    int processes = 0;
+    while ( !names.empty() && names.front().compare(0, 2, "--") == 0 ) {
+        string option = names.front();
+        names.erase(names.begin());
+        if ( option == "--fast-rng" ) {
+            games.set_rng_mode(FAST_RNG);
+            continue;
+        }
+        if ( names.empty()
+             || (option != "--telemetry" && option != "--processes") ) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+        if ( option == "--telemetry" ) {
+            telemetryPrefix = names.front();
+            games.set_telemetry(&telemetry);
+        } else {
+            processes = strtol(names.front().c_str(), nullptr, 10);
+            games.set_processes(processes);
+        }
+        names.erase(names.begin());
+    }
+    if ( processes < 0 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    if ( processes > 0 && !telemetryPrefix.empty() ) {
+        cerr << "Telemetry is only kept for games played in this process"
+             << endl;
+        return EXIT_FAILURE;
+    }
+    if ( names.empty() ) {
+        names = strategy_names();
+    }
+    for ( const string& name : names ) {
+        if ( !games.add_strategy(name) ) {
+            cerr << "Unknown strategy: " << name << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    bool ok = games.run(cerr);
+    games.print_report(cout);
+    print_shared_transposition_tables(cout);
+    print_search_statistics(cout);
+    if ( !telemetryPrefix.empty() ) {
+        if ( !telemetry.write_prometheus(telemetryPrefix + ".prom")
+             || !telemetry.write_csv(telemetryPrefix + ".csv") ) {
+            return EXIT_FAILURE;
+        }
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int sweep(int argc, char* argv[])
+{
+    if ( argc < 3 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    string strategy = argc > 5 ? argv[5] : DEFAULT_SWEEP_STRATEGY;
+    long target = argumentOr(argc, argv, 6, DEFAULT_SWEEP_TARGET);
+    if ( target < MIN_TARGET || target > MAX_TARGET ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    SeedSweep seedSweep(strategy, target,
+                        argumentOr(argc, argv, 4, DEFAULT_SWEEP_RUNS));
+    bool ok = seedSweep.run(argv[2], 0,
+                            argumentOr(argc, argv, 3, DEFAULT_SWEEP_SEEDS),
+                            cerr);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int seedInfo(int argc, char* argv[])
+{
+    if ( argc < 4 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    SeedIndex index;
+    if ( !index.open(argv[2]) ) {
+        cerr << "Not a seed index: " << argv[2] << endl;
+        return EXIT_FAILURE;
+    }
+    const SeedRecord* record = index.find(argumentOr(argc, argv, 3, 0));
+    if ( record == nullptr ) {
+        cerr << "The seed hasn't been played" << endl;
+        return EXIT_FAILURE;
+    }
+    cout << "win rate: " << 100.0 * win_rate(*record) << "% of "
+         << record->runs << " games with target 2^"
+         << index.header().target_exponent << " ("
+         << index.header().strategy << ")" << endl;
+    cout << "mean moves: " << record->mean_moves << endl;
+    cout << "opening:" << endl;
+    for ( int y = 0; y < SIZE; ++y ) {
+        for ( int x = 0; x < SIZE; ++x ) {
+            int exponent = packed::get_exponent(record->opening, y, x);
+            cout << "|" << setw(PRINT_WIDTH - 1)
+                 << (exponent == 0 ? 0 : 1 << exponent);
+        }
+        cout << "|" << endl;
+    }
+    return EXIT_SUCCESS;
+}
+
+int tablebase(int argc, char* argv[])
+{
+    if ( argc < 5 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    TablebaseGenerator generator(argumentOr(argc, argv, 3, 0),
+                                 argumentOr(argc, argv, 4, 0));
+    return generator.run(argv[2], cerr) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int tablebaseProbe(int argc, char* argv[])
+{
+    if ( argc < 3 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    Tablebase table;
+    if ( !table.open(argv[2]) ) {
+        cerr << "Not a tablebase: " << argv[2] << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Read the values of the cells as exponents
+    int size = table.header().size;
+    if ( argc != 3 + size * size ) {
+        cerr << "The board needs " << size * size << " values" << endl;
+        return EXIT_FAILURE;
+    }
+    CompactBoard board(size);
+    for ( int i = 0; i < size * size; ++i ) {
+        long value = argumentOr(argc, argv, 3 + i, 0);
+        int exponent = 0;
+        while ( value > 1 ) {
+            value /= 2;
+            ++exponent;
+        }
+        board.set_exponent(i / size, i % size, exponent);
+    }
+
+    TablebaseAnswer answer;
+    if ( !table.lookup(board, answer) ) {
+        cerr << "The board has a tile at or above the target" << endl;
+        return EXIT_FAILURE;
+    }
+    const char* const names[] = {"up", "right", "down", "left"};
+    cout << "win probability: " << answer.win_probability << endl;
+    cout << "best move: " << names[answer.best] << endl;
+    return EXIT_SUCCESS;
+}
+
+int train(int argc, char* argv[])
+{
+    if ( argc < 3 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    NTupleNetwork network;
+    if ( ifstream(argv[2]).good() ) {
+        if ( !network.load(argv[2]) ) {
+            cerr << "Not an n-tuple network: " << argv[2] << endl;
+            return EXIT_FAILURE;
+        }
+        cerr << "Continuing after " << network.games() << " games" << endl;
+    }
+    double rate = argc > 5 ? strtod(argv[5], nullptr)
+                           : DEFAULT_LEARNING_RATE;
+    NTupleTrainer trainer(network, argumentOr(argc, argv, 4, 0), rate);
+    bool ok = trainer.run(argumentOr(argc, argv, 3, DEFAULT_TRAIN_GAMES),
+                          argv[2], DEFAULT_CHECKPOINT_SECONDS, cerr);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int ntupleQuantize(int argc, char* argv[])
+{
+    if ( argc < 4 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    NTupleNetwork network;
+    if ( !network.load(argv[2]) ) {
+        cerr << "Not an n-tuple network: " << argv[2] << endl;
+        return EXIT_FAILURE;
+    }
+    bool ok = QuantizedNTuple::write(network, argv[3]);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int ntupleBench(int argc, char* argv[])
+{
+    if ( argc < 4 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    bool ok = run_ntuple_benchmark(argv[2], argv[3],
+                                   argumentOr(argc, argv, 4,
+                                              DEFAULT_NTUPLE_EVALUATIONS),
+                                   cout);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int record(int argc, char* argv[])
+{
+    if ( argc < 4 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    string name = argc > 4 ? argv[4] : DEFAULT_RECORD_STRATEGY;
+    unique_ptr<Strategy> strategy = create_strategy(name);
+    if ( !strategy ) {
+        cerr << "Unknown strategy: " << name << endl;
+        return EXIT_FAILURE;
+    }
+
+    // The game goes on until it is lost, like in a tournament
+    uint32_t seed = argumentOr(argc, argv, 3, 0);
+    PackedGame game;
+    game.start(seed, NO_GOAL);
+    strategy->start_game(seed);
+    FrameStreamWriter writer;
+    if ( !writer.open(argv[2], seed, NO_GOAL, LEGACY_RNG, game.board()) ) {
+        return EXIT_FAILURE;
+    }
+    while ( game.state() == PLAYING ) {
+        Direction dir = UP;
+        strategy->choose(game.board(), dir);
+        dir = legal_move(game.board(), dir);
+        game.step(dir);
+        writer.add(dir, game.board(), game.score(), game.rng());
+    }
+    writer.finish(game.state());
+
+    cout << writer.frames() << " moves, " << game.score() << " points, "
+         << writer.bytes() << " bytes, " << fixed << setprecision(2)
+         << double(writer.bytes()) / max<uint32_t>(1, writer.frames())
+         << " bytes per move" << endl;
+    return EXIT_SUCCESS;
+}
+
+int oracle(int argc, char* argv[])
+{
+    Oracle check(argumentOr(argc, argv, 3, 0),
+                 argumentOr(argc, argv, 4, 0));
+    bool ok = check.run(argumentOr(argc, argv, 2, DEFAULT_ORACLE_CASES));
+    check.print_report(cout);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Status line of the terminal game
+string playStatus(int seed, uint64_t score, int moves, GameState state)
+{
+    string status = "Seed " + to_string(seed) + "  Score "
+                    + to_string(score) + "  Moves " + to_string(moves)
+                    + "  ";
+    if ( state == WON ) {
+        return status + "You won! n: next game, q: quit";
+    } else if ( state == LOST ) {
+        return status + "Game over. n: next game, q: quit";
+    }
+    return status + "Arrows/WASD: move, n: next game, q: quit";
+}
+
+int play(int argc, char* argv[])
+{
+    int seed = argumentOr(argc, argv, 2, 0);
+    long target = argumentOr(argc, argv, 3, DEFAULT_PLAY_TARGET);
+    if ( target < MIN_TARGET || target > MAX_TARGET ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    int goal = 1 << target;
+    GameBoard board;
+    board.init_empty();
+    board.fill(seed);
+    TerminalView view(board);
+    if ( !view.open() ) {
+        return EXIT_FAILURE;
+    }
+
+    uint64_t score = 0;
+    uint64_t largestTile = 0;
+    int moves = 0;
+    GameState state = PLAYING;
+    view.draw_all(playStatus(seed, score, moves, state));
+
+    // All the keys of one read make one frame
+    vector<TerminalKey> keys;
+    bool quit = false;
+    while ( !quit && view.read_keys(keys) ) {
+        bool newGame = false;
+        for ( TerminalKey key : keys ) {
+            if ( key == TERMINAL_QUIT ) {
+                quit = true;
+                break;
+            } else if ( key == TERMINAL_NEXT_GAME ) {
+                board.clear_game();
+                board.fill(++seed);
+                score = 0;
+                largestTile = 0;
+                moves = 0;
+                state = PLAYING;
+                newGame = true;
+                continue;
+            } else if ( state != PLAYING ) {
+                continue;
+            }
+
+            // The rules of the GUI: a move that changes nothing doesn't
+            // count, and the game is lost when the new value leaves no
+            // move that changes the board
+            MoveResult result =
+                    board.move(packed::to_coords(Direction(key)), goal);
+            if ( !result.moved ) {
+                continue;
+            }
+            ++moves;
+            if ( result.won ) {
+                state = WON;
+                continue;
+            }
+
+            // The score of the GUI too: every move adds the largest
+            // tile so far, the winning move nothing
+            largestTile = max(largestTile, uint64_t(1) << result.max_exponent);
+            score += largestTile;
+            board.new_value();
+            if ( board.is_full() ) {
+                PackedBoard packed = packed::from_game_board(board);
+                bool stuck = true;
+                for ( int dir = 0; stuck && dir < DIRECTION_COUNT; ++dir ) {
+                    stuck = packed::move(packed, Direction(dir)).board
+                            == packed;
+                }
+                if ( stuck ) {
+                    state = LOST;
+                }
+            }
+        }
+        string status = playStatus(seed, score, moves, state);
+        if ( newGame ) {
+            view.draw_all(status);
+        } else {
+            view.draw_changes(status);
+        }
+    }
+    view.close();
+
+    cout << view.frames() << " frames, " << view.bytes() << " bytes, " << fixed
+         << setprecision(1)
+         << double(view.bytes()) / max<uint64_t>(1, view.frames())
+         << " bytes/frame" << endl;
+    return EXIT_SUCCESS;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    if ( argc < 2 ) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    string command = argv[1];
+    if ( command == "serve" ) {
+        return serve(argc, argv);
+    } else if ( command == "serve-bench" ) {
+        return serveBench(argc, argv);
+    } else if ( command == "tournament" ) {
+        return tournament(argc, argv);
+    } else if ( command == "sweep" ) {
+        return sweep(argc, argv);
+    } else if ( command == "seed-info" ) {
+        return seedInfo(argc, argv);
+    } else if ( command == "oracle" ) {
+        return oracle(argc, argv);
+    } else if ( command == "train" ) {
+        return train(argc, argv);
+    } else if ( command == "ntuple-quantize" ) {
+        return ntupleQuantize(argc, argv);
+    } else if ( command == "ntuple-bench" ) {
+        return ntupleBench(argc, argv);
+    } else if ( command == "record" ) {
+        return record(argc, argv);
+    } else if ( command == "play" ) {
+        return play(argc, argv);
+    } else if ( command == "tablebase" ) {
+        return tablebase(argc, argv);
+    } else if ( command == "tablebase-probe" ) {
+        return tablebaseProbe(argc, argv);
+    }
+    printUsage();
+    return EXIT_FAILURE;
+}
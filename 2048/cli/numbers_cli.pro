@@ -0,0 +1,77 @@
+# Headless build of the game: the server, the benchmarks and the
+# other tools that don't need a display.
+
+TEMPLATE = app
+TARGET = numbers_cli
+
+QT -= core gui
+CONFIG += console c++11 thread
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    ../batchrunner.cpp \
+    ../compactboard.cpp \
+    ../framestream.cpp \
+    ../gameboard.cpp \
+    ../gameclient.cpp \
+    ../gameserver.cpp \
+    ../ntuple.cpp \
+    ../ntupletrainer.cpp \
+    ../numbertile.cpp \
+    ../oracle.cpp \
+    ../packedboard.cpp \
+    ../packedgame.cpp \
+    ../protocol.cpp \
+    ../quantizedntuple.cpp \
+    ../rng.cpp \
+    ../seedindex.cpp \
+    ../seedsweep.cpp \
+    ../shardedrunner.cpp \
+    ../strategy.cpp \
+    ../strategyplugin.cpp \
+    ../symmetry.cpp \
+    ../tablebase.cpp \
+    ../tablebasegenerator.cpp \
+    ../telemetry.cpp \
+    ../terminalview.cpp \
+    ../tournament.cpp \
+    ../transpositiontable.cpp
+
+HEADERS += \
+    ../batchrunner.hh \
+    ../compactboard.hh \
+    ../framestream.hh \
+    ../gameboard.hh \
+    ../gameclient.hh \
+    ../gameserver.hh \
+    ../ntuple.hh \
+    ../ntupletrainer.hh \
+    ../numbers_strategy.h \
+    ../numbertile.hh \
+    ../oracle.hh \
+    ../packedboard.hh \
+    ../packedgame.hh \
+    ../protocol.hh \
+    ../quantizedntuple.hh \
+    ../rng.hh \
+    ../seedindex.hh \
+    ../seedsweep.hh \
+    ../shardedrunner.hh \
+    ../strategy.hh \
+    ../strategyplugin.hh \
+    ../symmetry.hh \
+    ../tablebase.hh \
+    ../tablebasegenerator.hh \
+    ../telemetry.hh \
+    ../terminalview.hh \
+    ../tournament.hh \
+    ../transpositiontable.hh
+
+# The strategy plugins are loaded with dlopen
+unix: LIBS += -ldl
+
+unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
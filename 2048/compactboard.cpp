@@ -0,0 +1,156 @@
+#include "compactboard.hh"
+#include "gameboard.hh"
+#include <limits>
+
+static_assert(sizeof(CompactBoard) == MAX_COMPACT_SIZE * MAX_COMPACT_SIZE + 1,
+              "Unexpected board size");
+
+namespace
+{
+
+// Values of 2^64 and more don't fit in the score
+const int MAX_SCORE_EXPONENT = 63;
+
+}
+
+CompactBoard::CompactBoard(int size):
+    cells_(), size_(size)
+{
+}
+
+CompactBoard CompactBoard::from_game_board(GameBoard& board)
+{
+    CompactBoard result(board.size());
+    for( int y = 0; y < result.size_; ++y )
+    {
+        for( int x = 0; x < result.size_; ++x )
+        {
+            result.set_exponent(y, x, board.get_item(std::make_pair(y, x))
+                                           ->get_exponent());
+        }
+    }
+    return result;
+}
+
+int CompactBoard::size() const
+{
+    return size_;
+}
+
+int CompactBoard::get_exponent(int y, int x) const
+{
+    return cells_[y * size_ + x];
+}
+
+void CompactBoard::set_exponent(int y, int x, int exponent)
+{
+    cells_[y * size_ + x] = exponent;
+}
+
+CompactMove CompactBoard::move(Direction dir)
+{
+    CompactMove result = {false, 0, 0};
+    for( int i = 0; i < size_; ++i )
+    {
+        // The first cell of the line is the one nearest to the wall
+        switch( dir )
+        {
+        case UP:
+            move_line(&cells_[i], size_, result);
+            break;
+        case DOWN:
+            move_line(&cells_[(size_ - 1) * size_ + i], -size_, result);
+            break;
+        case LEFT:
+            move_line(&cells_[i * size_], 1, result);
+            break;
+        default:
+            move_line(&cells_[i * size_ + size_ - 1], -1, result);
+            break;
+        }
+    }
+    return result;
+}
+
+int CompactBoard::count_empty() const
+{
+    int count = 0;
+    for( int i = 0; i < size_ * size_; ++i )
+    {
+        if( cells_[i] == 0 )
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int CompactBoard::max_exponent() const
+{
+    int result = 0;
+    for( std::uint8_t cell : cells_ )
+    {
+        if( cell > result )
+        {
+            result = cell;
+        }
+    }
+    return result;
+}
+
+bool CompactBoard::operator==(const CompactBoard& other) const
+{
+    return size_ == other.size_ and cells_ == other.cells_;
+}
+
+bool CompactBoard::operator!=(const CompactBoard& other) const
+{
+    return not (*this == other);
+}
+
+void CompactBoard::move_line(std::uint8_t* line, int step,
+                             CompactMove& result)
+{
+    // Same as NumberTile::move: the tile nearest to the wall goes
+    // first, and a merged tile can not merge again
+    int count = 0;
+    bool last_merged = false;
+    for( int i = 0; i < size_; ++i )
+    {
+        int value = line[i * step];
+        if( value == 0 )
+        {
+            continue;
+        }
+        line[i * step] = 0;
+        if( count > 0 and not last_merged and
+            line[(count - 1) * step] == value and
+            value < MAX_COMPACT_EXPONENT )
+        {
+            line[(count - 1) * step] = value + 1;
+            last_merged = true;
+            result.moved = true;
+            if( value + 1 > result.max_merged_exponent )
+            {
+                result.max_merged_exponent = value + 1;
+            }
+            std::uint64_t points = value + 1 <= MAX_SCORE_EXPONENT ?
+                        std::uint64_t(1) << (value + 1) :
+                        std::numeric_limits<std::uint64_t>::max();
+            result.score = points > std::numeric_limits<std::uint64_t>::max()
+                                    - result.score ?
+                        std::numeric_limits<std::uint64_t>::max() :
+                        result.score + points;
+        }
+        else
+        {
+            line[count * step] = value;
+            last_merged = false;
+            if( count != i )
+            {
+                result.moved = true;
+            }
+            ++count;
+        }
+    }
+}
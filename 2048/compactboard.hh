@@ -0,0 +1,88 @@
+/* CompactBoard
+ *
+ * A game board of up to 8x8 tiles, with every tile stored as its
+ * exponent in one byte (0 is an empty tile, 1 is 2, 2 is 4 and so on).
+ * The cells are kept in the object itself, so a board of any size
+ * takes 65 bytes and no allocation, and millions of them can be kept
+ * in a plain vector. Tiles up to 2^255 can be stored, so it can hold
+ * the states of long games on large boards where PackedBoard, which is
+ * limited to 4x4 and 2^15, can not.
+ *
+ * Moves follow the same rules as NumberTile::move: tiles slide as far
+ * as possible and every tile can merge at most once per move. Two
+ * 2^255 tiles are treated as unmergeable.
+ *
+ * Cell (y, x) is stored in the byte y * size + x.
+*/
+
+#ifndef COMPACTBOARD_HH
+#define COMPACTBOARD_HH
+
+#include "packedboard.hh"
+#include <array>
+#include <cstdint>
+
+class GameBoard;
+
+// The largest exponent that fits in a byte
+const int MAX_COMPACT_EXPONENT = 255;
+
+// Number of tiles on a side of the largest board
+const int MAX_COMPACT_SIZE = 8;
+
+// Result of moving a compact board
+struct CompactMove
+{
+    // True, if any tile moved or merged
+    bool moved;
+
+    // The largest exponent produced by a merge, 0 if nothing merged
+    int max_merged_exponent;
+
+    // Sum of the values of the merged tiles, saturates at the largest
+    // 64 bit value
+    std::uint64_t score;
+};
+
+class CompactBoard
+{
+public:
+    // Constructor, an empty size x size board, size at most
+    // MAX_COMPACT_SIZE
+    explicit CompactBoard(int size = 4);
+
+    // Reads the current state of the given gameboard.
+    static CompactBoard from_game_board(GameBoard& board);
+
+    // Number of tiles on a side
+    int size() const;
+
+    // Returns the exponent in the given cell.
+    int get_exponent(int y, int x) const;
+
+    // Sets the exponent in the given cell.
+    void set_exponent(int y, int x, int exponent);
+
+    // Moves the board in the given direction, without a new tile.
+    CompactMove move(Direction dir);
+
+    // Returns the number of empty cells.
+    int count_empty() const;
+
+    // Returns the largest exponent on the board.
+    int max_exponent() const;
+
+    bool operator==(const CompactBoard& other) const;
+    bool operator!=(const CompactBoard& other) const;
+
+private:
+    // The cells after the first size * size are always empty
+    std::array<std::uint8_t, MAX_COMPACT_SIZE * MAX_COMPACT_SIZE> cells_;
+    std::uint8_t size_;
+
+    // Slides and merges one line of cells towards its first cell. The
+    // cells are line[0], line[step], line[2 * step] ...
+    void move_line(std::uint8_t* line, int step, CompactMove& result);
+};
+
+#endif // COMPACTBOARD_HH
@@ -0,0 +1,131 @@
+#include "numbers_env.h"
+#include "packedgame.hh"
+#include <new>
+#include <vector>
+
+static_assert(NUMBERS_ENV_PLAYING == PLAYING and NUMBERS_ENV_WON == WON and
+              NUMBERS_ENV_LOST == LOST, "Unexpected game states");
+static_assert(NUMBERS_ENV_LEGACY_RNG == LEGACY_RNG and
+              NUMBERS_ENV_FAST_RNG == FAST_RNG, "Unexpected generators");
+
+struct numbers_env
+{
+    std::vector<PackedGame> games;
+    int goal_exponent;
+    RngMode mode;
+};
+
+std::uint32_t numbers_env_abi_version(void)
+{
+    return NUMBERS_ENV_ABI_VERSION;
+}
+
+numbers_env* numbers_env_create(std::uint32_t count,
+                                std::uint32_t goal_exponent,
+                                std::uint32_t rng)
+{
+    if( count == 0 or goal_exponent > MAX_PACKED_EXPONENT or
+        rng > NUMBERS_ENV_FAST_RNG )
+    {
+        return nullptr;
+    }
+
+    // No exception may get through to the caller
+    numbers_env* env = new(std::nothrow) numbers_env;
+    if( env == nullptr )
+    {
+        return nullptr;
+    }
+    try
+    {
+        env->games.resize(count);
+    }
+    catch( const std::bad_alloc& )
+    {
+        delete env;
+        return nullptr;
+    }
+    env->goal_exponent = goal_exponent;
+    env->mode = RngMode(rng);
+    return env;
+}
+
+void numbers_env_destroy(numbers_env* env)
+{
+    delete env;
+}
+
+std::uint32_t numbers_env_count(const numbers_env* env)
+{
+    return env->games.size();
+}
+
+void numbers_env_reset(numbers_env* env, const std::uint32_t* seeds,
+                       const std::uint8_t* mask, std::uint64_t* boards)
+{
+    std::size_t count = env->games.size();
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        if( mask == nullptr or mask[i] != 0 )
+        {
+            env->games[i].start(seeds[i], env->goal_exponent, env->mode);
+        }
+        boards[i] = env->games[i].board();
+    }
+}
+
+void numbers_env_step(numbers_env* env, const std::uint8_t* actions,
+                      std::uint64_t* boards, float* rewards,
+                      std::uint8_t* states)
+{
+    std::size_t count = env->games.size();
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        PackedGame& game = env->games[i];
+        Direction dir = actions[i] < DIRECTION_COUNT ?
+                    Direction(actions[i]) : UP;
+        std::uint32_t score = game.score();
+        states[i] = game.step(dir);
+        boards[i] = game.board();
+        rewards[i] = float(game.score() - score);
+    }
+}
+
+void numbers_env_legal_actions(const numbers_env* env, std::uint8_t* masks)
+{
+    std::size_t count = env->games.size();
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        const PackedGame& game = env->games[i];
+        std::uint8_t mask = 0;
+        if( game.state() == PLAYING )
+        {
+            PackedBoard board = game.board();
+            for( int d = 0; d < DIRECTION_COUNT; ++d )
+            {
+                if( packed::move(board, Direction(d)).board != board )
+                {
+                    mask |= 1u << d;
+                }
+            }
+        }
+        masks[i] = mask;
+    }
+}
+
+void numbers_env_scores(const numbers_env* env, std::uint32_t* scores,
+                        std::uint32_t* moves)
+{
+    std::size_t count = env->games.size();
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        if( scores != nullptr )
+        {
+            scores[i] = env->games[i].score();
+        }
+        if( moves != nullptr )
+        {
+            moves[i] = env->games[i].moves();
+        }
+    }
+}
@@ -0,0 +1,99 @@
+/* numbers_env.h
+ *
+ * The C interface of libnumbers_env, a batch of games stepped
+ * together for reinforcement learning, usable from any language that
+ * can call C (ctypes, cffi, JNI, ...).
+ *
+ * The games follow the rules of the GUI exactly: a seed gives the same
+ * opening and the same new tiles as in the GUI, and a move that
+ * doesn't change the board is ignored, as it is there.
+ *
+ * All the arrays are owned by the caller and have one element per
+ * game; the library only reads and writes them during the call. The
+ * boards are packed as in numbers_strategy.h: one nibble per cell,
+ * cell (y, x) in bits 4 * (4 * y + x) .. + 3, holding the exponent of
+ * the tile. The actions are 0 up, 1 right, 2 down, 3 left.
+ *
+ * An environment is not thread safe: use one per thread, they share
+ * nothing.
+*/
+
+#ifndef NUMBERS_ENV_H
+#define NUMBERS_ENV_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUMBERS_ENV_ABI_VERSION 1
+
+#if defined(_WIN32)
+#define NUMBERS_ENV_EXPORT __declspec(dllexport)
+#else
+#define NUMBERS_ENV_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* The states of a game, as written by numbers_env_step */
+#define NUMBERS_ENV_PLAYING 0
+#define NUMBERS_ENV_WON 1
+#define NUMBERS_ENV_LOST 2
+
+/* The generators of the new tiles: the one of the GUI, and xoshiro256**
+ * that is faster but plays other games for the same seeds */
+#define NUMBERS_ENV_LEGACY_RNG 0
+#define NUMBERS_ENV_FAST_RNG 1
+
+typedef struct numbers_env numbers_env;
+
+/* Returns NUMBERS_ENV_ABI_VERSION of the library. */
+NUMBERS_ENV_EXPORT uint32_t numbers_env_abi_version(void);
+
+/* Creates count games, that are won when a merge makes the tile
+ * 2^goal_exponent (0 plays until the game is lost). Returns NULL, if
+ * an argument is out of range. The games must be reset before they
+ * are stepped. */
+NUMBERS_ENV_EXPORT numbers_env* numbers_env_create(uint32_t count,
+                                                   uint32_t goal_exponent,
+                                                   uint32_t rng);
+
+NUMBERS_ENV_EXPORT void numbers_env_destroy(numbers_env* env);
+
+NUMBERS_ENV_EXPORT uint32_t numbers_env_count(const numbers_env* env);
+
+/* Starts game i with seeds[i], for every game whose mask[i] is not 0,
+ * or for every game if mask is NULL, and writes the boards of all the
+ * games. */
+NUMBERS_ENV_EXPORT void numbers_env_reset(numbers_env* env,
+                                          const uint32_t* seeds,
+                                          const uint8_t* mask,
+                                          uint64_t* boards);
+
+/* Makes the move actions[i] in game i, an action above 3 is taken as
+ * up. Writes the board after the move and the new tile, the points of
+ * the merges as the reward, and the state of the game. An action that
+ * doesn't change the board leaves the game as it was, with no reward,
+ * or loses it if no action changes the board. A game that has ended
+ * stays as it was, with no reward, until it is reset. */
+NUMBERS_ENV_EXPORT void numbers_env_step(numbers_env* env,
+                                         const uint8_t* actions,
+                                         uint64_t* boards, float* rewards,
+                                         uint8_t* states);
+
+/* Writes for every game the moves that change its board: bit d is set,
+ * if the action d does. A game that has ended gets 0. */
+NUMBERS_ENV_EXPORT void numbers_env_legal_actions(const numbers_env* env,
+                                                  uint8_t* masks);
+
+/* Writes the score and the number of moves of every game. Either
+ * array may be NULL. */
+NUMBERS_ENV_EXPORT void numbers_env_scores(const numbers_env* env,
+                                           uint32_t* scores,
+                                           uint32_t* moves);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NUMBERS_ENV_H */
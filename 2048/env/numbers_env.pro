@@ -0,0 +1,33 @@
+# Shared library of games stepped in batches for reinforcement
+# learning, see numbers_env.h. Only the functions of numbers_env.h are
+# exported.
+
+TEMPLATE = lib
+TARGET = numbers_env
+
+QT -= core gui
+CONFIG += c++11 shared
+CONFIG -= qt
+
+QMAKE_CXXFLAGS += -fvisibility=hidden
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    numbers_env.cpp \
+    ../gameboard.cpp \
+    ../numbertile.cpp \
+    ../packedboard.cpp \
+    ../packedgame.cpp \
+    ../rng.cpp
+
+HEADERS += \
+    numbers_env.h \
+    ../gameboard.hh \
+    ../numbertile.hh \
+    ../packedboard.hh \
+    ../packedgame.hh \
+    ../rng.hh
+
+unix:!android: target.path = /opt/$${TARGET}/lib
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,588 @@
+#include "framestream.hh"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+const int CELLS = 16;
+
+// A frame is at most this long: direction, mask, 8 bytes of nibbles
+// and a varint of 32 bits
+const std::size_t MAX_FRAME_SIZE = 1 + 2 + CELLS / 2 + 5;
+
+// Size of a keyframe after its tag
+const std::size_t KEYFRAME_SIZE = 4 + 4 + 8 + 4 * 8;
+
+int count_bits(std::uint32_t mask)
+{
+    int count = 0;
+    for( ; mask != 0; mask &= mask - 1 )
+    {
+        ++count;
+    }
+    return count;
+}
+
+// Little endian numbers
+void put_number(std::vector<unsigned char>& buffer, std::uint64_t value,
+                int bytes)
+{
+    for( int i = 0; i < bytes; ++i )
+    {
+        buffer.push_back((value >> (8 * i)) & 0xFF);
+    }
+}
+
+std::uint64_t get_number(const unsigned char* data, int bytes)
+{
+    std::uint64_t value = 0;
+    for( int i = 0; i < bytes; ++i )
+    {
+        value |= std::uint64_t(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+void put_header(std::vector<unsigned char>& buffer,
+                const FrameStreamHeader& header)
+{
+    buffer.insert(buffer.end(), header.magic,
+                  header.magic + sizeof(header.magic));
+    put_number(buffer, header.version, 4);
+    put_number(buffer, header.seed, 4);
+    put_number(buffer, header.goal_exponent, 4);
+    put_number(buffer, header.rng_mode, 4);
+    put_number(buffer, header.opening, 8);
+    put_number(buffer, header.keyframe_interval, 4);
+    buffer.insert(buffer.end(), header.reserved,
+                  header.reserved + sizeof(header.reserved));
+}
+
+FrameStreamHeader get_header(const unsigned char* data)
+{
+    FrameStreamHeader header;
+    std::memcpy(header.magic, data, sizeof(header.magic));
+    header.version = get_number(data + 8, 4);
+    header.seed = get_number(data + 12, 4);
+    header.goal_exponent = get_number(data + 16, 4);
+    header.rng_mode = get_number(data + 20, 4);
+    header.opening = get_number(data + 24, 8);
+    header.keyframe_interval = get_number(data + 32, 4);
+    std::memcpy(header.reserved, data + 36, sizeof(header.reserved));
+    return header;
+}
+
+}
+
+FrameStreamWriter::FrameStreamWriter():
+    file_(nullptr), mode_(LEGACY_RNG), keyframe_interval_(0), board_(0),
+    score_(0), frames_(0), bytes_(0)
+{
+    buffer_.reserve(MAX_FRAME_SIZE + 1 + KEYFRAME_SIZE);
+}
+
+FrameStreamWriter::~FrameStreamWriter()
+{
+    if( file_ != nullptr )
+    {
+        std::fclose(file_);
+    }
+}
+
+bool FrameStreamWriter::open(const std::string& path, std::uint32_t seed,
+                             int goal_exponent, RngMode mode,
+                             PackedBoard opening,
+                             std::uint32_t keyframe_interval)
+{
+    if( file_ != nullptr )
+    {
+        std::fclose(file_);
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if( file_ == nullptr )
+    {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    FrameStreamHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, FRAME_STREAM_MAGIC, sizeof(header.magic));
+    header.version = FRAME_STREAM_VERSION;
+    header.seed = seed;
+    header.goal_exponent = goal_exponent;
+    header.rng_mode = mode;
+    header.opening = opening;
+    header.keyframe_interval = keyframe_interval;
+    buffer_.clear();
+    put_header(buffer_, header);
+    if( std::fwrite(buffer_.data(), buffer_.size(), 1, file_) != 1 )
+    {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    mode_ = mode;
+    keyframe_interval_ = keyframe_interval;
+    board_ = opening;
+    score_ = 0;
+    frames_ = 0;
+    bytes_ = sizeof(header);
+    index_.clear();
+    return true;
+}
+
+bool FrameStreamWriter::is_open() const
+{
+    return file_ != nullptr;
+}
+
+void FrameStreamWriter::add(Direction dir, PackedBoard board,
+                            std::uint32_t score, const SpawnRng& rng)
+{
+    if( file_ == nullptr )
+    {
+        return;
+    }
+
+    // Mark every nibble that differs
+    PackedBoard changed = board ^ board_;
+    std::uint32_t mask = 0;
+    for( int c = 0; c < CELLS; ++c )
+    {
+        if( (changed >> (4 * c)) & 0xF )
+        {
+            mask |= 1u << c;
+        }
+    }
+
+    buffer_.clear();
+    buffer_.push_back(dir);
+    buffer_.push_back(mask & 0xFF);
+    buffer_.push_back(mask >> 8);
+    int nibbles = 0;
+    for( int c = 0; c < CELLS; ++c )
+    {
+        if( not (mask & (1u << c)) )
+        {
+            continue;
+        }
+        unsigned char exponent = (board >> (4 * c)) & 0xF;
+        if( nibbles % 2 == 0 )
+        {
+            buffer_.push_back(exponent);
+        }
+        else
+        {
+            buffer_.back() |= exponent << 4;
+        }
+        ++nibbles;
+    }
+    std::uint32_t difference = score - score_;
+    while( difference >= 0x80 )
+    {
+        buffer_.push_back((difference & 0x7F) | 0x80);
+        difference >>= 7;
+    }
+    buffer_.push_back(difference);
+    board_ = board;
+    score_ = score;
+    ++frames_;
+
+    // The keyframe goes in the same write as the frame before it
+    if( keyframe_interval_ > 0 and frames_ % keyframe_interval_ == 0 )
+    {
+        IndexEntry entry;
+        entry.move = frames_;
+        entry.reserved = 0;
+        entry.offset = bytes_ + buffer_.size();
+        index_.push_back(entry);
+
+        std::uint64_t rng_state[4] = {0, 0, 0, 0};
+        if( mode_ == LEGACY_RNG )
+        {
+            rng_state[0] = rng.legacy().state();
+        }
+        else
+        {
+            rng.fast().get_state(rng_state);
+        }
+        buffer_.push_back(FRAME_STREAM_KEYFRAME);
+        put_number(buffer_, frames_, 4);
+        put_number(buffer_, score_, 4);
+        put_number(buffer_, board_, 8);
+        for( int i = 0; i < 4; ++i )
+        {
+            put_number(buffer_, rng_state[i], 8);
+        }
+    }
+
+    std::fwrite(buffer_.data(), buffer_.size(), 1, file_);
+    bytes_ += buffer_.size();
+}
+
+void FrameStreamWriter::flush()
+{
+    if( file_ != nullptr )
+    {
+        std::fflush(file_);
+    }
+}
+
+void FrameStreamWriter::finish(GameState state)
+{
+    if( file_ == nullptr )
+    {
+        return;
+    }
+    buffer_.clear();
+    buffer_.push_back(FRAME_STREAM_END);
+    buffer_.push_back(state);
+    for( const IndexEntry& entry : index_ )
+    {
+        put_number(buffer_, entry.move, 4);
+        put_number(buffer_, entry.reserved, 4);
+        put_number(buffer_, entry.offset, 8);
+    }
+    put_number(buffer_, index_.size(), 4);
+    put_number(buffer_, frames_, 4);
+    buffer_.insert(buffer_.end(), FRAME_INDEX_MAGIC,
+                   FRAME_INDEX_MAGIC + sizeof(FRAME_INDEX_MAGIC));
+    std::fwrite(buffer_.data(), buffer_.size(), 1, file_);
+    bytes_ += buffer_.size();
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+std::uint32_t FrameStreamWriter::frames() const
+{
+    return frames_;
+}
+
+std::uint64_t FrameStreamWriter::bytes() const
+{
+    return bytes_;
+}
+
+FrameStreamReader::FrameStreamReader():
+    file_(nullptr), header_(), current_(), keyframe_(), moves_(0),
+    finished_(false), final_state_(PLAYING)
+{
+}
+
+FrameStreamReader::~FrameStreamReader()
+{
+    if( file_ != nullptr )
+    {
+        std::fclose(file_);
+    }
+}
+
+bool FrameStreamReader::open(const std::string& path)
+{
+    if( file_ != nullptr )
+    {
+        std::fclose(file_);
+    }
+    file_ = std::fopen(path.c_str(), "rb");
+    if( file_ == nullptr )
+    {
+        return false;
+    }
+    unsigned char data[sizeof(FrameStreamHeader)];
+    bool complete = std::fread(data, sizeof(data), 1, file_) == 1;
+    if( complete )
+    {
+        header_ = get_header(data);
+    }
+    if( not complete or
+        std::memcmp(header_.magic, FRAME_STREAM_MAGIC,
+                    sizeof(header_.magic)) != 0 or
+        header_.version < 1 or header_.version > FRAME_STREAM_VERSION )
+    {
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    current_.board = header_.opening;
+    current_.score = 0;
+    current_.move = 0;
+    current_.dir = UP;
+    keyframe_ = StreamKeyframe();
+    keyframe_.board = header_.opening;
+    finished_ = false;
+    final_state_ = PLAYING;
+
+    // The opening is where seeking starts when there is no keyframe
+    IndexEntry opening;
+    opening.move = 0;
+    opening.reserved = 0;
+    opening.offset = sizeof(header_);
+    index_.assign(1, opening);
+    moves_ = 0;
+    read_index();
+    std::fseek(file_, sizeof(header_), SEEK_SET);
+    return true;
+}
+
+bool FrameStreamReader::is_open() const
+{
+    return file_ != nullptr;
+}
+
+const FrameStreamHeader& FrameStreamReader::header() const
+{
+    return header_;
+}
+
+bool FrameStreamReader::next()
+{
+    if( file_ == nullptr or finished_ )
+    {
+        return false;
+    }
+
+    // If the frame isn't all there, it is read again next time
+    long start = std::ftell(file_);
+    unsigned char head[3];
+    if( not read(head, 1) )
+    {
+        std::fseek(file_, start, SEEK_SET);
+        return false;
+    }
+    if( head[0] == FRAME_STREAM_END )
+    {
+        if( not read(head + 1, 1) )
+        {
+            std::fseek(file_, start, SEEK_SET);
+            return false;
+        }
+        finished_ = true;
+        final_state_ = static_cast<GameState>(head[1]);
+        return false;
+    }
+    if( head[0] == FRAME_STREAM_KEYFRAME )
+    {
+        if( not read_keyframe() )
+        {
+            std::fseek(file_, start, SEEK_SET);
+            return false;
+        }
+
+        // Index the keyframes of a stream that has no index yet
+        if( keyframe_.move > index_.back().move )
+        {
+            IndexEntry entry;
+            entry.move = keyframe_.move;
+            entry.reserved = 0;
+            entry.offset = start;
+            index_.push_back(entry);
+        }
+        return next();
+    }
+
+    unsigned char nibbles[CELLS / 2];
+    if( not read(head + 1, 2) )
+    {
+        std::fseek(file_, start, SEEK_SET);
+        return false;
+    }
+    std::uint32_t mask = head[1] | head[2] << 8;
+    int changed = count_bits(mask);
+    if( not read(nibbles, (changed + 1) / 2) )
+    {
+        std::fseek(file_, start, SEEK_SET);
+        return false;
+    }
+    std::uint32_t difference = 0;
+    for( int shift = 0; ; shift += 7 )
+    {
+        unsigned char byte = 0;
+        if( shift > 28 or not read(&byte, 1) )
+        {
+            std::fseek(file_, start, SEEK_SET);
+            return false;
+        }
+        difference |= std::uint32_t(byte & 0x7F) << shift;
+        if( not (byte & 0x80) )
+        {
+            break;
+        }
+    }
+
+    // Put the new exponents in the changed cells
+    PackedBoard board = current_.board;
+    int n = 0;
+    for( int c = 0; c < CELLS; ++c )
+    {
+        if( not (mask & (1u << c)) )
+        {
+            continue;
+        }
+        PackedBoard exponent = (nibbles[n / 2] >> (4 * (n % 2))) & 0xF;
+        board = (board & ~(PackedBoard(0xF) << (4 * c))) |
+                (exponent << (4 * c));
+        ++n;
+    }
+    current_.board = board;
+    current_.score += difference;
+    current_.dir = static_cast<Direction>(head[0] & 3);
+    ++current_.move;
+    if( current_.move > moves_ )
+    {
+        moves_ = current_.move;
+    }
+    return true;
+}
+
+bool FrameStreamReader::seek(std::uint32_t move)
+{
+    if( file_ == nullptr )
+    {
+        return false;
+    }
+
+    // The last keyframe at or before the move, the keyframes of a
+    // stream are evenly spaced but an index read so far may not be
+    std::size_t low = 0;
+    std::size_t high = index_.size();
+    while( high - low > 1 )
+    {
+        std::size_t middle = (low + high) / 2;
+        if( index_[middle].move <= move )
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    // Going forward from the current frame is never slower
+    if( current_.move > move or current_.move < index_[low].move )
+    {
+        finished_ = false;
+        std::fseek(file_, index_[low].offset, SEEK_SET);
+        if( low == 0 )
+        {
+            current_.board = header_.opening;
+            current_.score = 0;
+            current_.move = 0;
+            current_.dir = UP;
+        }
+        else
+        {
+            unsigned char tag = 0;
+            if( not read(&tag, 1) or tag != FRAME_STREAM_KEYFRAME or
+                not read_keyframe() )
+            {
+                return false;
+            }
+        }
+    }
+    while( current_.move < move and next() )
+    {
+    }
+    return current_.move == move;
+}
+
+const StreamFrame& FrameStreamReader::current() const
+{
+    return current_;
+}
+
+const StreamKeyframe& FrameStreamReader::keyframe() const
+{
+    return keyframe_;
+}
+
+std::uint32_t FrameStreamReader::moves() const
+{
+    return moves_;
+}
+
+bool FrameStreamReader::finished() const
+{
+    return finished_;
+}
+
+GameState FrameStreamReader::final_state() const
+{
+    return final_state_;
+}
+
+bool FrameStreamReader::read(unsigned char* data, std::size_t size)
+{
+    if( size == 0 )
+    {
+        return true;
+    }
+    if( std::fread(data, size, 1, file_) != 1 )
+    {
+        // Forget the end of the file, so that a stream that grows can
+        // be read further
+        std::clearerr(file_);
+        return false;
+    }
+    return true;
+}
+
+bool FrameStreamReader::read_keyframe()
+{
+    unsigned char data[KEYFRAME_SIZE];
+    if( not read(data, sizeof(data)) )
+    {
+        return false;
+    }
+    keyframe_.move = get_number(data, 4);
+    keyframe_.score = get_number(data + 4, 4);
+    keyframe_.board = get_number(data + 8, 8);
+    for( int i = 0; i < 4; ++i )
+    {
+        keyframe_.rng_state[i] = get_number(data + 16 + 8 * i, 8);
+    }
+    current_.board = keyframe_.board;
+    current_.score = keyframe_.score;
+    current_.move = keyframe_.move;
+    if( current_.move > moves_ )
+    {
+        moves_ = current_.move;
+    }
+    return true;
+}
+
+void FrameStreamReader::read_index()
+{
+    unsigned char data[sizeof(FrameStreamTrailer)];
+    if( std::fseek(file_, -long(sizeof(data)), SEEK_END) != 0 or
+        not read(data, sizeof(data)) or
+        std::memcmp(data + 8, FRAME_INDEX_MAGIC,
+                    sizeof(FRAME_INDEX_MAGIC)) != 0 )
+    {
+        return;
+    }
+    std::uint32_t keyframes = get_number(data, 4);
+    std::uint32_t moves = get_number(data + 4, 4);
+    std::vector<unsigned char> entries(16 * std::size_t(keyframes));
+    if( std::fseek(file_, -long(sizeof(data) + entries.size()),
+                   SEEK_END) != 0 or
+        not read(entries.data(), entries.size()) )
+    {
+        return;
+    }
+    for( std::uint32_t k = 0; k < keyframes; ++k )
+    {
+        IndexEntry entry;
+        entry.move = get_number(&entries[16 * k], 4);
+        entry.reserved = 0;
+        entry.offset = get_number(&entries[16 * k + 8], 8);
+        index_.push_back(entry);
+    }
+    moves_ = moves;
+}
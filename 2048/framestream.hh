@@ -0,0 +1,238 @@
+/* FrameStream
+ *
+ * A recorded game as a stream of the changes of the board, one frame
+ * per move, so that a viewer can play it back at any speed without the
+ * rules of the game and a long game takes a few bytes per move.
+ *
+ * The file starts with a header:
+ *
+ *      magic "2048FRMS" (8), version (4), seed (4), target exponent (4),
+ *      generator of the new tiles (4), opening board (8),
+ *      keyframe interval (4), reserved (28)
+ *
+ * followed by a frame per move:
+ *
+ *      direction (1), mask of the changed cells (2), new exponents of
+ *      the changed cells, two per byte, score difference (1..5)
+ *
+ * Bit c of the mask is set if the move and the new tile changed the
+ * cell c of the packed board. The exponents are in the order of the
+ * cells, the first one in the low nibble. The score difference is a
+ * varint: 7 bits per byte, low bits first, the high bit set in every
+ * byte but the last.
+ *
+ * After every keyframe interval moves there is a keyframe, the whole
+ * state of the game after the move:
+ *
+ *      FRAME_STREAM_KEYFRAME (1), moves (4), score (4), board (8),
+ *      state of the generator (32)
+ *
+ * so going to any move takes at most the interval of frames from the
+ * keyframe before it. The state of the generator is the one of
+ * LegacyRng in the first 4 bytes or the one of FastRng, depending on
+ * the header, so a game can also be continued from a keyframe.
+ *
+ * A game that has ended is closed with FRAME_STREAM_END and the final
+ * state of the game, followed by the index of the keyframes:
+ *
+ *      moves (4), reserved (4), offset of the keyframe (8)
+ *
+ * and a trailer: keyframes in the index (4), moves in the game (4),
+ * magic "2048FIDX" (8). All the numbers, also the ones of the header,
+ * are little endian.
+ *
+ * The frames are written whole, so a reader can follow a stream that
+ * is still being written: a frame that isn't complete yet is read
+ * again on the next try. Such a stream has no index yet, the reader
+ * indexes the keyframes as it reads them.
+*/
+
+#ifndef FRAMESTREAM_HH
+#define FRAMESTREAM_HH
+
+#include "packedgame.hh"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct FrameStreamHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t seed;
+    std::uint32_t goal_exponent;
+    std::uint32_t rng_mode;
+    PackedBoard opening;
+    std::uint32_t keyframe_interval;
+    char reserved[28];
+};
+
+struct FrameStreamTrailer
+{
+    std::uint32_t keyframes;
+    std::uint32_t moves;
+    char magic[8];
+};
+
+static_assert(sizeof(FrameStreamHeader) == 64, "Unexpected header size");
+static_assert(sizeof(FrameStreamTrailer) == 16, "Unexpected trailer size");
+
+const char FRAME_STREAM_MAGIC[8] = {'2', '0', '4', '8', 'F', 'R', 'M', 'S'};
+const char FRAME_INDEX_MAGIC[8] = {'2', '0', '4', '8', 'F', 'I', 'D', 'X'};
+const std::uint32_t FRAME_STREAM_VERSION = 2;
+const unsigned char FRAME_STREAM_KEYFRAME = 0xFE;
+const unsigned char FRAME_STREAM_END = 0xFF;
+const std::uint32_t DEFAULT_KEYFRAME_INTERVAL = 256;
+
+// The board after a frame
+struct StreamFrame
+{
+    PackedBoard board;
+    std::uint32_t score;
+
+    // Number of moves made, 0 for the opening
+    std::uint32_t move;
+
+    // Direction of the last move
+    Direction dir;
+};
+
+// The state of the game at a keyframe
+struct StreamKeyframe
+{
+    std::uint32_t move;
+    std::uint32_t score;
+    PackedBoard board;
+    std::uint64_t rng_state[4];
+};
+
+class FrameStreamWriter
+{
+public:
+    FrameStreamWriter();
+
+    // Destructor, closes the file without an end.
+    ~FrameStreamWriter();
+
+    FrameStreamWriter(const FrameStreamWriter&) = delete;
+    FrameStreamWriter& operator=(const FrameStreamWriter&) = delete;
+
+    // Creates the file and writes the header. Returns false, and
+    // prints the reason, if the file can't be written.
+    bool open(const std::string& path, std::uint32_t seed,
+              int goal_exponent, RngMode mode, PackedBoard opening,
+              std::uint32_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+
+    // Returns true, if a file is open.
+    bool is_open() const;
+
+    // Writes a frame: the move in the given direction and the board
+    // and score after it, the new tile included. The generator is the
+    // one the game draws its new tiles with, for the keyframes.
+    void add(Direction dir, PackedBoard board, std::uint32_t score,
+             const SpawnRng& rng);
+
+    // Hands the frames written so far to the system, so that a reader
+    // following the stream sees them.
+    void flush();
+
+    // Writes the end of the game and the index, and closes the file.
+    void finish(GameState state);
+
+    // Number of frames and bytes written.
+    std::uint32_t frames() const;
+    std::uint64_t bytes() const;
+
+private:
+    // Place of a keyframe in the file
+    struct IndexEntry
+    {
+        std::uint32_t move;
+        std::uint32_t reserved;
+        std::uint64_t offset;
+    };
+
+    std::FILE* file_;
+    RngMode mode_;
+    std::uint32_t keyframe_interval_;
+    PackedBoard board_;
+    std::uint32_t score_;
+    std::uint32_t frames_;
+    std::uint64_t bytes_;
+    std::vector<unsigned char> buffer_;
+    std::vector<IndexEntry> index_;
+};
+
+class FrameStreamReader
+{
+public:
+    FrameStreamReader();
+
+    // Destructor, closes the file.
+    ~FrameStreamReader();
+
+    FrameStreamReader(const FrameStreamReader&) = delete;
+    FrameStreamReader& operator=(const FrameStreamReader&) = delete;
+
+    // Opens a stream and reads its header and index. The current frame
+    // is the opening. Returns false, if the file isn't a frame stream.
+    bool open(const std::string& path);
+
+    // Returns true, if a stream is open.
+    bool is_open() const;
+
+    const FrameStreamHeader& header() const;
+
+    // Reads the next frame into current. Returns false, if there is
+    // none: the game has ended or the rest isn't written yet.
+    bool next();
+
+    // Goes to the board after the given number of moves, from the
+    // keyframe before it. Returns false, if the stream doesn't have
+    // that many moves (yet), the current frame is then the last one.
+    bool seek(std::uint32_t move);
+
+    // The board after the frames read so far.
+    const StreamFrame& current() const;
+
+    // The last keyframe read, e.g. to continue the game from it.
+    const StreamKeyframe& keyframe() const;
+
+    // Number of moves in the stream: all of them, if the stream has an
+    // index, or else the most that have been read so far.
+    std::uint32_t moves() const;
+
+    // Returns true, if the end of the game has been read, and the
+    // state the game ended in.
+    bool finished() const;
+    GameState final_state() const;
+
+private:
+    // Place of a keyframe in the file, the opening is the first one
+    struct IndexEntry
+    {
+        std::uint32_t move;
+        std::uint32_t reserved;
+        std::uint64_t offset;
+    };
+
+    std::FILE* file_;
+    FrameStreamHeader header_;
+    StreamFrame current_;
+    StreamKeyframe keyframe_;
+    std::vector<IndexEntry> index_;
+    std::uint32_t moves_;
+    bool finished_;
+    GameState final_state_;
+
+    // Reads the given number of bytes, false if they aren't all there.
+    bool read(unsigned char* data, std::size_t size);
+
+    // Reads a keyframe after its tag and makes it the current frame.
+    bool read_keyframe();
+
+    // Reads the index at the end of an ended stream, if there is one.
+    void read_index();
+};
+
+#endif // FRAMESTREAM_HH
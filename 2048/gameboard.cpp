@@ -1,7 +1,17 @@
 #include "gameboard.hh"
 #include <iostream>
+#include <limits>
 
-GameBoard::GameBoard()
+namespace
+{
+
+// Values of 2^64 and more don't fit in the score
+const int MAX_SCORE_EXPONENT = 63;
+
+}
+
+GameBoard::GameBoard(int size):
+    size_(size), rng_(size)
 {
 }
 
@@ -34,90 +44,115 @@ void GameBoard::clear_game()
 void GameBoard::init_empty()
 {
     std::vector<NumberTile*> row;
-    for( int i = 0; i < SIZE; ++i)
+    for( int i = 0; i < size_; ++i)
     {
         row.push_back(nullptr);
     }
-    for( int i = 0; i < SIZE; ++i)
+    for( int i = 0; i < size_; ++i)
     {
         board_.push_back(row);
     }
 }
 
-void GameBoard::fill(int seed)
+void GameBoard::fill(int seed, RngMode mode)
 {
-    randomEng_.seed(seed);
-    distribution_ = std::uniform_int_distribution<int>(0, SIZE - 1);
-
-    // Wiping out the first random number (which is almost almost 0)
-    distribution_(randomEng_);
+    // Also wipes out the first random number in the legacy mode
+    rng_.seed(seed, mode);
 
-    for( auto y = 0; y < SIZE; ++y )
+    for( auto y = 0; y < size_; ++y )
     {
-        for( auto x = 0; x < SIZE; ++x )
+        for( auto x = 0; x < size_; ++x )
         {
             board_.at(y).at(x) = new NumberTile(0, std::make_pair(y, x), this);
         }
     }
 
-    for( int i = 0 ; i < SIZE ; ++i )
+    for( int i = 0 ; i < size_ ; ++i )
     {
         new_value();
     }
 }
 
-void GameBoard::new_value(bool check_if_empty)
+Coords GameBoard::new_value(bool)
 {
-    if( check_if_empty and is_full() ){
+    if( is_full() ){
         // So that we will not be stuck in a forever loop
-        return;
+        return std::make_pair(-1, -1);
     }
-    int random_x = 0;
-    int random_y = 0;
-    do
-    {
-        random_x = distribution_(randomEng_);
-        random_y = distribution_(randomEng_);
-    } while( not board_.at(random_y).at(random_x)->new_value(NEW_VALUE) );
+    int cell = rng_.pick_empty_cell([this](int cell) {
+        return board_.at(cell / size_).at(cell % size_)->is_empty();
+    });
+    board_.at(cell / size_).at(cell % size_)->new_value(NEW_VALUE);
+    return std::make_pair(cell / size_, cell % size_);
 }
 
-void GameBoard::print() const
+void GameBoard::print(std::ostream& out) const
 {
     for( auto y : board_ )
     {
-        std::cout << std::string(PRINT_WIDTH * SIZE + 1, '-') << std::endl;
+        out << std::string(PRINT_WIDTH * size_ + 1, '-') << std::endl;
         for( auto x : y )
         {
-            x->print(PRINT_WIDTH);
+            x->print(PRINT_WIDTH, out);
         }
-        std::cout << "|" << std::endl;
+        out << "|" << std::endl;
     }
-    std::cout << std::string(PRINT_WIDTH * SIZE + 1, '-') << std::endl;
+    out << std::string(PRINT_WIDTH * size_ + 1, '-') << std::endl;
 }
 
-bool GameBoard::move(Coords dir, int goal)
+MoveResult GameBoard::move(Coords dir, int goal)
 {
-    bool has_won = false;
+    MoveResult result = {false, 0, 0, 0, false};
     for( unsigned y = 0; y < board_.size(); ++y )
     {
         for( unsigned x = 0; x < board_.front().size(); ++x )
         {
             int directed_y = dir.first > 0 ? board_.size() - y - 1 : y;
             int directed_x = dir.second > 0 ? board_.back().size() - x - 1 : x;
-            if( board_.at(directed_y).at(directed_x)->move(dir, goal) )
+            NumberTile* tile = board_.at(directed_y).at(directed_x);
+
+            // The tiles ahead never move back here, so the tile still
+            // has its value from before the move
+            int exponent = tile->get_exponent();
+            if( exponent > result.max_exponent )
+            {
+                result.max_exponent = exponent;
+            }
+            NumberTile* merged = tile->move(dir, result.moved);
+            if( merged == nullptr )
+            {
+                continue;
+            }
+            ++result.merges;
+            exponent = merged->get_exponent();
+            if( exponent > result.max_exponent )
+            {
+                result.max_exponent = exponent;
+            }
+            std::uint64_t points = exponent <= MAX_SCORE_EXPONENT ?
+                        std::uint64_t(1) << exponent :
+                        std::numeric_limits<std::uint64_t>::max();
+            result.score = points > std::numeric_limits<std::uint64_t>::max()
+                                    - result.score ?
+                        std::numeric_limits<std::uint64_t>::max() :
+                        result.score + points;
+            if( merged->get_value() == goal )
             {
-                has_won = true;
+                result.won = true;
             }
         }
     }
-    for( auto &row : board_ )
+    if( result.moved )
     {
-        for( auto &tile : row )
+        for( auto &row : board_ )
         {
-            tile->reset_turn();
+            for( auto &tile : row )
+            {
+                tile->reset_turn();
+            }
         }
     }
-    return has_won;
+    return result;
 }
 
 NumberTile* GameBoard::get_item(Coords coords)
@@ -125,6 +160,16 @@ NumberTile* GameBoard::get_item(Coords coords)
     return board_.at(coords.first).at(coords.second);
 }
 
+int GameBoard::size() const
+{
+    return size_;
+}
+
+const SpawnRng& GameBoard::rng() const
+{
+    return rng_;
+}
+
 
 bool GameBoard::is_full() const
 {
@@ -3,6 +3,9 @@
  * The 'clear_game()' method was added by me, to clear
  * the entire board between restarts.
  *
+ * The board is SIZE x SIZE by default, but any size can be given to the
+ * constructor. The GUI and the packed engines only use SIZE.
+ *
  * Program editor:
  *
  * Name: Kian Moloney
@@ -13,19 +16,37 @@
 #define GAMEBOARD_HH
 
 #include "numbertile.hh"
+#include "rng.hh"
 #include <vector>
-#include <random>
 
 const int SIZE = 4;
 const int PRINT_WIDTH = 5;
 const int NEW_VALUE = 2;
 const int DEFAULT_GOAL = 2048;
 
+// What a move did, worked out during the slide
+struct MoveResult
+{
+    // True, if any tile moved or merged
+    bool moved;
+
+    // Number of merges, and the sum of the values of the merged tiles,
+    // which saturates at the largest 64 bit value
+    int merges;
+    std::uint64_t score;
+
+    // Exponent of the largest tile after the move
+    int max_exponent;
+
+    // True, if a merge produced the goal value
+    bool won;
+};
+
 class GameBoard
 {
 public:
-    // Constructor
-    GameBoard();
+    // Constructor, the board has size x size tiles
+    explicit GameBoard(int size = SIZE);
 
     // Destructor
     ~GameBoard();
@@ -38,37 +59,49 @@ public:
     void init_empty();
 
     // Initializes the random number generator and fills the gameboard
-    // with random numbers.
-    void fill(int seed);
+    // with random numbers. The legacy generator gives the same games
+    // as always, see rng.hh.
+    void fill(int seed, RngMode mode = LEGACY_RNG);
 
     // Draws a new location (coordinates) from the random number generator and
-    // puts the NEW_VALUE on that location, unless check_if_empty is true and
-    // the gameboard is full.
-    void new_value(bool check_if_empty = true);
+    // puts the NEW_VALUE on that location, unless the gameboard is full.
+    // Returns the location, or (-1, -1) if the gameboard was full.
+    Coords new_value(bool check_if_empty = true);
 
     // Returns true, if all the tiles in the game board are occupied,
     // otherwise returns false.
     bool is_full() const;
 
-    // Prints the game board.
-    void print() const;
+    // Prints the game board, PRINT_WIDTH characters per tile and two
+    // lines per row, the values on the second one.
+    void print(std::ostream& out = std::cout) const;
 
     // Moves the number tiles in the gameboard, if possible (by calling
     // move method for each number tile).
     // Finally, resets turn of all number tiles.
-    bool move(Coords dir, int goal);
+    // A move that didn't change the board has moved false and nothing
+    // else set but the largest tile.
+    MoveResult move(Coords dir, int goal);
 
     // Returns the element (number tile) in the given coordinates.
     NumberTile* get_item(Coords coords);
 
+    // Returns the number of tiles on a side of the board.
+    int size() const;
+
+    // The generator of the new values, e.g. for its counters.
+    const SpawnRng& rng() const;
+
 private:
+    // Number of tiles on a side
+    int size_;
+
     // Internal structure of the game board
     std::vector<std::vector<NumberTile*>> board_;
 
-    // Random number generator and distribution,
-    // they work better, if they are attributes of a class.
-    std::default_random_engine randomEng_;
-    std::uniform_int_distribution<int> distribution_;
+    // Random number generator,
+    // it works better, if it is an attribute of a class.
+    SpawnRng rng_;
 };
 
 #endif // GAMEBOARD_HH
@@ -0,0 +1,246 @@
+#include "gameclient.hh"
+#include "packedgame.hh"
+#include "strategy.hh"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+const int BENCHMARK_GOAL_EXPONENT = 11;
+
+// Session slot of the benchmark
+struct Slot
+{
+    std::uint32_t session;
+    PackedBoard board;
+    std::uint8_t state;
+};
+
+Request make_request(Opcode opcode, std::uint8_t argument,
+                     std::uint32_t session, std::uint32_t seed)
+{
+    Request request;
+    request.opcode = opcode;
+    request.argument = argument;
+    request.session = session;
+    request.seed = seed;
+    return request;
+}
+
+}
+
+GameClient::GameClient():
+    fd_(-1)
+{
+}
+
+GameClient::~GameClient()
+{
+    if( fd_ >= 0 )
+    {
+        close(fd_);
+    }
+}
+
+bool GameClient::connect(const std::string& socket_path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if( socket_path.size() >= sizeof(address.sun_path) )
+    {
+        return false;
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    return fd_ >= 0 and
+           ::connect(fd_, reinterpret_cast<sockaddr*>(&address),
+                     sizeof(address)) == 0;
+}
+
+bool GameClient::send(const std::vector<Request>& requests,
+                      std::vector<Response>& responses)
+{
+    buffer_.resize(requests.size() * REQUEST_SIZE);
+    for( std::size_t i = 0; i < requests.size(); ++i )
+    {
+        encode_request(requests.at(i), buffer_.data() + i * REQUEST_SIZE);
+    }
+    std::size_t done = 0;
+    while( done < buffer_.size() )
+    {
+        ssize_t sent = write(fd_, buffer_.data() + done,
+                             buffer_.size() - done);
+        if( sent <= 0 and errno != EINTR )
+        {
+            return false;
+        }
+        done += sent > 0 ? sent : 0;
+    }
+
+    buffer_.resize(requests.size() * RESPONSE_SIZE);
+    done = 0;
+    while( done < buffer_.size() )
+    {
+        ssize_t received = read(fd_, buffer_.data() + done,
+                                buffer_.size() - done);
+        if( received <= 0 and errno != EINTR )
+        {
+            return false;
+        }
+        done += received > 0 ? received : 0;
+    }
+
+    responses.resize(requests.size());
+    for( std::size_t i = 0; i < requests.size(); ++i )
+    {
+        responses.at(i) = decode_response(buffer_.data()
+                                          + i * RESPONSE_SIZE);
+    }
+    return true;
+}
+
+bool GameClient::send(const Request& request, Response& response)
+{
+    std::vector<Response> responses;
+    if( not send(std::vector<Request>(1, request), responses) )
+    {
+        return false;
+    }
+    response = responses.front();
+    return true;
+}
+
+bool run_server_benchmark(const std::string& socket_path, int sessions,
+                          int moves, std::ostream& out)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    GameClient client;
+    if( not client.connect(socket_path) )
+    {
+        std::cerr << "Can't connect to " << socket_path << std::endl;
+        return false;
+    }
+
+    // Open all the sessions with one batch
+    std::uint32_t next_seed = 0;
+    std::vector<Request> requests;
+    std::vector<Response> responses;
+    for( int i = 0; i < sessions; ++i )
+    {
+        requests.push_back(make_request(OP_NEW_GAME, BENCHMARK_GOAL_EXPONENT,
+                                        0, next_seed++));
+    }
+    if( not client.send(requests, responses) )
+    {
+        return false;
+    }
+    std::vector<Slot> slots;
+    for( const Response& response : responses )
+    {
+        if( response.status != STATUS_OK )
+        {
+            std::cerr << "Server refused a new game" << std::endl;
+            return false;
+        }
+        Slot slot = {response.session, response.board, response.state};
+        slots.push_back(slot);
+    }
+
+    // Round trip latency of single moves
+    GreedyStrategy strategy;
+    std::vector<double> latencies;
+    for( int i = 0; i < moves; ++i )
+    {
+        Slot& slot = slots.at(i % slots.size());
+        Direction dir = UP;
+        strategy.choose(slot.board, dir);
+        dir = legal_move(slot.board, dir);
+        Response response;
+        Clock::time_point begin = Clock::now();
+        if( not client.send(make_request(OP_MOVE, dir, slot.session, 0),
+                            response) )
+        {
+            return false;
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(
+                                Clock::now() - begin).count());
+        slot.board = response.board;
+        slot.state = response.state;
+    }
+
+    // Throughput with one move per session in every batch,
+    // finished games are replaced with new ones
+    std::uint64_t moves_made = 0;
+    Clock::time_point begin = Clock::now();
+    for( int round = 0; round < moves; ++round )
+    {
+        requests.clear();
+        for( const Slot& slot : slots )
+        {
+            if( slot.state != PLAYING )
+            {
+                requests.push_back(make_request(OP_CLOSE, 0,
+                                                slot.session, 0));
+                requests.push_back(make_request(OP_NEW_GAME,
+                                                BENCHMARK_GOAL_EXPONENT,
+                                                0, next_seed++));
+                continue;
+            }
+            Direction dir = UP;
+            strategy.choose(slot.board, dir);
+            dir = legal_move(slot.board, dir);
+            requests.push_back(make_request(OP_MOVE, dir, slot.session, 0));
+        }
+        if( not client.send(requests, responses) )
+        {
+            return false;
+        }
+        std::size_t r = 0;
+        for( Slot& slot : slots )
+        {
+            if( slot.state != PLAYING )
+            {
+                ++r;
+            }
+            else
+            {
+                ++moves_made;
+            }
+            const Response& response = responses.at(r++);
+            slot.session = response.session;
+            slot.board = response.board;
+            slot.state = response.state;
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now()
+                                                    - begin).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    out << "sessions: " << sessions << std::endl;
+    if( not latencies.empty() )
+    {
+        out << "round trip (us): p50 " << latencies.at(latencies.size() / 2)
+            << ", p99 " << latencies.at(latencies.size() * 99 / 100)
+            << ", max " << latencies.back() << std::endl;
+    }
+    out << "pipelined moves per second: " << moves_made / seconds
+        << std::endl;
+
+    // Leave the server as it was
+    requests.clear();
+    for( const Slot& slot : slots )
+    {
+        requests.push_back(make_request(OP_CLOSE, 0, slot.session, 0));
+    }
+    return client.send(requests, responses);
+}
@@ -0,0 +1,47 @@
+/* GameClient
+ *
+ * A blocking client for the GameServer, used by the bots written in
+ * C++ and by the server benchmark.
+*/
+
+#ifndef GAMECLIENT_HH
+#define GAMECLIENT_HH
+
+#include "protocol.hh"
+#include <ostream>
+#include <string>
+#include <vector>
+
+class GameClient
+{
+public:
+    GameClient();
+
+    // Destructor, closes the connection.
+    ~GameClient();
+
+    // Connects to the server. Returns false, if it can't.
+    bool connect(const std::string& socket_path);
+
+    // Sends all the requests with one write and waits for all
+    // the responses. Returns false, if the connection broke.
+    bool send(const std::vector<Request>& requests,
+              std::vector<Response>& responses);
+
+    // Sends one request and waits for the response.
+    bool send(const Request& request, Response& response);
+
+private:
+    int fd_;
+
+    std::vector<unsigned char> buffer_;
+};
+
+// Plays the given number of moves in each of the given number of
+// sessions with the greedy strategy and prints the round trip latency
+// of single moves and the throughput of pipelined moves.
+// Returns false, if the server couldn't be used.
+bool run_server_benchmark(const std::string& socket_path, int sessions,
+                          int moves, std::ostream& out);
+
+#endif // GAMECLIENT_HH
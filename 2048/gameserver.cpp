@@ -0,0 +1,399 @@
+#include "gameserver.hh"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+const int MAX_EVENTS = 64;
+const int WAIT_TIMEOUT_MS = 200;
+const std::size_t READ_CHUNK = 64 * 1024;
+// Input read at one time, the rest waits for the next round, so one
+// round can't make more than twice as much output
+const std::size_t MAX_READ_INPUT = 16 * READ_CHUNK;
+// Responses a client hasn't taken yet, past this it is dropped
+const std::size_t MAX_PENDING_OUTPUT = 8 * MAX_READ_INPUT;
+const int MIN_GOAL_EXPONENT = 2;
+// PackedBoard holds exponents up to 15 and doesn't merge two 2^15 tiles,
+// so a larger goal could never be reached
+const int MAX_GOAL_EXPONENT = 15;
+
+bool set_non_blocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 and fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+}
+
+GameServer::GameServer(const std::string& socket_path,
+                       std::size_t max_sessions):
+    socket_path_(socket_path), max_sessions_(max_sessions), listen_fd_(-1),
+    epoll_fd_(-1), running_(0), active_sessions_(0), peak_sessions_(0),
+    requests_(0), moves_(0), busy_nanoseconds_(0)
+{
+}
+
+GameServer::~GameServer()
+{
+    while( not connections_.empty() )
+    {
+        close_connection(connections_.begin()->first);
+    }
+    if( listen_fd_ >= 0 )
+    {
+        close(listen_fd_);
+        unlink(socket_path_.c_str());
+    }
+    if( epoll_fd_ >= 0 )
+    {
+        close(epoll_fd_);
+    }
+}
+
+bool GameServer::listen()
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if( socket_path_.size() >= sizeof(address.sun_path) )
+    {
+        std::cerr << "Socket path is too long: " << socket_path_ << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, socket_path_.c_str());
+
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if( listen_fd_ < 0 )
+    {
+        std::cerr << "socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // A socket left behind by an earlier server would make bind fail
+    unlink(socket_path_.c_str());
+    if( bind(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) != 0 or
+        ::listen(listen_fd_, SOMAXCONN) != 0 or
+        not set_non_blocking(listen_fd_) )
+    {
+        std::cerr << socket_path_ << ": " << std::strerror(errno)
+                  << std::endl;
+        return false;
+    }
+
+    epoll_fd_ = epoll_create1(0);
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd_;
+    if( epoll_fd_ < 0 or
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) != 0 )
+    {
+        std::cerr << "epoll: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void GameServer::run()
+{
+    running_ = 1;
+    epoll_event events[MAX_EVENTS];
+    while( running_ )
+    {
+        int count = epoll_wait(epoll_fd_, events, MAX_EVENTS,
+                               WAIT_TIMEOUT_MS);
+        for( int i = 0; i < count; ++i )
+        {
+            int fd = events[i].data.fd;
+            if( fd == listen_fd_ )
+            {
+                accept_connections();
+                continue;
+            }
+
+            std::map<int, Connection>::iterator it = connections_.find(fd);
+            if( it == connections_.end() )
+            {
+                continue;
+            }
+            bool open = true;
+            if( events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR) )
+            {
+                open = read_connection(fd, it->second);
+            }
+            if( open )
+            {
+                open = flush_connection(fd, it->second);
+            }
+            if( not open )
+            {
+                close_connection(fd);
+            }
+        }
+    }
+}
+
+void GameServer::stop()
+{
+    running_ = 0;
+}
+
+void GameServer::print_statistics(std::ostream& out) const
+{
+    out << "sessions: " << active_sessions_ << " (peak " << peak_sessions_
+        << ")" << std::endl;
+    out << "requests: " << requests_ << ", moves: " << moves_ << std::endl;
+    if( requests_ > 0 )
+    {
+        out << "handling time per request: "
+            << double(busy_nanoseconds_) / requests_ << " ns" << std::endl;
+    }
+}
+
+void GameServer::accept_connections()
+{
+    while( true )
+    {
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if( fd < 0 )
+        {
+            return;
+        }
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if( not set_non_blocking(fd) or
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0 )
+        {
+            close(fd);
+            continue;
+        }
+        connections_[fd];
+    }
+}
+
+bool GameServer::read_connection(int fd, Connection& connection)
+{
+    std::vector<unsigned char>& input = connection.input;
+    while( not connection.closing and input.size() < MAX_READ_INPUT )
+    {
+        std::size_t old_size = input.size();
+        input.resize(old_size + READ_CHUNK);
+        ssize_t received = read(fd, input.data() + old_size, READ_CHUNK);
+        input.resize(old_size + (received > 0 ? received : 0));
+
+        // The requests sent before the end still get their responses
+        if( received == 0 )
+        {
+            connection.closing = true;
+            break;
+        }
+        if( received < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+            if( errno != EAGAIN and errno != EWOULDBLOCK )
+            {
+                return false;
+            }
+            break;
+        }
+    }
+
+    // Handle every complete request, the responses go to one buffer
+    std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+    std::size_t complete = input.size() / REQUEST_SIZE;
+    std::size_t output_size = connection.output.size();
+    if( output_size - connection.output_sent + complete * RESPONSE_SIZE >
+        MAX_PENDING_OUTPUT )
+    {
+        return false;
+    }
+    connection.output.resize(output_size + complete * RESPONSE_SIZE);
+    for( std::size_t i = 0; i < complete; ++i )
+    {
+        Response response = handle(fd, connection, decode_request(
+                                       input.data() + i * REQUEST_SIZE));
+        encode_response(response, connection.output.data() + output_size
+                                  + i * RESPONSE_SIZE);
+    }
+    input.erase(input.begin(), input.begin() + complete * REQUEST_SIZE);
+    requests_ += complete;
+    busy_nanoseconds_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+    return true;
+}
+
+bool GameServer::flush_connection(int fd, Connection& connection)
+{
+    while( connection.output_sent < connection.output.size() )
+    {
+        ssize_t sent = write(fd, connection.output.data()
+                                 + connection.output_sent,
+                             connection.output.size()
+                             - connection.output_sent);
+        if( sent < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+            if( errno != EAGAIN and errno != EWOULDBLOCK )
+            {
+                return false;
+            }
+            break;
+        }
+        connection.output_sent += sent;
+    }
+
+    bool pending = connection.output_sent < connection.output.size();
+    if( not pending )
+    {
+        connection.output.clear();
+        connection.output_sent = 0;
+        if( connection.closing )
+        {
+            return false;
+        }
+    }
+
+    // Wait until the socket takes more, if everything didn't fit. There
+    // is nothing more to read from a closing connection.
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = (connection.closing ? 0 : std::uint32_t(EPOLLIN))
+            | (pending ? std::uint32_t(EPOLLOUT) : 0);
+    event.data.fd = fd;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void GameServer::close_connection(int fd)
+{
+    std::map<int, Connection>::iterator it = connections_.find(fd);
+    if( it != connections_.end() )
+    {
+        for( std::uint32_t session : it->second.sessions )
+        {
+            free_session(session);
+        }
+        connections_.erase(it);
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+}
+
+Response GameServer::handle(int fd, Connection& connection,
+                            const Request& request)
+{
+    Response response;
+    std::memset(&response, 0, sizeof(response));
+    response.status = STATUS_OK;
+    response.session = request.session;
+
+    PackedGame* game = nullptr;
+    switch( request.opcode )
+    {
+    case OP_NEW_GAME:
+        if( request.argument < MIN_GOAL_EXPONENT or
+            request.argument > MAX_GOAL_EXPONENT )
+        {
+            response.status = STATUS_BAD_REQUEST;
+            return response;
+        }
+        if( free_sessions_.empty() )
+        {
+            if( sessions_.size() >= max_sessions_ )
+            {
+                response.status = STATUS_SERVER_FULL;
+                return response;
+            }
+            sessions_.push_back(PackedGame());
+            owners_.push_back(-1);
+            free_sessions_.push_back(sessions_.size());
+        }
+        response.session = free_sessions_.back();
+        free_sessions_.pop_back();
+        owners_.at(response.session - 1) = fd;
+        connection.sessions.insert(response.session);
+        if( ++active_sessions_ > peak_sessions_ )
+        {
+            peak_sessions_ = active_sessions_;
+        }
+        game = &sessions_.at(response.session - 1);
+        game->start(request.seed, request.argument);
+        break;
+
+    case OP_MOVE:
+        game = find_session(request.session, fd);
+        if( game != nullptr )
+        {
+            if( request.argument >= DIRECTION_COUNT )
+            {
+                response.status = STATUS_BAD_REQUEST;
+                return response;
+            }
+            game->step(Direction(request.argument));
+            ++moves_;
+        }
+        break;
+
+    case OP_GET_STATE:
+        game = find_session(request.session, fd);
+        break;
+
+    case OP_CLOSE:
+        game = find_session(request.session, fd);
+        if( game != nullptr )
+        {
+            connection.sessions.erase(request.session);
+            free_session(request.session);
+        }
+        break;
+
+    default:
+        response.status = STATUS_BAD_REQUEST;
+        return response;
+    }
+
+    if( game == nullptr )
+    {
+        response.status = STATUS_UNKNOWN_SESSION;
+        return response;
+    }
+    response.state = game->state();
+    response.board = game->board();
+    response.score = game->score();
+    response.moves = game->moves();
+    return response;
+}
+
+PackedGame* GameServer::find_session(std::uint32_t session, int fd)
+{
+    if( session == 0 or session > sessions_.size() or
+        owners_.at(session - 1) != fd )
+    {
+        return nullptr;
+    }
+    return &sessions_.at(session - 1);
+}
+
+void GameServer::free_session(std::uint32_t session)
+{
+    owners_.at(session - 1) = -1;
+    free_sessions_.push_back(session);
+    --active_sessions_;
+}
@@ -0,0 +1,118 @@
+/* GameServer
+ *
+ * Headless server that lets external bots play the game through
+ * a Unix domain socket, see protocol.hh for the messages.
+ *
+ * The server is a single threaded epoll event loop. All the games are
+ * kept in one session table of PackedGame objects, and the requests of
+ * a connection are handled in batches: everything that has arrived is
+ * handled, and all the responses are sent with one write. A client
+ * that doesn't take its responses is dropped, once too many of them
+ * are waiting.
+ *
+ * A session belongs to the connection that opened it. Other
+ * connections get STATUS_UNKNOWN_SESSION for it, and the sessions of
+ * a connection are freed when it closes, with or without OP_CLOSE.
+ *
+ * One server uses one core, so the number of games one core can host
+ * is simply the number of sessions of the server.
+*/
+
+#ifndef GAMESERVER_HH
+#define GAMESERVER_HH
+
+#include "packedgame.hh"
+#include "protocol.hh"
+#include <csignal>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class GameServer
+{
+public:
+    // Constructor, the server doesn't listen until listen() is called.
+    GameServer(const std::string& socket_path, std::size_t max_sessions);
+
+    // Destructor, closes all the connections and removes the socket.
+    ~GameServer();
+
+    // Creates the socket. Returns false, and prints the reason,
+    // if it can't be created.
+    bool listen();
+
+    // Handles the connections until stop() is called.
+    void run();
+
+    // Makes run() return. Safe to call from a signal handler.
+    void stop();
+
+    // Prints the number of sessions, requests and the time used
+    // to handle them.
+    void print_statistics(std::ostream& out) const;
+
+private:
+    struct Connection
+    {
+        std::vector<unsigned char> input;
+        std::vector<unsigned char> output;
+        std::size_t output_sent = 0;
+
+        // The client has closed its end, the connection is closed once
+        // the responses are sent
+        bool closing = false;
+
+        // Sessions opened by the connection and not closed yet
+        std::unordered_set<std::uint32_t> sessions;
+    };
+
+    std::string socket_path_;
+    std::size_t max_sessions_;
+    int listen_fd_;
+    int epoll_fd_;
+    volatile std::sig_atomic_t running_;
+
+    // Session table, session n is sessions_.at(n - 1) and belongs to
+    // the connection owners_.at(n - 1), -1 if the session is free
+    std::vector<PackedGame> sessions_;
+    std::vector<int> owners_;
+    std::vector<std::uint32_t> free_sessions_;
+    std::size_t active_sessions_;
+    std::size_t peak_sessions_;
+
+    // Connections by their file descriptor
+    std::map<int, Connection> connections_;
+
+    // Statistics
+    std::uint64_t requests_;
+    std::uint64_t moves_;
+    std::uint64_t busy_nanoseconds_;
+
+    // Accepts all the pending connections.
+    void accept_connections();
+
+    // Reads and handles everything that has arrived. Returns false,
+    // if the connection broke or too many responses are waiting.
+    bool read_connection(int fd, Connection& connection);
+
+    // Sends as much of the output as the socket takes. Returns false,
+    // if the connection broke or it is closing and everything was sent.
+    bool flush_connection(int fd, Connection& connection);
+
+    // Closes the connection and frees its sessions.
+    void close_connection(int fd);
+
+    // Handles one request of the given connection.
+    Response handle(int fd, Connection& connection, const Request& request);
+
+    // Returns the game of the given session, or nullptr if the session
+    // doesn't belong to the given connection.
+    PackedGame* find_session(std::uint32_t session, int fd);
+
+    // Frees the session.
+    void free_session(std::uint32_t session);
+};
+
+#endif // GAMESERVER_HH
@@ -1,11 +1,19 @@
 #include "mainwindow.hh"
+#include "startuptimeline.hh"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // Measure the start from the very beginning
+    StartupTimeline& timeline = StartupTimeline::instance();
+    timeline.start();
+
     QApplication a(argc, argv);
+    timeline.mark("application");
     MainWindow w;
+    timeline.mark("window constructed");
     w.show();
+    timeline.mark("window shown");
     return a.exec();
 }
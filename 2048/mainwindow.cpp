@@ -2,13 +2,20 @@
 #include "ui_mainwindow.h"
 #include "gameboard.hh"
 #include "numbertile.hh"
+#include "packedboard.hh"
+#include "startuptimeline.hh"
 #include <cmath>
+#include <limits>
 #include <string>
 #include <QKeyEvent>
 #include <QPalette>
 #include <QPixmap>
 #include <QFile>
+#include <QFileDialog>
 #include <QTextStream>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QtConcurrent>
 
 using uint = unsigned int;
 using namespace std;
@@ -46,7 +53,8 @@ MainWindow::MainWindow(QWidget *parent)
 
     ui->targetSpinBox->setMinimum(2);
     ui->targetSpinBox->setValue(11);
-    ui->targetSpinBox->setMaximum(SIZE*SIZE);
+    // The packed board of the loss check can't merge two 2^15 tiles
+    ui->targetSpinBox->setMaximum(MAX_PACKED_EXPONENT);
 
     // Set scene size
     scene->setSceneRect(0,0,BOX_SIZE,BOX_SIZE);
@@ -65,12 +73,50 @@ MainWindow::MainWindow(QWidget *parent)
     ui->secLcdNumber->setStyleSheet("background-color: orange");
     connect(timer, &QTimer::timeout, this, &MainWindow::clock);
 
+    // The board is drawn at most once per display refresh, moves made
+    // in between only mark it as changed
+    frameTimer = new QTimer(this);
+    frameTimer->setSingleShot(true);
+    frameTimer->setTimerType(Qt::PreciseTimer);
+    qreal refreshRate = QGuiApplication::primaryScreen()->refreshRate();
+    frameTimer->setInterval(qMax(1, qRound(1000.0 / refreshRate)));
+    connect(frameTimer, &QTimer::timeout, this, &MainWindow::renderFrame);
+
+    // Autoplay timer
+    autoplayTimer = new QTimer(this);
+    autoplayTimer->setTimerType(Qt::PreciseTimer);
+    connect(autoplayTimer, &QTimer::timeout, this, &MainWindow::autoplayTick);
+
+    // Seed suggestions are only available if there is a seed index
+    seedIndex.open(SEED_INDEX_FILE);
+    ui->actionEasySeed->setEnabled(seedIndex.is_open());
+    ui->actionHardSeed->setEnabled(seedIndex.is_open());
+    tablebase.open(TABLEBASE_FILE);
+
     // Create board
     createGameBoard();
+
+    // The tiles are drawn by one item on top of the empty squares
+    boardItem = new BoardItem(SIZE, slotSize);
+    boardItem->setAtlas(&tileAtlas);
+    boardItem->setFallback([this](int exponent) {
+        return tilePixmap(exponent, slotSize);
+    });
+    scene->addItem(boardItem);
+
+    // The atlas is built in the background after the first frame
+    atlasWatcher = new QFutureWatcher<TileAtlas>(this);
+    connect(atlasWatcher, &QFutureWatcher<TileAtlas>::finished,
+            this, &MainWindow::atlasBuilt);
+
+    // Watch the painting of the board for the startup timeline
+    ui->gameGraphicsView->viewport()->installEventFilter(this);
 }
 
 MainWindow::~MainWindow()
 {
+    delete playbackView;
+    delete wallView;
     delete gameBoard;
     delete ui;
 }
@@ -94,13 +140,8 @@ void MainWindow::createGameBoard() const
 
 void MainWindow::emptyGameBoard()
 {
-    // Go through the clearing vector and delete and null all
-    // labels, at the end clear the vector
-    for ( uint i = 0; i < tempLabels.size(); ++i ) {
-        delete tempLabels.at(i);
-        tempLabels.at(i) = nullptr;
-    }
-    tempLabels.clear();
+    // Remove all the tiles from the board item
+    boardItem->clear();
 }
 
 void MainWindow::on_playPushButton_clicked()
@@ -135,37 +176,15 @@ void MainWindow::on_playPushButton_clicked()
     // Get the seed and fill the board
     seedValue = ui->seedSpinBox->value();
     gameBoard->fill(seedValue);
+    packedBoard = packed::from_game_board(*gameBoard);
+    autoplayStrategy->start_game(seedValue);
+    startRecording();
 
-    for ( uint y = 0; y < SIZE; ++y ) {
-        for ( uint x = 0; x < SIZE; ++x ) {
-
-            // Check if we found coordinates holding a value
-            if ( !gameBoard->get_item(make_pair(y,x))->is_empty() ) {
-
-                // Create a new label
-                QLabel* new_label = new QLabel();
+    // Show the first tiles
+    boardItem->setBoard(*gameBoard);
 
-                // Push back into the clearing vector
-                tempLabels.push_back(new_label);
-
-                // Add the label to the scene
-                scene->addWidget(new_label);
-                new_label->move(x*slotSize, y*slotSize);
-
-                // Center the label
-                new_label->move(x*slotSize, y*slotSize);
-
-                // Get the value of the tile, and then the corresponding photo
-                // and add the photo to table, on the right spot.
-                int intValue = gameBoard->get_item(make_pair(y,x))
-                                                   ->get_value();
-
-                QPixmap pix(photoIconsByValue.at(intValue));
-                new_label->setPixmap(pix.scaled(slotSize, slotSize,
-                                                Qt::KeepAspectRatio));
-            }
-        }
-    }
+    // Let the strategy play if autoplay is on
+    updateAutoplayState();
 }
 
 
@@ -176,8 +195,16 @@ void MainWindow::on_resetPushButton_clicked()
 
 void MainWindow::resetGame()
 {
+    // A game given up is counted as it was
+    if ( telemetryRecorder.in_game() ) {
+        endRecording(PLAYING);
+    }
     gameIsGoingOn = false;
 
+    // Nothing left to draw or play
+    frameTimer->stop();
+    updateAutoplayState();
+
     // Empty the scene, and the actual gameboard
     emptyGameBoard();
     initializeGameBoard();
@@ -190,58 +217,231 @@ void MainWindow::resetGame()
 
 void MainWindow::updateGameBoard()
 {
-    // Empty the board first
-    emptyGameBoard();
-
-    // Find out whats new and update accordingly
-    for ( uint y = 0; y < SIZE; ++y ) {
-        for ( uint x = 0; x < SIZE; ++x ) {
-
-            // Check if certain spot on the board holds a value
-            if ( not gameBoard->get_item(make_pair(y,x))->is_empty() ) {
-
-                // Create and add a new label to the scene
-                QLabel* new_label = new QLabel();
-                scene->addWidget(new_label);
+    // The board item only repaints, if some tile changed
+    boardItem->setBoard(*gameBoard);
+}
 
-                // Place the label
-                new_label->move(x*slotSize, y*slotSize);
+MainWindow::GameOutcome MainWindow::stepGame(const pair<int, int> direction)
+{
+    TelemetryTimer timer(&telemetryRecorder, STEP_PHASE);
+    MoveResult result = gameBoard->move(direction, targetValueCorrected);
 
-                // Find the right picture and add it to the label
-                int intValue = gameBoard->get_item(make_pair(y,x))
-                                                   ->get_value();
+    // A move that changes nothing doesn't count
+    if ( !result.moved ) {
+        return GAME_CONTINUES;
+    }
 
-                QPixmap pix(photoIconsByValue.at(intValue));
-                new_label->setPixmap(pix.scaled(slotSize, slotSize,
-                                                Qt::KeepAspectRatio));
+    // The packed board makes the same slide, the target keeps its
+    // tiles below 2^15 where the two engines would differ
+    PackedBoard before = packedBoard;
+    PackedBoard after = packed::move(before,
+                                     packed::from_coords(direction)).board;
+    packedBoard = after;
+    telemetryRecorder.record_move(before, after);
 
-                // Push the label in to the clearing vector
-                tempLabels.push_back(new_label);
+    // Win check
+    if ( result.won ) {
+        frameWriter.add(packed::from_coords(direction), after, gameScore,
+                        gameBoard->rng());
+        endRecording(WON);
+        return GAME_WON;
+    }
+    pointsUpdater(result);
+
+    // The new tile goes to the packed board too
+    Coords cell = gameBoard->new_value();
+    if ( cell.first >= 0 ) {
+        after = packed::set_exponent(
+                after, cell.first, cell.second,
+                gameBoard->get_item(cell)->get_exponent());
+    }
+    packedBoard = after;
+    frameWriter.add(packed::from_coords(direction), after, gameScore,
+                    gameBoard->rng());
+
+    // Loss check, only a full board can be stuck: the game is lost
+    // when no move changes it
+    if ( packed::count_empty(after) == 0 ) {
+        for ( int dir = 0; dir < DIRECTION_COUNT; ++dir ) {
+            if ( packed::move(after, Direction(dir)).board != after ) {
+                return GAME_CONTINUES;
             }
         }
+        endRecording(LOST);
+        return GAME_LOST;
     }
+    return GAME_CONTINUES;
 }
 
 void MainWindow::moveBoard(const pair<int, int> direction)
 {
-    // Win check
-    if ( gameBoard->move(direction, targetValueCorrected) ) {
-        updateGameBoard();
-        pauseTimer(true);
-        winningMessageBox();
+    // The first move of the user is on the startup timeline
+    if ( StartupTimeline::instance().elapsed("first move") < 0 ) {
+        StartupTimeline::instance().mark("first move");
+        firstMovePending = true;
+    }
+
+    GameOutcome outcome = stepGame(direction);
+    if ( outcome == GAME_CONTINUES ) {
+        requestFrame();
         return;
     }
 
-    // Loss check
-    if ( !gameBoard->is_full() ) {
-        pointsUpdater();
-        gameBoard->new_value();
-        updateGameBoard();
+    // Show the final board before the messagebox
+    renderFrame();
+    pauseTimer(true);
+    if ( outcome == GAME_WON ) {
+        winningMessageBox();
     } else {
-        pauseTimer(true);
         lossMessageBox();
+    }
+}
+
+void MainWindow::requestFrame()
+{
+    // Moves made before the timer fires end up in the same frame
+    if ( !frameTimer->isActive() ) {
+        frameTimer->start();
+    }
+}
+
+void MainWindow::renderFrame()
+{
+    frameTimer->stop();
+
+    // The board has no tiles between games
+    if ( !gameIsGoingOn ) {
+        return;
+    }
+    TelemetryTimer timer(&telemetryRecorder, DRAW_PHASE);
+    updateGameBoard();
+
+    // A playback window following the recording sees the moves drawn
+    frameWriter.flush();
+    ui->currentScoreTextBrowser->setText(QString::number(gameScore));
+    ui->highscoreTextBrowser->setText(QString::number(gameHighscore));
+}
+
+void MainWindow::updateAutoplayState()
+{
+    bool run = ui->autoplayCheckBox->isChecked() && gameIsGoingOn
+               && !isPaused;
+    if ( !run ) {
+        autoplayTimer->stop();
+        disableArrowButtons(isPaused);
         return;
     }
+
+    // The strategy makes the moves, not the user
+    disableArrowButtons(true);
+
+    // Slow speeds get one move per tick, faster ones and 'max' (0)
+    // run in batches on every pass of the event loop
+    int speed = ui->speedSpinBox->value();
+    if ( speed > 0 && speed <= MAX_TICK_RATE ) {
+        autoplayTimer->start(1000 / speed);
+    } else {
+        autoplayTimer->start(0);
+    }
+    autoplayClock.start();
+    autoplayMovesDone = 0;
+}
+
+void MainWindow::autoplayTick()
+{
+    int speed = ui->speedSpinBox->value();
+
+    // Find out how many moves are due by now
+    qint64 movesDue = 1;
+    if ( speed == 0 ) {
+        movesDue = std::numeric_limits<qint64>::max();
+    } else if ( speed > MAX_TICK_RATE ) {
+        movesDue = speed * autoplayClock.elapsed() / 1000
+                   - autoplayMovesDone;
+    }
+
+    QElapsedTimer budget;
+    budget.start();
+    while ( movesDue > 0 && budget.elapsed() < AUTOPLAY_BUDGET_MS ) {
+
+        // The game ends before the board gets stuck, see stepGame. A
+        // move that changes nothing would be ignored, so it is replaced.
+        PackedBoard board = packedBoard;
+        Direction dir = UP;
+        {
+            TelemetryTimer timer(&telemetryRecorder, CHOOSE_PHASE);
+            autoplayStrategy->choose(board, dir);
+        }
+        dir = legal_move(board, dir);
+        GameOutcome outcome = stepGame(packed::to_coords(dir));
+        ++autoplayMovesDone;
+        --movesDue;
+        if ( outcome != GAME_CONTINUES ) {
+            autoplayNextGame(outcome);
+        }
+    }
+
+    // If we couldn't keep up, drop the backlog instead of
+    // trying to catch up later
+    if ( movesDue > 0 && speed > MAX_TICK_RATE ) {
+        autoplayMovesDone += movesDue;
+    }
+    requestFrame();
+}
+
+void MainWindow::autoplayNextGame(GameOutcome outcome)
+{
+    // Tell how the game went
+    QString result;
+    if ( !isFinnish ) {
+        result = outcome == GAME_WON ? "won" : "lost";
+        ui->statusbar->showMessage("Seed " + QString::number(seedValue)
+                                   + ": " + result + " with "
+                                   + QString::number(gameScore) + " points");
+    } else {
+        result = outcome == GAME_WON ? "voitto" : "häviö";
+        ui->statusbar->showMessage("Siemen " + QString::number(seedValue)
+                                   + ": " + result + ", "
+                                   + QString::number(gameScore)
+                                   + " pistettä");
+    }
+
+    // Start over with the next seed
+    seedValue = (seedValue + 1) % (ui->seedSpinBox->maximum() + 1);
+    ui->seedSpinBox->setValue(seedValue);
+    gameBoard->clear_game();
+    gameBoard->fill(seedValue);
+    packedBoard = packed::from_game_board(*gameBoard);
+    autoplayStrategy->start_game(seedValue);
+    gameScore = 0;
+    largestTile = 0;
+    startRecording();
+}
+
+void MainWindow::startRecording()
+{
+    string source = ui->autoplayCheckBox->isChecked() ? "autoplay" : "player";
+    telemetryRecorder = TelemetryRecorder(telemetry.source(source));
+    telemetryRecorder.start_game(seedValue);
+
+    if ( ui->actionRecordGames->isChecked() ) {
+        string path = "game-" + to_string(seedValue) + ".frames";
+        if ( frameWriter.open(path, seedValue, targetValue, LEGACY_RNG,
+                              packedBoard) ) {
+            ui->statusbar->showMessage(QString::fromStdString(
+                    (!isFinnish ? "Recording to " : "Tallennetaan: ")
+                    + path));
+        }
+    }
+}
+
+void MainWindow::endRecording(GameState state)
+{
+    const SpawnRng& rng = gameBoard->rng();
+    telemetryRecorder.end_game(gameScore, packed::max_exponent(packedBoard),
+                               state, rng.spawns(), rng.spawn_retries());
+    telemetry.flush(telemetryRecorder);
+    frameWriter.finish(state);
 }
 
 void MainWindow::pauseTimer(bool toBePaused)
@@ -262,41 +462,24 @@ void MainWindow::clock()
     ui->secLcdNumber->display(time%60);
 }
 
-int MainWindow::maxValueOfBoard()
+void MainWindow::pointsUpdater(const MoveResult& result)
 {
-    // Go through board and find the largest value
-    // by comparing every value on the board
-    for ( uint y = 0; y < SIZE; ++y ) {
-        for ( uint x = 0; x < SIZE; ++x ) {
-            if ( gameBoard->get_item(make_pair(y,x))->get_value() > largestTile ) {
-                largestTile = gameBoard->get_item(make_pair(y,x))->get_value();
-            }
-        }
+    // The move tells the largest tile, so the board isn't searched
+    // for it. A value that doesn't fit in an int saturates.
+    int value = result.max_exponent <= MAX_VALUE_EXPONENT
+                ? 1 << result.max_exponent
+                : std::numeric_limits<int>::max();
+    if ( value > largestTile ) {
+        largestTile = value;
     }
-    return largestTile;
-}
-
-void MainWindow::pointsUpdater()
-{
-    // Get max value
-    int scoreToAdd = maxValueOfBoard();
-
-    // Get current score and add to it
-    QString textScore = ui->currentScoreTextBrowser->toPlainText();
-    gameScore = stoi(textScore.toStdString());
-    gameScore += scoreToAdd;
 
-    // Update the score
-    ui->currentScoreTextBrowser->setText(QString::number(gameScore));
+    // Add the max value to the current score
+    gameScore += largestTile;
 
     // Check if we are going to update highscore also
-    QString textHighscore = ui->highscoreTextBrowser->toPlainText();
-    gameHighscore = stoi(textHighscore.toStdString());
-
     if ( gameScore > gameHighscore ) {
         // Means we found a new highscore so update it
         gameHighscore = gameScore;
-        ui->highscoreTextBrowser->setText(QString::number(gameHighscore));
     }
 }
 
@@ -336,6 +519,9 @@ void MainWindow::pauseButtonChange(bool pause)
     isPaused = pause;
     disableBoard(pause);
     ui->resetPushButton->setDisabled(!pause);
+
+    // Autoplay pauses with the game
+    updateAutoplayState();
 }
 
 void MainWindow::disableArrowButtons(bool disable)
@@ -520,8 +706,8 @@ void MainWindow::lossMessageBox()
 void MainWindow::keyReleaseEvent(QKeyEvent *event)
 {
     // Only when the game is going on we want to
-    // be able to move
-    if ( !isPaused ) {
+    // be able to move, and not while autoplay is moving
+    if ( !isPaused && !autoplayTimer->isActive() ) {
         if (event->key() == Qt::Key_Down) {
             moveBoard(DOWN_DIRECTION);
         } else if ( event->key() == Qt::Key_Left) {
@@ -580,6 +766,59 @@ void MainWindow::on_actionPause_triggered()
     pauseGameBoard();
 }
 
+void MainWindow::on_actionHint_triggered()
+{
+    if ( !gameIsGoingOn || isPaused ) {
+        return;
+    }
+
+    const QString english[] = {"up", "right", "down", "left"};
+    const QString finnish[] = {"ylös", "oikealle", "alas", "vasemmalle"};
+    PackedBoard board = packedBoard;
+
+    // A tablebase of this target knows the best move at once
+    TablebaseAnswer answer;
+    if ( tablebase.is_open()
+         && int(tablebase.header().target_exponent) == targetValue
+         && tablebase.lookup(board, answer) && answer.win_probability > 0.0
+         && packed::move(board, answer.best).board != board ) {
+        QString chance = QString::number(answer.win_probability * 100,
+                                         'f', 1);
+        if ( !isFinnish ) {
+            ui->statusbar->showMessage("Hint: " + english[answer.best]
+                                       + " (tablebase, " + chance
+                                       + " % to win)");
+        } else {
+            ui->statusbar->showMessage("Vihje: " + finnish[answer.best]
+                                       + " (taulukko, voitto " + chance
+                                       + " %)");
+        }
+        return;
+    }
+
+    // Otherwise search for as long as one frame is shown
+    QElapsedTimer searchTime;
+    searchTime.start();
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now()
+            + chrono::milliseconds(frameTimer->interval());
+    Direction dir = UP;
+    if ( !hintStrategy.choose_until(board, dir, deadline) ) {
+        return;
+    }
+    qint64 nodesPerSecond = hintStrategy.last_nodes() * 1000000000
+                            / qMax<qint64>(1, searchTime.nsecsElapsed());
+
+    QString depth = QString::number(hintStrategy.last_depth());
+    QString speed = QString::number(nodesPerSecond / 1000) + "k";
+    if ( !isFinnish ) {
+        ui->statusbar->showMessage("Hint: " + english[dir] + " (depth "
+                                   + depth + ", " + speed + " nodes/s)");
+    } else {
+        ui->statusbar->showMessage("Vihje: " + finnish[dir] + " (syvyys "
+                                   + depth + ", " + speed + " solmua/s)");
+    }
+}
+
 
 void MainWindow::on_actionInstructions_triggered()
 {
@@ -606,8 +845,20 @@ void MainWindow::on_actionEnglish_triggered()
         ui->targetValueLabel2->setText("(as a power of 2)");
         ui->actionInstructions->setText("Instructions");
         ui->actionPause->setText("Pause");
+        ui->actionHint->setText("Hint");
         ui->actionQuit->setText("Quit");
         ui->actionReset->setText("Reset");
+        ui->autoplayCheckBox->setText("Autoplay");
+        ui->actionEasySeed->setText("Suggest an easy seed");
+        ui->actionHardSeed->setText("Suggest a hard seed");
+        ui->actionProceduralTiles->setText("Draw the tiles");
+        ui->actionExportTelemetry->setText("Export telemetry...");
+        ui->actionWatchBots->setText("Watch bots");
+        ui->actionOpenRecording->setText("Open recording...");
+        ui->actionRecordGames->setText("Record games");
+        ui->actionLoadStrategyPlugin->setText("Load strategy plugin...");
+        ui->speedSpinBox->setSuffix(" moves/s");
+        ui->speedSpinBox->setSpecialValueText("max");
         ui->menuLanguage->setTitle("Language");
         ui->menuHelp->setTitle("Help");
         ui->menuSettings->setTitle("Settings");
@@ -634,8 +885,21 @@ void MainWindow::on_actionSuomi_triggered()
         ui->targetValueLabel2->setText("(2 potenssina)");
         ui->actionInstructions->setText("Ohjeet");
         ui->actionPause->setText("Keskeytä");
+        ui->actionHint->setText("Vihje");
         ui->actionQuit->setText("Sulje");
         ui->actionReset->setText("Uusi peli");
+        ui->autoplayCheckBox->setText("Autopeli");
+        ui->actionEasySeed->setText("Ehdota helppoa siemenlukua");
+        ui->actionHardSeed->setText("Ehdota vaikeaa siemenlukua");
+        ui->actionProceduralTiles->setText("Piirrä laatat");
+        ui->actionExportTelemetry->setText("Vie telemetria...");
+        ui->actionWatchBots->setText("Seuraa botteja");
+        ui->actionOpenRecording->setText("Avaa tallenne...");
+        ui->actionRecordGames->setText("Tallenna pelit");
+        ui->actionLoadStrategyPlugin->setText(
+                    "Lataa strategialiitännäinen...");
+        ui->speedSpinBox->setSuffix(" siirtoa/s");
+        ui->speedSpinBox->setSpecialValueText("maks");
         ui->menuLanguage->setTitle("Kieli");
         ui->menuHelp->setTitle("Ohje");
         ui->menuSettings->setTitle("Asetukset");
@@ -663,6 +927,236 @@ void MainWindow::readPhotosIntoMap()
                          {65536, ":/icons/icons/65536.png"}};
 }
 
+QPixmap MainWindow::tilePixmap(int exponent, int size)
+{
+    // Use the photo, if there is one for the value and the photos
+    // are not turned off
+    if ( !ui->actionProceduralTiles->isChecked()
+         && exponent <= MAX_VALUE_EXPONENT ) {
+        auto photo = photoIconsByValue.find(1 << exponent);
+        if ( photo != photoIconsByValue.end() ) {
+            QPixmap& scaled = scaledPhotos[make_pair(exponent, size)];
+            if ( scaled.isNull() ) {
+                scaled = QPixmap(photo->second).scaled(size, size,
+                                                       Qt::KeepAspectRatio);
+            }
+            return scaled;
+        }
+    }
+
+    // Otherwise draw the tile, in the real pixel size of the screen
+    return tileRenderer.tile(exponent, size, devicePixelRatioF());
+}
+
+void MainWindow::on_actionProceduralTiles_toggled(bool checked)
+{
+    // Redraw the board with the other kind of tiles
+    boardItem->setAtlasEnabled(!checked);
+    if ( wallView != nullptr ) {
+        wallView->setAtlasEnabled(!checked);
+    }
+    if ( playbackView != nullptr ) {
+        playbackView->setAtlasEnabled(!checked);
+    }
+}
+
+bool MainWindow::eventFilter(QObject* watched, QEvent* event)
+{
+    if ( watched == ui->gameGraphicsView->viewport()
+         && event->type() == QEvent::Paint ) {
+        StartupTimeline& timeline = StartupTimeline::instance();
+        if ( timeline.elapsed("first frame") < 0 ) {
+            timeline.mark("first frame");
+            startAtlasBuild();
+            if ( timeline.exitAfterFirstFrame() ) {
+                QTimer::singleShot(0, qApp, [] {
+                    QCoreApplication::exit(
+                        StartupTimeline::instance().withinBudget() ? 0 : 1);
+                });
+            }
+        }
+        if ( firstMovePending ) {
+            firstMovePending = false;
+            timeline.mark("first move drawn");
+        }
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void MainWindow::startAtlasBuild()
+{
+    // Decode and scale the photos in a worker thread, the pixel size
+    // is the one of the screen the window is on
+    int tilePixels = qRound(slotSize * devicePixelRatioF());
+    atlasWatcher->setFuture(QtConcurrent::run(&TileAtlas::build,
+                                              photoIconsByValue,
+                                              tilePixels));
+}
+
+void MainWindow::atlasBuilt()
+{
+    tileAtlas = atlasWatcher->result();
+    tileAtlas.upload();
+    boardItem->update();
+    if ( wallView != nullptr ) {
+        wallView->setAtlas(&tileAtlas);
+    }
+    if ( playbackView != nullptr ) {
+        playbackView->setAtlas(&tileAtlas);
+    }
+    StartupTimeline::instance().mark("tile atlas ready");
+}
+
+void MainWindow::on_actionEasySeed_triggered()
+{
+    suggestSeed(true);
+}
+
+void MainWindow::on_actionHardSeed_triggered()
+{
+    suggestSeed(false);
+}
+
+void MainWindow::suggestSeed(bool easy)
+{
+    // The seed can only be changed before the game starts
+    if ( !ui->seedSpinBox->isEnabled() ) {
+        return;
+    }
+
+    // Start looking after the current seed, so that pressing again
+    // gives another seed
+    uint seed = 0;
+    uint start = ui->seedSpinBox->value() + 1 - seedIndex.header().first_seed;
+    if ( !seedIndex.suggest(easy, start, seed) ||
+         seed > uint(ui->seedSpinBox->maximum()) ) {
+        return;
+    }
+    ui->seedSpinBox->setValue(seed);
+
+    // Tell how hard the seed is
+    const SeedRecord* record = seedIndex.find(seed);
+    QString rate = QString::number(qRound(100 * win_rate(*record)));
+    QString target = QString::number(1 << seedIndex.header().target_exponent);
+    if ( !isFinnish ) {
+        ui->statusbar->showMessage("Seed " + QString::number(seed) + ": "
+                                   + rate + "% of the test games reached "
+                                   + target);
+    } else {
+        ui->statusbar->showMessage("Siemen " + QString::number(seed) + ": "
+                                   + rate + "% testipeleistä pääsi lukuun "
+                                   + target);
+    }
+}
+
+void MainWindow::on_actionWatchBots_triggered()
+{
+    if ( wallView == nullptr ) {
+        wallView = new WallView(WALL_ROWS, WALL_COLUMNS, WALL_SLOT_SIZE,
+                                WALL_STRATEGY);
+        wallView->setAtlas(&tileAtlas);
+        wallView->setFallback([this](int exponent) {
+            return tilePixmap(exponent, WALL_SLOT_SIZE);
+        });
+        wallView->setAtlasEnabled(!ui->actionProceduralTiles->isChecked());
+    }
+
+    // Start over from the seed chosen for the own game
+    if ( !wallView->isVisible() ) {
+        wallView->start(ui->seedSpinBox->value(), WALL_MOVES_PER_SECOND);
+    }
+    wallView->show();
+    wallView->raise();
+    wallView->activateWindow();
+}
+
+void MainWindow::on_actionOpenRecording_triggered()
+{
+    QString title = !isFinnish ? "Open recording" : "Avaa tallenne";
+    QString path = QFileDialog::getOpenFileName(this, title, QString(),
+                                                "*.frames");
+    if ( path.isEmpty() ) {
+        return;
+    }
+    if ( playbackView == nullptr ) {
+        playbackView = new PlaybackView(slotSize);
+        playbackView->setAtlas(&tileAtlas);
+        playbackView->setFallback([this](int exponent) {
+            return tilePixmap(exponent, slotSize);
+        });
+        playbackView->setAtlasEnabled(
+                    !ui->actionProceduralTiles->isChecked());
+    }
+    playbackView->setFinnish(isFinnish);
+    if ( !playbackView->openStream(path) ) {
+        ui->statusbar->showMessage(!isFinnish ? "Not a recording"
+                                              : "Ei tallenne");
+        return;
+    }
+    playbackView->show();
+    playbackView->raise();
+    playbackView->activateWindow();
+}
+
+void MainWindow::on_actionExportTelemetry_triggered()
+{
+    QString title = !isFinnish ? "Export telemetry" : "Vie telemetria";
+    QString path = QFileDialog::getSaveFileName(this, title, "telemetry");
+    if ( path.isEmpty() ) {
+        return;
+    }
+
+    // The same counters in both formats, next to each other
+    string prefix = path.toStdString();
+    bool ok = telemetry.write_prometheus(prefix + ".prom")
+              && telemetry.write_csv(prefix + ".csv");
+    QString games = QString::number(telemetry.games());
+    if ( !isFinnish ) {
+        ui->statusbar->showMessage(ok ? games + " games exported"
+                                      : "Export failed");
+    } else {
+        ui->statusbar->showMessage(ok ? games + " peliä viety"
+                                      : "Vienti epäonnistui");
+    }
+}
+
+void MainWindow::on_actionLoadStrategyPlugin_triggered()
+{
+    QString title = !isFinnish ? "Load strategy plugin"
+                               : "Lataa strategialiitännäinen";
+    QString path = QFileDialog::getOpenFileName(this, title, QString(),
+                                                "*.so *.dylib *.dll");
+    if ( path.isEmpty() ) {
+        return;
+    }
+    unique_ptr<PluginStrategy> plugin(
+                new PluginStrategy(path.toStdString()));
+    if ( !plugin->is_open() ) {
+        ui->statusbar->showMessage(!isFinnish
+                                   ? "Not a strategy plugin"
+                                   : "Ei strategialiitännäinen");
+        return;
+    }
+
+    // The game going on is played on by the plugin
+    QString name = QString::fromStdString(plugin->plugin_name());
+    plugin->start_game(seedValue);
+    autoplayStrategy = move(plugin);
+    ui->statusbar->showMessage((!isFinnish ? "Autoplay uses "
+                                           : "Autopeli käyttää: ") + name);
+}
+
+void MainWindow::on_autoplayCheckBox_toggled(bool)
+{
+    updateAutoplayState();
+}
+
+void MainWindow::on_speedSpinBox_valueChanged(int)
+{
+    // Restart the pacing with the new speed
+    updateAutoplayState();
+}
+
 void MainWindow::on_closePushButton_clicked()
 {
     this->close();
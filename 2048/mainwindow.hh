@@ -21,14 +21,25 @@
 #ifndef MAINWINDOW_HH
 #define MAINWINDOW_HH
 
+#include "boarditem.hh"
+#include "framestream.hh"
 #include "gameboard.hh"
+#include "playbackview.hh"
+#include "seedindex.hh"
+#include "strategy.hh"
+#include "telemetry.hh"
+#include "tileatlas.hh"
+#include "tilerenderer.hh"
+#include "wallview.hh"
 #include <QMainWindow>
 #include <QGraphicsScene>
 #include <QGraphicsRectItem>
-#include <QLabel>
+#include <QPixmap>
 #include <QString>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QMessageBox>
+#include <QFutureWatcher>
 #include <map>
 
 using namespace std;
@@ -46,6 +57,9 @@ public:
     ~MainWindow();
     void keyReleaseEvent(QKeyEvent* event) override;
 
+    // Marks the first frames on the startup timeline
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
 private slots:
     // Manages the start of the game
     void on_playPushButton_clicked();
@@ -74,6 +88,9 @@ private slots:
     void on_actionReset_triggered();
     void on_actionPause_triggered();
 
+    // Searches the best move for one frame and shows it
+    void on_actionHint_triggered();
+
     // Opens the instructions of the language used
     void on_actionInstructions_triggered();
 
@@ -81,6 +98,41 @@ private slots:
     void on_actionEnglish_triggered();
     void on_actionSuomi_triggered();
 
+    // Picks an easy or a hard seed from the seed index
+    void on_actionEasySeed_triggered();
+    void on_actionHardSeed_triggered();
+
+    // Switches between the photos and the drawn tiles
+    void on_actionProceduralTiles_toggled(bool checked);
+
+    // Opens the wall of games played by the strategy
+    void on_actionWatchBots_triggered();
+
+    // Plays back a recorded game
+    void on_actionOpenRecording_triggered();
+
+    // Writes the counters of the games played in this session
+    void on_actionExportTelemetry_triggered();
+
+    // Lets the autoplay use a strategy plugin, see numbers_strategy.h
+    void on_actionLoadStrategyPlugin_triggered();
+
+    // Takes the tile atlas in use, when the worker thread is done
+    void atlasBuilt();
+
+    // Starts or stops the autoplay mode
+    void on_autoplayCheckBox_toggled(bool checked);
+
+    // Applies the new autoplay speed
+    void on_speedSpinBox_valueChanged(int speed);
+
+    // Lets the built-in strategy make the moves that are due
+    void autoplayTick();
+
+    // Draws the current state of the game, called at most once
+    // per display refresh
+    void renderFrame();
+
 private:
     Ui::MainWindow *ui;
 
@@ -90,26 +142,55 @@ private:
     // Gameboard object
     GameBoard* gameBoard;
 
+    // The same board packed, kept up to date by stepGame with the
+    // moves and the new values, so it is never read from gameBoard
+    // again during a game
+    PackedBoard packedBoard = 0;
+
     // Creates the gameboard, as in adds rectangles
     // to the board, where the photos can move
     void createGameBoard() const;
 
-    // Empties the gameboard, by deleting and nulling all pointers
-    // to the labels
+    // Empties the gameboard, by removing all the tiles
+    // from the board item
     void emptyGameBoard();
 
-    // Uses method above to clear the table, and then fetches
-    // new values by going through the gameboard, and updates
-    // photos according to value
+    // Shows the current values of the gameboard in the board item,
+    // which only repaints the board if something changed
     void updateGameBoard();
 
+    // Result of a single move
+    enum GameOutcome { GAME_CONTINUES, GAME_WON, GAME_LOST };
+
+    // Moves the board in the given direction and adds the new value,
+    // but doesn't draw anything or open any messageboxes. A move that
+    // changes nothing is ignored, and the game is lost as soon as the
+    // new value leaves no move that changes the board.
+    GameOutcome stepGame(const pair<int,int> direction);
+
     // Moves the board in the given direction
     // takes the direction as an integer pair as a parameter
     void moveBoard(const pair<int,int> direction);
 
+    // Marks the board as changed, so that it is drawn on the next frame
+    void requestFrame();
+
+    // Starts or stops the autoplay timer according to the state
+    // of the game and the autoplay checkbox
+    void updateAutoplayState();
+
+    // Autoplay doesn't stop for messageboxes, instead it shows the
+    // result in the status bar and starts the game with the next seed
+    void autoplayNextGame(GameOutcome outcome);
+
     // Resets the game
     void resetGame();
 
+    // Starts counting the game that was just filled, and writing its
+    // frames if recording is on, and ends both with the given state
+    void startRecording();
+    void endRecording(GameState state);
+
     // Pauses the gameboard, and stays paused until unpaused again
     void pauseGameBoard();
 
@@ -124,9 +205,17 @@ private:
     // The user can either quit or try again
     void lossMessageBox();
 
+    // Sets the seed spinbox to a seed suggested by the seed index
+    void suggestSeed(bool easy);
+
     // Reads the photos from the resource folder in to a map
     void readPhotosIntoMap();
 
+    // Returns the picture of the tile with the value 2^exponent, size
+    // pixels wide, drawn by the tile renderer for the values that have
+    // no photo or when the photos are turned off
+    QPixmap tilePixmap(int exponent, int size);
+
     // Pauses the timer according to the boolean parameter
     void pauseTimer(bool toBePaused);
 
@@ -134,13 +223,13 @@ private:
     void clock();
     int time = 0;
 
-    // Finds the max value of the board
-    int maxValueOfBoard();
+    // The max value of the board
     int largestTile = 0;
 
-    // Counts and updates points by using the max value method to find
-    // how much to add
-    void pointsUpdater();
+    // Counts and updates points by using the largest tile after the
+    // move to find how much to add. The texts are updated on the next
+    // frame.
+    void pointsUpdater(const MoveResult& result);
 
     // Disables/resumes the moving of the board
     // takes a boolean telling whether to disable or not
@@ -187,6 +276,51 @@ private:
     // Timer
     QTimer* timer;
 
+    // Timer for drawing the board, runs once per display refresh
+    // when the board has changed
+    QTimer* frameTimer;
+
+    // Timer that drives the autoplay moves
+    QTimer* autoplayTimer;
+
+    // Search of the hints, its counters go to the status bar
+    AnytimeExpectimaxStrategy hintStrategy{chrono::milliseconds(16)};
+
+    // Strategy used by the autoplay, greedy until a plugin is loaded
+    unique_ptr<Strategy> autoplayStrategy{new GreedyStrategy};
+
+    // Wall of games played in the background, made when first opened
+    WallView* wallView = nullptr;
+    const int WALL_ROWS = 8;
+    const int WALL_COLUMNS = 8;
+    const int WALL_SLOT_SIZE = 24;
+    const int WALL_MOVES_PER_SECOND = 20;
+    const string WALL_STRATEGY = "greedy";
+
+    // Window for playing back recorded games, made when first opened
+    PlaybackView* playbackView = nullptr;
+
+    // Frames of the current game, when recording is on
+    FrameStreamWriter frameWriter;
+
+    // Counters of the games of this session, the games played by the
+    // user and by the autoplay are kept apart
+    Telemetry telemetry;
+    TelemetryRecorder telemetryRecorder;
+
+    // Measures the time since the autoplay (re)started, so fast speeds
+    // can be run in batches and still keep the given pace
+    QElapsedTimer autoplayClock;
+    qint64 autoplayMovesDone = 0;
+
+    // Speeds up to this many moves per second get a timer tick
+    // per move, faster ones are run in batches
+    const int MAX_TICK_RATE = 250;
+
+    // Maximum time in milliseconds one autoplay tick may use,
+    // so that drawing and input still get their turn
+    const int AUTOPLAY_BUDGET_MS = 8;
+
     // For controlling pause state
     bool isPaused = true;
 
@@ -205,15 +339,41 @@ private:
     // The size of the side of one box
     int slotSize = BOX_SIZE/SIZE;
 
-    // Vector for emptying the table
-    vector<QLabel*> tempLabels;
+    // Draws all the tiles of the board
+    BoardItem* boardItem;
+
+    // The photos packed in one pixmap, built in a worker thread
+    TileAtlas tileAtlas;
+    QFutureWatcher<TileAtlas>* atlasWatcher;
+
+    // Starts building the tile atlas in the background
+    void startAtlasBuild();
+
+    // The result of the first move is not drawn yet
+    bool firstMovePending = false;
 
     // Target value
     int targetValueCorrected = 0;
 
+    // Difficulty of the seeds, made with 'numbers_cli sweep'
+    SeedIndex seedIndex;
+    const string SEED_INDEX_FILE = "seedindex.bin";
+
+    // Exact answers for small games, made with 'numbers_cli tablebase'.
+    // The hint looks the board up in it, when the target matches.
+    Tablebase tablebase;
+    const string TABLEBASE_FILE = "tablebase.bin";
+
     // Photo map
     map<int, QString> photoIconsByValue;
 
+    // Photos scaled for the tiles by the exponent and the size, so that
+    // a photo is decoded and scaled only once while there is no atlas
+    map<pair<int, int>, QPixmap> scaledPhotos;
+
+    // Draws and caches the tiles that don't use the photos
+    TileRenderer tileRenderer;
+
     // Different directions for the move method
     const pair<int,int> RIGHT_DIRECTION = make_pair(0,1);
     const pair<int,int> LEFT_DIRECTION = make_pair(0,-1);
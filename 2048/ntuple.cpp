@@ -0,0 +1,285 @@
+#include "ntuple.hh"
+#include "gameboard.hh"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+// The cells of the tuples, y * 4 + x. Two rows and two boxes, which
+// see the lines, the corners and the merges between the rows.
+const int TUPLES[NTUPLE_COUNT][NTUPLE_CELLS] = {
+    {0, 1, 2, 3, 4, 5},
+    {4, 5, 6, 7, 8, 9},
+    {0, 1, 2, 4, 5, 6},
+    {4, 5, 6, 8, 9, 10}
+};
+
+// Bit positions of the cells of every tuple in every symmetry, so
+// that a lookup only shifts and masks
+struct LookupTable
+{
+    int shifts[NTUPLE_LOOKUPS][NTUPLE_CELLS];
+
+    LookupTable();
+};
+
+LookupTable::LookupTable()
+{
+    for( int t = 0; t < NTUPLE_COUNT; ++t )
+    {
+        for( int s = 0; s < SYMMETRY_COUNT; ++s )
+        {
+            for( int c = 0; c < NTUPLE_CELLS; ++c )
+            {
+                int y = 0;
+                int x = 0;
+                symmetry::map_cell(SIZE, s, TUPLES[t][c] / SIZE,
+                                   TUPLES[t][c] % SIZE, y, x);
+                shifts[t * SYMMETRY_COUNT + s][c] = 4 * (y * SIZE + x);
+            }
+        }
+    }
+}
+
+const LookupTable& lookups()
+{
+    static const LookupTable instance;
+    return instance;
+}
+
+const std::size_t TOTAL_WEIGHTS = NTUPLE_COUNT * NTUPLE_WEIGHTS;
+const std::size_t FILE_SIZE = sizeof(NTupleHeader) +
+                              TOTAL_WEIGHTS * sizeof(float);
+
+// Networks of shared_ntuple_network by their file
+std::mutex shared_networks_mutex;
+std::map<std::string, std::shared_ptr<const NTupleNetwork>> shared_networks;
+
+}
+
+void ntuple_indices(PackedBoard board,
+                    std::uint32_t indices[NTUPLE_LOOKUPS])
+{
+    const LookupTable& table = lookups();
+    for( int l = 0; l < NTUPLE_LOOKUPS; ++l )
+    {
+        std::uint32_t index = 0;
+        for( int c = 0; c < NTUPLE_CELLS; ++c )
+        {
+            index |= std::uint32_t((board >> table.shifts[l][c]) & 0xF)
+                     << (4 * c);
+        }
+        indices[l] = index;
+    }
+}
+
+NTupleNetwork::NTupleNetwork():
+    weights_(new std::atomic<float>[TOTAL_WEIGHTS]()), games_(0),
+    run_{0, 0, 0, 0, 0.0f}
+{
+}
+
+bool NTupleNetwork::load(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if( fd < 0 )
+    {
+        return false;
+    }
+    struct stat status;
+    if( fstat(fd, &status) != 0 or
+        std::size_t(status.st_size) != FILE_SIZE )
+    {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, FILE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if( data == MAP_FAILED )
+    {
+        return false;
+    }
+
+    // Check that the file is what it should be
+    const NTupleHeader* header = static_cast<NTupleHeader*>(data);
+    if( std::memcmp(header->magic, NTUPLE_MAGIC, 8) != 0 or
+        header->version != NTUPLE_VERSION or
+        header->tuples != NTUPLE_COUNT or
+        header->cells != NTUPLE_CELLS )
+    {
+        munmap(data, FILE_SIZE);
+        return false;
+    }
+
+    const float* weights = reinterpret_cast<const float*>(
+                static_cast<const char*>(data) + sizeof(NTupleHeader));
+    for( std::size_t i = 0; i < TOTAL_WEIGHTS; ++i )
+    {
+        weights_[i].store(weights[i], std::memory_order_relaxed);
+    }
+    games_ = header->games;
+    run_.first = header->run_first;
+    run_.end = header->run_end;
+    run_.score_sum = header->run_score_sum;
+    run_.reached = header->run_reached;
+    run_.learning_rate = header->run_learning_rate;
+    munmap(data, FILE_SIZE);
+    return true;
+}
+
+bool NTupleNetwork::save(const std::string& path) const
+{
+    std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if( fd < 0 or ftruncate(fd, FILE_SIZE) != 0 )
+    {
+        std::cerr << temporary << ": " << std::strerror(errno) << std::endl;
+        if( fd >= 0 )
+        {
+            close(fd);
+        }
+        return false;
+    }
+    void* data = mmap(nullptr, FILE_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    close(fd);
+    if( data == MAP_FAILED )
+    {
+        std::cerr << temporary << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    NTupleHeader* header = static_cast<NTupleHeader*>(data);
+    std::memset(header, 0, sizeof(NTupleHeader));
+    std::memcpy(header->magic, NTUPLE_MAGIC, sizeof(header->magic));
+    header->version = NTUPLE_VERSION;
+    header->tuples = NTUPLE_COUNT;
+    header->cells = NTUPLE_CELLS;
+    header->games = games();
+    header->run_first = run_.first;
+    header->run_end = run_.end;
+    header->run_score_sum = run_.score_sum;
+    header->run_reached = run_.reached;
+    header->run_learning_rate = run_.learning_rate;
+
+    // The trainer may still be changing the weights, every weight is
+    // saved as it was at some point during the copy
+    float* weights = reinterpret_cast<float*>(
+                static_cast<char*>(data) + sizeof(NTupleHeader));
+    for( std::size_t i = 0; i < TOTAL_WEIGHTS; ++i )
+    {
+        weights[i] = weights_[i].load(std::memory_order_relaxed);
+    }
+    msync(data, FILE_SIZE, MS_SYNC);
+    munmap(data, FILE_SIZE);
+
+    if( std::rename(temporary.c_str(), path.c_str()) != 0 )
+    {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t NTupleNetwork::games() const
+{
+    return games_.load(std::memory_order_relaxed);
+}
+
+void NTupleNetwork::add_games(std::uint64_t games)
+{
+    games_.fetch_add(games, std::memory_order_relaxed);
+}
+
+const NTupleRun& NTupleNetwork::run() const
+{
+    return run_;
+}
+
+void NTupleNetwork::set_run(const NTupleRun& run)
+{
+    run_ = run;
+}
+
+double NTupleNetwork::value(PackedBoard board) const
+{
+    std::uint32_t indices[NTUPLE_LOOKUPS];
+    ntuple_indices(board, indices);
+    double sum = 0.0;
+    for( int l = 0; l < NTUPLE_LOOKUPS; ++l )
+    {
+        sum += weights_[(l / SYMMETRY_COUNT) * NTUPLE_WEIGHTS + indices[l]]
+               .load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void NTupleNetwork::update(PackedBoard board, float delta)
+{
+    std::uint32_t indices[NTUPLE_LOOKUPS];
+    ntuple_indices(board, indices);
+    for( int l = 0; l < NTUPLE_LOOKUPS; ++l )
+    {
+        std::atomic<float>& weight =
+                weights_[(l / SYMMETRY_COUNT) * NTUPLE_WEIGHTS + indices[l]];
+        weight.store(weight.load(std::memory_order_relaxed) + delta,
+                     std::memory_order_relaxed);
+    }
+}
+
+float NTupleNetwork::weight(int tuple, std::uint32_t index) const
+{
+    return weights_[tuple * NTUPLE_WEIGHTS + index].load(
+                std::memory_order_relaxed);
+}
+
+bool NTupleNetwork::best_move(PackedBoard board, Direction& dir,
+                              PackedMove& result, double& value) const
+{
+    bool found = false;
+    for( int d = 0; d < DIRECTION_COUNT; ++d )
+    {
+        PackedMove candidate = packed::move(board, Direction(d));
+        if( candidate.board == board )
+        {
+            continue;
+        }
+        double candidate_value = candidate.score +
+                                 this->value(candidate.board);
+        if( not found or candidate_value > value )
+        {
+            found = true;
+            value = candidate_value;
+            dir = Direction(d);
+            result = candidate;
+        }
+    }
+    return found;
+}
+
+std::shared_ptr<const NTupleNetwork> shared_ntuple_network(
+        const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(shared_networks_mutex);
+    std::shared_ptr<const NTupleNetwork>& network = shared_networks[path];
+    if( not network )
+    {
+        std::shared_ptr<NTupleNetwork> loaded(new NTupleNetwork);
+        if( not loaded->load(path) )
+        {
+            shared_networks.erase(path);
+            return nullptr;
+        }
+        network = loaded;
+    }
+    return network;
+}
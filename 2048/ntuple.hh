@@ -0,0 +1,144 @@
+/* NTupleNetwork
+ *
+ * A learned value function of a packed board, written by NTupleTrainer
+ * and played by NTupleStrategy.
+ *
+ * The network looks at the board through NTUPLE_COUNT tuples of
+ * NTUPLE_CELLS cells each. Every tuple has a weight for every
+ * combination of the exponents in its cells, and the value of a board
+ * is the sum of the weights of all the tuples in all the 8 rotations
+ * and reflections of the board, so a board and its mirror image have
+ * the same value.
+ *
+ * The weights are atomics, so that the threads of the trainer can all
+ * update them at the same time without locks. A weight may lose an
+ * update when two threads change it at once, which learning doesn't
+ * mind.
+ *
+ * The weights are saved in a file with a header:
+ *
+ *      magic "2048NTUP" (8), version (4), tuples (4), cells (4),
+ *      reserved (4), games trained (8), run (32)
+ *
+ * followed by the weights of every tuple as floats in the byte order
+ * of the machine. The run is the NTupleRun of the training run that
+ * saved the file, all 0 in files of the runs that finished before it
+ * was added.
+*/
+
+#ifndef NTUPLE_HH
+#define NTUPLE_HH
+
+#include "packedboard.hh"
+#include "symmetry.hh"
+#include <atomic>
+#include <memory>
+#include <string>
+
+struct NTupleHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t tuples;
+    std::uint32_t cells;
+    std::uint32_t reserved;
+    std::uint64_t games;
+
+    // NTupleRun
+    std::uint64_t run_first;
+    std::uint64_t run_end;
+    std::uint64_t run_score_sum;
+    std::uint32_t run_reached;
+    float run_learning_rate;
+};
+
+static_assert(sizeof(NTupleHeader) == 64, "Unexpected header size");
+
+const char NTUPLE_MAGIC[8] = {'2', '0', '4', '8', 'N', 'T', 'U', 'P'};
+const std::uint32_t NTUPLE_VERSION = 1;
+
+const int NTUPLE_COUNT = 4;
+const int NTUPLE_CELLS = 6;
+
+// Weights of one tuple, one per exponent combination of its cells
+const std::size_t NTUPLE_WEIGHTS = std::size_t(1) << (4 * NTUPLE_CELLS);
+
+// Weights looked up for one board, the symmetries of the first tuple
+// first
+const int NTUPLE_LOOKUPS = NTUPLE_COUNT * SYMMETRY_COUNT;
+
+// Puts the position of every weight of the board in its tuple in
+// indices, lookup l being in the tuple l / SYMMETRY_COUNT.
+void ntuple_indices(PackedBoard board,
+                    std::uint32_t indices[NTUPLE_LOOKUPS]);
+
+// Progress of the training run that saved a network, so that a run
+// that was stopped can be continued where it was
+struct NTupleRun
+{
+    // Games trained when the run started and when it is done, the run
+    // is unfinished when the network has fewer than end games
+    std::uint64_t first;
+    std::uint64_t end;
+
+    // Sum of the scores of the games of the run so far, and the number
+    // of them that reached 2048
+    std::uint64_t score_sum;
+    std::uint32_t reached;
+
+    // Learning rate of one update
+    float learning_rate;
+};
+
+class NTupleNetwork
+{
+public:
+    // Constructor, all the weights are 0.
+    NTupleNetwork();
+
+    NTupleNetwork(const NTupleNetwork&) = delete;
+    NTupleNetwork& operator=(const NTupleNetwork&) = delete;
+
+    // Reads the weights from the given file. Returns false, if the
+    // file doesn't exist or isn't a network.
+    bool load(const std::string& path);
+
+    // Writes the weights to the given file. The file is written next
+    // to it and renamed in place, so a crash never leaves half a file.
+    bool save(const std::string& path) const;
+
+    // Number of games the network has been trained with.
+    std::uint64_t games() const;
+    void add_games(std::uint64_t games);
+
+    // Training run that the network was saved in.
+    const NTupleRun& run() const;
+    void set_run(const NTupleRun& run);
+
+    // Value of the board, the score the network expects from it.
+    double value(PackedBoard board) const;
+
+    // Adds delta to the weights of the board.
+    void update(PackedBoard board, float delta);
+
+    // Weight at the given position of the given tuple.
+    float weight(int tuple, std::uint32_t index) const;
+
+    // Finds the move whose board after the slide has the best score
+    // plus value. Returns false, if no move changes the board.
+    bool best_move(PackedBoard board, Direction& dir, PackedMove& result,
+                   double& value) const;
+
+private:
+    std::unique_ptr<std::atomic<float>[]> weights_;
+    std::atomic<std::uint64_t> games_;
+    NTupleRun run_;
+};
+
+// Returns the network in the given file, loading it on the first call.
+// Returns nullptr, if the file can't be loaded. The strategies of all
+// the threads share one copy of the weights.
+std::shared_ptr<const NTupleNetwork> shared_ntuple_network(
+        const std::string& path);
+
+#endif // NTUPLE_HH
@@ -0,0 +1,281 @@
+#include "ntupletrainer.hh"
+#include "packedgame.hh"
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Number of games a thread takes at a time
+const std::uint64_t CHUNK_SIZE = 16;
+
+// How often the progress is printed
+const int PROGRESS_INTERVAL_MS = 10000;
+
+// How often the main thread checks on the workers
+const int POLL_INTERVAL_MS = 100;
+
+// Exponent of the tile reported in the progress, 2048
+const int REPORTED_EXPONENT = 11;
+
+}
+
+NTupleTrainer::NTupleTrainer(NTupleNetwork& network, int threads,
+                             double learning_rate):
+    network_(network), threads_(threads),
+    learning_rate_(learning_rate / (NTUPLE_COUNT * SYMMETRY_COUNT))
+{
+    if( threads_ <= 0 )
+    {
+        threads_ = std::thread::hardware_concurrency();
+    }
+    if( threads_ <= 0 )
+    {
+        threads_ = 1;
+    }
+}
+
+bool NTupleTrainer::run(std::uint64_t games, const std::string& path,
+                        int checkpoint_seconds, std::ostream& progress)
+{
+    // A continued run plays new seeds, a stopped one the seeds it
+    // didn't get to
+    NTupleRun run = network_.run();
+    if( run.end > network_.games() )
+    {
+        learning_rate_ = run.learning_rate;
+        progress << "Resuming the run at game "
+                 << network_.games() - run.first << " of "
+                 << run.end - run.first << std::endl;
+    }
+    else
+    {
+        run.first = network_.games();
+        run.end = run.first + games;
+        run.score_sum = 0;
+        run.reached = 0;
+        run.learning_rate = learning_rate_;
+    }
+    std::uint64_t first_seed = network_.games();
+    games = run.end - first_seed;
+
+    std::atomic<std::uint64_t> next_chunk(0);
+    std::atomic<std::uint64_t> played(0);
+    std::atomic<std::uint64_t> score_sum(run.score_sum);
+    std::atomic<std::uint64_t> reached(run.reached);
+
+    // The threads wait here between their chunks while a checkpoint is
+    // taken. A thread that has no chunk left counts as stopped.
+    std::atomic<bool> pausing(false);
+    std::mutex pause_mutex;
+    std::condition_variable pause_changed;
+    int stopped = 0;
+
+    std::vector<std::thread> workers;
+    for( int t = 0; t < threads_; ++t )
+    {
+        workers.push_back(std::thread([&]()
+        {
+            while( true )
+            {
+                if( pausing )
+                {
+                    std::unique_lock<std::mutex> lock(pause_mutex);
+                    ++stopped;
+                    pause_changed.notify_all();
+                    pause_changed.wait(lock, [&]() { return not pausing; });
+                    --stopped;
+                }
+                std::uint64_t first = next_chunk.fetch_add(CHUNK_SIZE);
+                if( first >= games )
+                {
+                    std::lock_guard<std::mutex> lock(pause_mutex);
+                    ++stopped;
+                    pause_changed.notify_all();
+                    break;
+                }
+                std::uint64_t last = first + CHUNK_SIZE < games ?
+                            first + CHUNK_SIZE : games;
+                std::uint64_t scores = 0;
+                std::uint64_t wins = 0;
+                for( std::uint64_t i = first; i < last; ++i )
+                {
+                    std::uint32_t score = 0;
+                    int max_exponent = 0;
+                    play(first_seed + i, score, max_exponent);
+                    scores += score;
+                    if( max_exponent >= REPORTED_EXPONENT )
+                    {
+                        ++wins;
+                    }
+                }
+                network_.add_games(last - first);
+                score_sum += scores;
+                reached += wins;
+                played += last - first;
+            }
+        }));
+    }
+
+    // Report and save while the workers play
+    bool ok = true;
+    pid_t saver = -1;
+    std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point reported = begin;
+    std::chrono::steady_clock::time_point saved = begin;
+    std::uint64_t reported_games = 0;
+    std::uint64_t reported_scores = score_sum;
+    std::uint64_t reported_wins = reached;
+    while( played < games )
+    {
+        std::this_thread::sleep_for(
+                    std::chrono::milliseconds(POLL_INTERVAL_MS));
+        std::chrono::steady_clock::time_point now =
+                std::chrono::steady_clock::now();
+        if( now - reported >= std::chrono::milliseconds(PROGRESS_INTERVAL_MS) )
+        {
+            // The statistics are of the games since the last report
+            std::uint64_t done = played;
+            std::uint64_t scores = score_sum;
+            std::uint64_t wins = reached;
+            double seconds = std::chrono::duration<double>(
+                        now - reported).count();
+            std::uint64_t count = done - reported_games;
+            progress << network_.games() << " games, "
+                     << count / seconds << " games/s, mean score "
+                     << (count == 0 ? 0 : (scores - reported_scores) / count)
+                     << ", 2048 in "
+                     << (count == 0 ? 0.0 :
+                         100.0 * (wins - reported_wins) / count) << "%"
+                     << std::endl;
+            reported = now;
+            reported_games = done;
+            reported_scores = scores;
+            reported_wins = wins;
+        }
+        // A checkpoint waits for the one before it to be written
+        ok = wait_for_save(saver, false) and ok;
+        if( now - saved >= std::chrono::seconds(checkpoint_seconds) and
+            saver < 0 )
+        {
+            std::unique_lock<std::mutex> lock(pause_mutex);
+            pausing = true;
+            pause_changed.wait(lock, [&]() { return stopped == threads_; });
+            run.score_sum = score_sum;
+            run.reached = std::uint32_t(reached);
+            network_.set_run(run);
+            saver = save_in_background(path);
+            ok = saver >= 0 and ok;
+            pausing = false;
+            pause_changed.notify_all();
+            saved = now;
+        }
+    }
+    for( std::thread& worker : workers )
+    {
+        worker.join();
+    }
+    ok = wait_for_save(saver, true) and ok;
+
+    double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+    std::uint64_t run_games = run.end - run.first;
+    progress << "Trained " << games << " games in " << seconds << " s, "
+             << games / seconds << " games/s on " << threads_ << " threads"
+             << std::endl;
+    progress << "The run of " << run_games << " games: mean score "
+             << (run_games == 0 ? 0 : score_sum / run_games) << ", 2048 in "
+             << (run_games == 0 ? 0.0 : 100.0 * reached / run_games) << "%"
+             << std::endl;
+    run.score_sum = score_sum;
+    run.reached = std::uint32_t(reached);
+    network_.set_run(run);
+    return network_.save(path) and ok;
+}
+
+pid_t NTupleTrainer::save_in_background(const std::string& path)
+{
+    pid_t pid = fork();
+    if( pid == 0 )
+    {
+        // Only this thread lives in the child, and the others were
+        // stopped outside of any lock
+        _exit(network_.save(path) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    if( pid < 0 )
+    {
+        std::cerr << "fork: " << std::strerror(errno) << std::endl;
+    }
+    return pid;
+}
+
+bool NTupleTrainer::wait_for_save(pid_t& saver, bool block)
+{
+    if( saver < 0 )
+    {
+        return true;
+    }
+    int status = 0;
+    pid_t result = waitpid(saver, &status, block ? 0 : WNOHANG);
+    if( result == 0 )
+    {
+        return true;
+    }
+    saver = -1;
+    if( result < 0 or not WIFEXITED(status) or
+        WEXITSTATUS(status) != EXIT_SUCCESS )
+    {
+        std::cerr << "A checkpoint wasn't saved" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void NTupleTrainer::play(std::uint64_t seed, std::uint32_t& score,
+                         int& max_exponent)
+{
+    PackedGame game;
+    game.start(int(seed & 0x7FFFFFFF), NO_GOAL, FAST_RNG);
+
+    Direction dir;
+    PackedMove move;
+    double value = 0.0;
+    if( not network_.best_move(game.board(), dir, move, value) )
+    {
+        return;
+    }
+    PackedBoard after = move.board;
+    while( true )
+    {
+        // The value of the board after a slide is learned from the
+        // value of the board after the next one
+        double target = 0.0;
+        PackedBoard next = 0;
+        bool playing = game.step(dir) == PLAYING and
+                       network_.best_move(game.board(), dir, move, value);
+        if( playing )
+        {
+            target = value;
+            next = move.board;
+        }
+        network_.update(after, learning_rate_
+                               * float(target - network_.value(after)));
+        if( not playing )
+        {
+            break;
+        }
+        after = next;
+    }
+    score = game.score();
+    max_exponent = packed::max_exponent(game.board());
+}
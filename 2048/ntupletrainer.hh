@@ -0,0 +1,75 @@
+/* NTupleTrainer
+ *
+ * Teaches an NTupleNetwork by playing against itself with temporal
+ * difference learning. Every move is chosen by the network, and the
+ * value of the board after the previous slide is moved towards the
+ * score and value of the next one, and towards 0 when the game is
+ * lost.
+ *
+ * The games are played on all the cores with the fast generator.
+ * Every thread plays its own games and updates the shared weights
+ * without locks, see NTupleNetwork. Game i of the network is played
+ * with seed i, so the games need no generator state of their own.
+ *
+ * The network is saved to the given file every now and then and when
+ * the training ends, with the progress of the run (NTupleRun). For a
+ * checkpoint the threads stop between their chunks of games, so that
+ * the weights have every game before the saved count and nothing of
+ * the games after it. The process then forks, and the child writes the
+ * weights as they were at the fork while the threads go on: the pages
+ * are copied only when the threads change them. A run that is stopped
+ * loses at most one interval of work, and running it again continues
+ * it from the checkpoint. With one thread the weights then end up the
+ * same, bit for bit, as if the run hadn't been stopped. More threads
+ * update the weights in a different order on every run anyway.
+*/
+
+#ifndef NTUPLETRAINER_HH
+#define NTUPLETRAINER_HH
+
+#include "ntuple.hh"
+#include <ostream>
+#include <string>
+#include <sys/types.h>
+
+const double DEFAULT_LEARNING_RATE = 0.1;
+const int DEFAULT_CHECKPOINT_SECONDS = 600;
+
+class NTupleTrainer
+{
+public:
+    // Constructor, 0 threads means one per core. The learning rate is
+    // the share of the error corrected by one update.
+    NTupleTrainer(NTupleNetwork& network, int threads = 0,
+                  double learning_rate = DEFAULT_LEARNING_RATE);
+
+    // Plays the given number of games, saving the network to the file
+    // every checkpoint_seconds and at the end. If the network was saved
+    // by a run that didn't finish, plays the rest of its games with its
+    // learning rate instead. Prints the games per second, the mean
+    // score and the share of games that reached 2048 every now and then
+    // and for the whole run at the end. Returns false, if the network
+    // can't be saved. Must be called when the process has no other
+    // threads, the checkpoints are written by a forked process.
+    bool run(std::uint64_t games, const std::string& path,
+             int checkpoint_seconds, std::ostream& progress);
+
+private:
+    NTupleNetwork& network_;
+    int threads_;
+    float learning_rate_;
+
+    // Plays and learns one game, returns its score and largest tile.
+    void play(std::uint64_t seed, std::uint32_t& score, int& max_exponent);
+
+    // Saves the network in a forked process, which is left running.
+    // Returns its pid, or -1 if it can't be started.
+    pid_t save_in_background(const std::string& path);
+
+    // Checks on the process of a checkpoint, if there is one, or waits
+    // for it to end. saver becomes -1 when it has ended. Returns false,
+    // if the checkpoint failed.
+    bool wait_for_save(pid_t& saver, bool block);
+};
+
+#endif // NTUPLETRAINER_HH
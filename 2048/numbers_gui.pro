@@ -1,6 +1,6 @@
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 CONFIG += c++11
 
@@ -9,19 +9,65 @@ CONFIG += c++11
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    boarditem.cpp \
+    compactboard.cpp \
+    framestream.cpp \
     gameboard.cpp \
     main.cpp \
     mainwindow.cpp \
-    numbertile.cpp
+    ntuple.cpp \
+    numbertile.cpp \
+    packedboard.cpp \
+    packedgame.cpp \
+    playbackview.cpp \
+    quantizedntuple.cpp \
+    rng.cpp \
+    seedindex.cpp \
+    startuptimeline.cpp \
+    strategy.cpp \
+    strategyplugin.cpp \
+    symmetry.cpp \
+    tablebase.cpp \
+    telemetry.cpp \
+    tileatlas.cpp \
+    tilerenderer.cpp \
+    transpositiontable.cpp \
+    wallgames.cpp \
+    wallview.cpp
 
 HEADERS += \
+    boarditem.hh \
+    compactboard.hh \
+    framestream.hh \
     gameboard.hh \
     mainwindow.hh \
-    numbertile.hh
+    ntuple.hh \
+    numbers_strategy.h \
+    numbertile.hh \
+    packedboard.hh \
+    packedgame.hh \
+    playbackview.hh \
+    quantizedntuple.hh \
+    rng.hh \
+    seedindex.hh \
+    startuptimeline.hh \
+    strategy.hh \
+    strategyplugin.hh \
+    symmetry.hh \
+    tablebase.hh \
+    telemetry.hh \
+    tileatlas.hh \
+    tilerenderer.hh \
+    transpositiontable.hh \
+    wallgames.hh \
+    wallview.hh
 
 FORMS += \
     mainwindow.ui
 
+# The strategy plugins are loaded with dlopen
+unix: LIBS += -ldl
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
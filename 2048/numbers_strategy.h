@@ -0,0 +1,77 @@
+/* numbers_strategy.h
+ *
+ * The C interface of a strategy plugin: a shared library that plays
+ * the game for the GUI autoplay ("Load strategy plugin...") and for
+ * the batch tools of numbers_cli ("plugin:<file>"), without building
+ * either of them again.
+ *
+ * The library exports one function, numbers_strategy_api, that
+ * returns a pointer to a table of the functions below, which must stay
+ * valid until the library is unloaded. The table starts with the
+ * version of the interface and its own size, so fields can later be
+ * added to its end without breaking the plugins built before.
+ *
+ * A board is 64 bits, one nibble per cell: cell (y, x) of the 4x4
+ * board is in bits 4 * (4 * y + x) .. 4 * (4 * y + x) + 3, and holds
+ * the exponent of the tile, 0 for an empty cell, 1 for 2, 2 for 4 and
+ * so on up to 15. The directions are 0 up, 1 right, 2 down, 3 left.
+ *
+ * The boards come in batches of games that are played at the same
+ * time, so the cost of the call is paid once per batch. Every thread
+ * of the host creates its own instance, an instance is only used by
+ * one thread at a time.
+*/
+
+#ifndef NUMBERS_STRATEGY_H
+#define NUMBERS_STRATEGY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUMBERS_STRATEGY_ABI_VERSION 1
+
+#if defined(_WIN32)
+#define NUMBERS_STRATEGY_EXPORT __declspec(dllexport)
+#else
+#define NUMBERS_STRATEGY_EXPORT __attribute__((visibility("default")))
+#endif
+
+typedef struct numbers_strategy
+{
+    /* NUMBERS_STRATEGY_ABI_VERSION and sizeof(numbers_strategy) */
+    uint32_t abi_version;
+    uint32_t struct_size;
+
+    /* Name shown to the user */
+    const char* name;
+
+    /* Creates an instance, NULL if that fails. */
+    void* (*create)(void);
+
+    /* Destroys an instance. */
+    void (*destroy)(void* instance);
+
+    /* Called before a game with its seed, or before a batch of games
+     * with the seed of the first one, so that a randomized strategy
+     * can be repeated. May be NULL. */
+    void (*start_game)(void* instance, uint32_t seed);
+
+    /* Writes a direction for each of the count boards. A value above 3,
+     * or a direction that doesn't change its board, is replaced with
+     * the first direction that does. */
+    void (*choose)(void* instance, const uint64_t* boards, uint32_t count,
+                   uint8_t* directions);
+} numbers_strategy;
+
+/* The function a plugin exports */
+typedef const numbers_strategy* (*numbers_strategy_api_function)(void);
+#define NUMBERS_STRATEGY_API_SYMBOL "numbers_strategy_api"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NUMBERS_STRATEGY_H */
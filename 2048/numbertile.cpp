@@ -3,13 +3,33 @@
 #include <iomanip>
 #include <iostream>
 
+namespace
+{
+
+// Exponent that doesn't fit in a tile
+const int EXPONENT_LIMIT = 256;
+
+int exponent_of(int value)
+{
+    int exponent = 0;
+    while( value > 1 )
+    {
+        value /= 2;
+        ++exponent;
+    }
+    return exponent;
+}
+
+}
+
 Coords operator+(Coords lhs, Coords rhs)
 {
     return std::make_pair(lhs.first + rhs.first, lhs.second + rhs.second);
 }
 
 NumberTile::NumberTile(int value, Coords coords, GameBoard* board):
-    value_(value), coords_(coords), board_(board), is_merged_(false)
+    exponent_(exponent_of(value)), coords_(coords), board_(board),
+    is_merged_(false)
 {
 }
 
@@ -17,46 +37,63 @@ NumberTile::~NumberTile()
 {
 }
 
-void NumberTile::print(int width)
+void NumberTile::print(int width, std::ostream& out)
 {
-    std::cout << "|" << std::setw(width - 1) << value_;
+    // A value get_value() can't tell is printed as a power of two
+    out << "|" << std::setw(width - 1);
+    if( exponent_ > MAX_VALUE_EXPONENT )
+    {
+        out << "2^" + std::to_string(exponent_);
+    }
+    else
+    {
+        out << get_value();
+    }
 }
 
-bool NumberTile::move(Coords direction, const int goal_val)
+NumberTile* NumberTile::move(Coords direction, bool& moved)
 {
+    // An empty tile has nothing to move
+    if( exponent_ == 0 )
+    {
+        return nullptr;
+    }
     Coords curr_loc = coords_;
     Coords new_loc = coords_ + direction;
     while( is_on_board( new_loc ) )
     {
         NumberTile* curr = board_->get_item(curr_loc);
         NumberTile* dest = board_->get_item(new_loc);
-        if( dest->value_ == 0 )
+        if( dest->exponent_ == 0 )
         {
-            dest->value_ = curr->value_;
+            dest->exponent_ = curr->exponent_;
             dest->is_merged_ = curr->is_merged_;
-            curr->value_ = 0;
+            curr->exponent_ = 0;
             curr->is_merged_ = false;
+            moved = true;
         }
-        else if( dest->value_ == curr->value_ and
+        else if( dest->exponent_ == curr->exponent_ and
                  not dest->is_merged_ and
-                 not curr->is_merged_ )
+                 not curr->is_merged_ and
+                 curr->exponent_ + 1 < EXPONENT_LIMIT )
         {
-            dest->value_ = 2 * curr->value_;
-            curr->value_ = 0;
+            dest->exponent_ = curr->exponent_ + 1;
+            curr->exponent_ = 0;
             dest->is_merged_ = true;
-            return dest->value_ == goal_val;
+            moved = true;
+            return dest;
         }
         curr_loc = new_loc;
         new_loc = dest->coords_ + direction;
     }
-    return false;
+    return nullptr;
 }
 
 bool NumberTile::new_value(int new_val)
 {
-    if( value_ == 0 )
+    if( exponent_ == 0 )
     {
-        value_ = new_val;
+        exponent_ = exponent_of(new_val);
         return true;
     }
     return false;
@@ -64,7 +101,7 @@ bool NumberTile::new_value(int new_val)
 
 bool NumberTile::is_empty()
 {
-    return value_ == 0;
+    return exponent_ == 0;
 }
 
 void NumberTile::reset_turn()
@@ -74,11 +111,25 @@ void NumberTile::reset_turn()
 
 int NumberTile::get_value()
 {
-    return value_;
+    if( exponent_ == 0 or exponent_ > MAX_VALUE_EXPONENT )
+    {
+        return 0;
+    }
+    return 1 << exponent_;
+}
+
+int NumberTile::get_exponent()
+{
+    return exponent_;
+}
+
+void NumberTile::set_exponent(int exponent)
+{
+    exponent_ = exponent;
 }
 
 bool NumberTile::is_on_board(Coords coords)
 {
-    return coords.first >= 0 and coords.first < SIZE and
-           coords.second >= 0 and coords.second < SIZE;
+    return coords.first >= 0 and coords.first < board_->size() and
+           coords.second >= 0 and coords.second < board_->size();
 }
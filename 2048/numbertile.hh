@@ -3,6 +3,10 @@
  * The 'get_value()' method was added by me
  * to have easier access to the value of certain tile.
  *
+ * The value is stored as its exponent in one byte, 0 meaning an empty
+ * tile, so tiles up to 2^255 fit in it. get_value() can only tell
+ * values up to 2^30, get_exponent() works for all of them.
+ *
  * Program editor:
  *
  * Name: Kian Moloney
@@ -13,30 +17,37 @@
 #ifndef NUMBERTILE_HH
 #define NUMBERTILE_HH
 
+#include <cstdint>
+#include <iostream>
 #include <vector>
 #include <string>
 
 using Coords = std::pair<int, int>;
 
+// Exponent of the largest value get_value() can return, the largest
+// power of two that fits in an int
+const int MAX_VALUE_EXPONENT = 30;
+
 // Forward declaration, to avoid circular include's
 class GameBoard;
 
 class NumberTile
 {
 public:
-    // Constructor
+    // Constructor, the value must be 0 or a power of two
     NumberTile(int value, Coords coords, GameBoard* board);
 
     // Destructor
     ~NumberTile();
 
-    // Prints the number tile.
-    void print(int width);
+    // Prints the number tile, its left border and its value in width
+    // characters, values above 2^30 as "2^e".
+    void print(int width, std::ostream& out = std::cout);
 
     // Moves the number tile in the given direction and merges it, if possible.
-    // Returns true, if the player won the game, i.e. if the goal value was
-    // reached, otherwise returns false.
-    bool move(Coords direction, int goal_val);
+    // Sets moved to true, if the tile moved or merged. Returns the tile it
+    // merged into, or nullptr if it didn't merge.
+    NumberTile* move(Coords direction, bool& moved);
 
     // Sets a new value for an empty number tile.
     // Returns true, if a new value was set, otherwise returns false.
@@ -51,9 +62,15 @@ public:
     // Gets the integer value of certain NumberTile object
     int get_value();
 
+    // Gets the exponent of the value, 0 for an empty tile
+    int get_exponent();
+
+    // Sets the exponent of the value, 0 makes the tile empty
+    void set_exponent(int exponent);
+
 private:
-    // Value in the number tile
-    int value_;
+    // Exponent of the value in the number tile, 0 if the tile is empty
+    std::uint8_t exponent_;
 
     // Coordinates of the number tile
     Coords coords_;
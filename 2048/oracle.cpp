@@ -0,0 +1,578 @@
+#include "oracle.hh"
+#include "compactboard.hh"
+#include "gameboard.hh"
+#include "rng.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <tuple>
+
+namespace
+{
+
+// Board sizes of the CompactBoard cases
+const int MIN_BOARD_SIZE = 2;
+const int MAX_BOARD_SIZE = 8;
+
+// Percentage of the cases that are 4x4, so PackedBoard can be checked
+const std::uint32_t FOUR_BY_FOUR_SHARE = 70;
+
+// Largest exponent whose value NumberTile::get_value can return,
+// larger goals could never be reached
+const int MAX_GOAL_EXPONENT = 30;
+
+// Most moves made in the game between two boards taken from it
+const std::uint32_t MAX_GAME_MOVES = 4;
+
+// Cases drawn from one part of the stream, with games of their own
+const std::uint64_t CASE_BLOCK_SIZE = 16384;
+
+const char* const DIRECTION_NAMES[] = {"up", "right", "down", "left"};
+
+// The kinds of boards made by make_case
+enum BoardKind { RANDOM_BOARD, RUN_BOARD, FULL_BOARD, CAP_BOARD,
+                 GAME_BOARD, BOARD_KIND_COUNT };
+
+// Result of moving a board with one engine
+struct Outcome
+{
+    std::vector<std::uint8_t> cells;
+    bool moved;
+    std::uint64_t score;
+    bool won;
+};
+
+// The legacy engine, with a gameboard for every size
+class LegacyEngine
+{
+public:
+    LegacyEngine()
+    {
+        for( int size = MIN_BOARD_SIZE; size <= MAX_BOARD_SIZE; ++size )
+        {
+            boards_.push_back(std::unique_ptr<GameBoard>(new GameBoard(size)));
+            boards_.back()->init_empty();
+            boards_.back()->fill(0);
+        }
+    }
+
+    Outcome move(const OracleCase& c)
+    {
+        GameBoard& board = *boards_.at(c.size - MIN_BOARD_SIZE);
+        for( int y = 0; y < c.size; ++y )
+        {
+            for( int x = 0; x < c.size; ++x )
+            {
+                board.get_item(std::make_pair(y, x))
+                        ->set_exponent(c.cells[y * c.size + x]);
+            }
+        }
+
+        MoveResult move = board.move(packed::to_coords(c.dir),
+                                     1 << c.goal_exponent);
+        Outcome result;
+        result.moved = move.moved;
+        result.score = move.score;
+        result.won = move.won;
+        result.cells.resize(c.cells.size());
+        for( int y = 0; y < c.size; ++y )
+        {
+            for( int x = 0; x < c.size; ++x )
+            {
+                result.cells[y * c.size + x] =
+                        board.get_item(std::make_pair(y, x))->get_exponent();
+            }
+        }
+        return result;
+    }
+
+private:
+    std::vector<std::unique_ptr<GameBoard>> boards_;
+};
+
+int max_cell(const std::vector<std::uint8_t>& cells)
+{
+    return cells.empty() ? 0 : *std::max_element(cells.begin(), cells.end());
+}
+
+// PackedBoard can only be compared on 4x4 boards without 2^15 tiles
+bool packed_applies(const OracleCase& c)
+{
+    return c.size == 4 and max_cell(c.cells) < MAX_PACKED_EXPONENT;
+}
+
+Outcome packed_move(const OracleCase& c)
+{
+    PackedBoard board = 0;
+    for( int i = 0; i < 16; ++i )
+    {
+        board |= PackedBoard(c.cells[i]) << (4 * i);
+    }
+    PackedMove move = packed::move(board, c.dir);
+
+    Outcome result;
+    result.cells.resize(16);
+    for( int i = 0; i < 16; ++i )
+    {
+        result.cells[i] = (move.board >> (4 * i)) & 0xF;
+    }
+    result.moved = move.board != board;
+    result.score = move.score;
+    result.won = (move.merged_mask >> c.goal_exponent) & 1;
+    return result;
+}
+
+// CompactBoard doesn't tell every merged exponent, so its win is
+// not compared
+Outcome compact_move(const OracleCase& c)
+{
+    CompactBoard board(c.size);
+    for( int i = 0; i < c.size * c.size; ++i )
+    {
+        board.set_exponent(i / c.size, i % c.size, c.cells[i]);
+    }
+    CompactMove move = board.move(c.dir);
+
+    Outcome result;
+    result.cells.resize(c.cells.size());
+    for( int i = 0; i < c.size * c.size; ++i )
+    {
+        result.cells[i] = board.get_exponent(i / c.size, i % c.size);
+    }
+    result.moved = move.moved;
+    result.score = move.score;
+    result.won = false;
+    return result;
+}
+
+bool differs(const Outcome& expected, const Outcome& actual, bool won)
+{
+    return actual.cells != expected.cells or
+           actual.moved != expected.moved or
+           actual.score != expected.score or
+           (won and actual.won != expected.won);
+}
+
+bool packed_differs(LegacyEngine& legacy, const OracleCase& c)
+{
+    return differs(legacy.move(c), packed_move(c), true);
+}
+
+bool compact_differs(LegacyEngine& legacy, const OracleCase& c)
+{
+    return differs(legacy.move(c), compact_move(c), false);
+}
+
+// Returns a number in [low, high].
+int between(FastRng& rng, int low, int high)
+{
+    return low + rng.uniform(high - low + 1);
+}
+
+// Makes a new case, games has a game in progress for every size
+OracleCase make_case(FastRng& rng, std::vector<CompactBoard>& games)
+{
+    OracleCase c;
+    c.size = rng.uniform(100) < FOUR_BY_FOUR_SHARE ?
+                4 : between(rng, MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+    c.dir = Direction(rng.uniform(DIRECTION_COUNT));
+    int cells = c.size * c.size;
+    c.cells.assign(cells, 0);
+
+    switch( rng.uniform(BOARD_KIND_COUNT) )
+    {
+    case RANDOM_BOARD:
+    {
+        std::uint32_t density = rng.uniform(101);
+        int largest = between(rng, 1, MAX_PACKED_EXPONENT);
+        for( std::uint8_t& cell : c.cells )
+        {
+            if( rng.uniform(100) < density )
+            {
+                cell = between(rng, 1, largest);
+            }
+        }
+        break;
+    }
+    case RUN_BOARD:
+    {
+        // Few different values, so many tiles meet an equal one
+        int base = between(rng, 1, MAX_PACKED_EXPONENT - 1);
+        for( std::uint8_t& cell : c.cells )
+        {
+            int pick = rng.uniform(4);
+            cell = pick == 0 ? 0 : (pick == 3 ? base + 1 : base);
+        }
+        break;
+    }
+    case FULL_BOARD:
+    {
+        int base = between(rng, 1, MAX_PACKED_EXPONENT - 2);
+        for( std::uint8_t& cell : c.cells )
+        {
+            cell = base + rng.uniform(3);
+        }
+        break;
+    }
+    case CAP_BOARD:
+    {
+        // Tiles next to the largest exponent of either engine
+        int cap = rng.uniform(2) == 0 ?
+                    MAX_PACKED_EXPONENT : MAX_COMPACT_EXPONENT;
+        for( std::uint8_t& cell : c.cells )
+        {
+            if( rng.uniform(4) != 0 )
+            {
+                cell = cap - rng.uniform(3);
+            }
+        }
+        break;
+    }
+    default:
+    {
+        // A board from a game with random moves, played with the
+        // compact engine, which is checked itself. Every block of
+        // cases goes on with its own game of each size, so the boards
+        // get deep without replaying the start every time.
+        CompactBoard& board = games.at(c.size - MIN_BOARD_SIZE);
+        std::uint32_t moves = 1 + rng.uniform(MAX_GAME_MOVES);
+        for( std::uint32_t m = 0; m < moves; ++m )
+        {
+            board.move(Direction(rng.uniform(DIRECTION_COUNT)));
+            int empty = board.count_empty();
+            if( empty == 0 )
+            {
+                board = CompactBoard(c.size);
+                continue;
+            }
+            int skip = rng.uniform(empty);
+            for( int i = 0; i < cells; ++i )
+            {
+                if( board.get_exponent(i / c.size, i % c.size) == 0 and
+                    skip-- == 0 )
+                {
+                    board.set_exponent(i / c.size, i % c.size,
+                                       rng.uniform(10) == 0 ? 2 : 1);
+                    break;
+                }
+            }
+        }
+        for( int i = 0; i < cells; ++i )
+        {
+            c.cells[i] = board.get_exponent(i / c.size, i % c.size);
+        }
+        break;
+    }
+    }
+
+    // Often a goal that one merge of the board could reach
+    int goal = between(rng, 1, std::min(max_cell(c.cells) + 1,
+                                        MAX_GOAL_EXPONENT));
+    int cell = c.cells[rng.uniform(cells)];
+    if( rng.uniform(2) == 0 and cell != 0 )
+    {
+        goal = std::min(cell + 1, MAX_GOAL_EXPONENT);
+    }
+    c.goal_exponent = goal;
+    return c;
+}
+
+// Makes the case as small as possible while it still differs
+template <typename Differs>
+OracleCase minimize(OracleCase c, Differs differs)
+{
+    bool smaller = true;
+    while( smaller )
+    {
+        smaller = false;
+
+        // Empty single cells
+        for( std::uint8_t& cell : c.cells )
+        {
+            if( cell == 0 )
+            {
+                continue;
+            }
+            std::uint8_t old = cell;
+            cell = 0;
+            if( differs(c) )
+            {
+                smaller = true;
+            }
+            else
+            {
+                cell = old;
+            }
+        }
+
+        // Lower all the tiles together, which keeps them equal
+        if( std::count(c.cells.begin(), c.cells.end(), 1) == 0 and
+            max_cell(c.cells) > 1 and c.goal_exponent > 1 )
+        {
+            OracleCase lower = c;
+            for( std::uint8_t& cell : lower.cells )
+            {
+                cell = cell == 0 ? 0 : cell - 1;
+            }
+            --lower.goal_exponent;
+            if( differs(lower) )
+            {
+                c = lower;
+                smaller = true;
+            }
+        }
+
+        // Lower single tiles
+        for( std::uint8_t& cell : c.cells )
+        {
+            if( cell <= 1 )
+            {
+                continue;
+            }
+            --cell;
+            if( differs(c) )
+            {
+                smaller = true;
+            }
+            else
+            {
+                ++cell;
+            }
+        }
+    }
+    return c;
+}
+
+int tile_count(const OracleCase& c)
+{
+    return c.cells.size() - std::count(c.cells.begin(), c.cells.end(), 0);
+}
+
+// Orders the reproducers by the number of tiles, and the equal ones by
+// their contents, so the one kept doesn't depend on the threads
+bool smaller_case(const OracleCase& a, const OracleCase& b)
+{
+    int a_tiles = tile_count(a);
+    int b_tiles = tile_count(b);
+    return std::tie(a_tiles, a.size, a.cells, a.dir, a.goal_exponent) <
+           std::tie(b_tiles, b.size, b.cells, b.dir, b.goal_exponent);
+}
+
+void print_cells(const std::vector<std::uint8_t>& cells, int size,
+                 std::ostream& out)
+{
+    for( int y = 0; y < size; ++y )
+    {
+        out << "   ";
+        for( int x = 0; x < size; ++x )
+        {
+            int exponent = cells[y * size + x];
+            std::ostringstream value;
+            if( exponent == 0 )
+            {
+                value << ".";
+            }
+            else if( exponent <= MAX_GOAL_EXPONENT )
+            {
+                value << (1 << exponent);
+            }
+            else
+            {
+                value << "2^" << exponent;
+            }
+            out << std::setw(PRINT_WIDTH + 1) << value.str();
+        }
+        out << std::endl;
+    }
+}
+
+}
+
+Oracle::Oracle(std::uint64_t seed, int threads):
+    seed_(seed), threads_(threads), cases_(0), packed_cases_(0),
+    compact_cases_(0), packed_mismatches_(0), compact_mismatches_(0),
+    seconds_(0.0)
+{
+    if( threads_ <= 0 )
+    {
+        threads_ = std::thread::hardware_concurrency();
+    }
+    if( threads_ <= 0 )
+    {
+        threads_ = 1;
+    }
+}
+
+bool Oracle::run(std::uint64_t cases)
+{
+    cases_ = cases;
+    mismatches_.clear();
+
+    std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+    std::atomic<std::uint64_t> packed_cases(0);
+    std::atomic<std::uint64_t> compact_cases(0);
+    std::atomic<std::uint64_t> packed_mismatches(0);
+    std::atomic<std::uint64_t> compact_mismatches(0);
+    std::mutex mismatch_mutex;
+
+    // Keeps the smallest reproducer of every engine
+    auto report = [&](const std::string& engine, const OracleCase& c)
+    {
+        std::lock_guard<std::mutex> lock(mismatch_mutex);
+        for( OracleMismatch& old : mismatches_ )
+        {
+            if( old.engine == engine )
+            {
+                if( smaller_case(c, old.minimized) )
+                {
+                    old.minimized = c;
+                }
+                return;
+            }
+        }
+        mismatches_.push_back(OracleMismatch{engine, c});
+    };
+
+    // The cases are drawn in blocks, handed out in order, and block b
+    // draws from the b:th jump() of the stream with games of its own,
+    // so a seed gives the same cases on any number of threads
+    FastRng stream;
+    stream.seed(seed_);
+    std::uint64_t blocks = (cases + CASE_BLOCK_SIZE - 1) / CASE_BLOCK_SIZE;
+    std::uint64_t next_block = 0;
+    std::mutex block_mutex;
+    std::vector<std::thread> workers;
+    for( int t = 0; t < threads_; ++t )
+    {
+        workers.push_back(std::thread([&]()
+        {
+            LegacyEngine legacy;
+            std::uint64_t packed_done = 0;
+            std::uint64_t compact_done = 0;
+            while( true )
+            {
+                FastRng rng;
+                std::uint64_t block = 0;
+                {
+                    std::lock_guard<std::mutex> lock(block_mutex);
+                    if( next_block == blocks )
+                    {
+                        break;
+                    }
+                    block = next_block++;
+                    rng = stream;
+                    stream.jump();
+                }
+                std::uint64_t count = std::min(CASE_BLOCK_SIZE,
+                                               cases - block * CASE_BLOCK_SIZE);
+                std::vector<CompactBoard> games;
+                for( int size = MIN_BOARD_SIZE; size <= MAX_BOARD_SIZE;
+                     ++size )
+                {
+                    games.push_back(CompactBoard(size));
+                }
+                for( std::uint64_t i = 0; i < count; ++i )
+                {
+                    OracleCase c = make_case(rng, games);
+                    auto packed_check = [&](const OracleCase& other)
+                    {
+                        return packed_differs(legacy, other);
+                    };
+                    auto compact_check = [&](const OracleCase& other)
+                    {
+                        return compact_differs(legacy, other);
+                    };
+
+                    // The legacy result is only computed again when
+                    // minimizing
+                    Outcome expected = legacy.move(c);
+                    if( packed_applies(c) )
+                    {
+                        ++packed_done;
+                        if( differs(expected, packed_move(c), true) )
+                        {
+                            ++packed_mismatches;
+                            report("packed", minimize(c, packed_check));
+                        }
+                    }
+                    ++compact_done;
+                    if( differs(expected, compact_move(c), false) )
+                    {
+                        ++compact_mismatches;
+                        report("compact", minimize(c, compact_check));
+                    }
+                }
+            }
+            packed_cases += packed_done;
+            compact_cases += compact_done;
+        }));
+    }
+    for( std::thread& worker : workers )
+    {
+        worker.join();
+    }
+
+    seconds_ = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+    packed_cases_ = packed_cases;
+    compact_cases_ = compact_cases;
+    packed_mismatches_ = packed_mismatches;
+    compact_mismatches_ = compact_mismatches;
+    return mismatches_.empty();
+}
+
+void Oracle::print_report(std::ostream& out) const
+{
+    out << cases_ << " cases in " << std::fixed << std::setprecision(2)
+        << seconds_ << " s on " << threads_ << " threads ("
+        << std::setprecision(0)
+        << (seconds_ > 0.0 ? cases_ / seconds_ : 0.0) << " cases/s)"
+        << std::defaultfloat << std::setprecision(6) << std::endl;
+    out << "packed:  " << packed_cases_ << " cases, " << packed_mismatches_
+        << " mismatches" << std::endl;
+    out << "compact: " << compact_cases_ << " cases, "
+        << compact_mismatches_ << " mismatches" << std::endl;
+
+    LegacyEngine legacy;
+    for( const OracleMismatch& mismatch : mismatches_ )
+    {
+        const OracleCase& c = mismatch.minimized;
+        Outcome expected = legacy.move(c);
+        Outcome actual = mismatch.engine == "packed" ?
+                    packed_move(c) : compact_move(c);
+        out << std::endl << mismatch.engine << " differs from legacy, "
+            << "moving " << DIRECTION_NAMES[c.dir] << " with the goal 2^"
+            << c.goal_exponent << ":" << std::endl;
+        print_cells(c.cells, c.size, out);
+        out << "legacy (" << (expected.moved ? "moved" : "didn't move")
+            << ", " << expected.score << " points"
+            << (expected.won ? ", won" : "") << "):" << std::endl;
+        print_cells(expected.cells, c.size, out);
+        out << mismatch.engine << " ("
+            << (actual.moved ? "moved" : "didn't move")
+            << ", " << actual.score << " points"
+            << (actual.won ? ", won" : "") << "):" << std::endl;
+        print_cells(actual.cells, c.size, out);
+    }
+}
+
+std::uint64_t Oracle::packed_cases() const
+{
+    return packed_cases_;
+}
+
+std::uint64_t Oracle::compact_cases() const
+{
+    return compact_cases_;
+}
+
+const std::vector<OracleMismatch>& Oracle::mismatches() const
+{
+    return mismatches_;
+}
@@ -0,0 +1,85 @@
+/* Oracle
+ *
+ * Checks that the fast engines move exactly like the legacy one. Every
+ * case is a board, a direction and a goal. The board is moved with
+ * GameBoard::move, which is the reference, and with PackedBoard and
+ * CompactBoard, and the boards, whether they moved and the points of
+ * the merges are compared.
+ *
+ * The boards are partly random and partly made to hit the corner
+ * cases of the rules: runs of equal tiles that may merge only once,
+ * tiles next to the largest exponent an engine can store, full boards
+ * and boards taken from random games. PackedBoard is only checked
+ * against boards without 2^15 tiles, because it doesn't merge them by
+ * design. CompactBoard is also checked on boards from 2x2 to 8x8.
+ *
+ * A case that gives a different result is made smaller, by emptying
+ * cells and lowering exponents as long as the results still differ,
+ * so the reported board is a small reproducer.
+ *
+ * The cases are drawn in blocks from successive jump()s of the same
+ * xoshiro256** stream, and the threads take the blocks in turn, so a
+ * seed always gives the same cases and reports the same reproducers,
+ * on any number of threads.
+*/
+
+#ifndef ORACLE_HH
+#define ORACLE_HH
+
+#include "packedboard.hh"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One move to check
+struct OracleCase
+{
+    int size;
+
+    // Exponents of the board, row by row
+    std::vector<std::uint8_t> cells;
+
+    Direction dir;
+    int goal_exponent;
+};
+
+// A case where an engine and the legacy engine disagree
+struct OracleMismatch
+{
+    std::string engine;
+    OracleCase minimized;
+};
+
+class Oracle
+{
+public:
+    // Constructor, 0 threads means one per core.
+    Oracle(std::uint64_t seed, int threads = 0);
+
+    // Checks the given number of cases. Returns true, if every engine
+    // agreed with the legacy engine on all of them.
+    bool run(std::uint64_t cases);
+
+    // Prints the number of cases, the speed and the minimized
+    // reproducer of every engine that failed.
+    void print_report(std::ostream& out) const;
+
+    // Cases where the engines were compared, and the mismatches found
+    std::uint64_t packed_cases() const;
+    std::uint64_t compact_cases() const;
+    const std::vector<OracleMismatch>& mismatches() const;
+
+private:
+    std::uint64_t seed_;
+    int threads_;
+    std::uint64_t cases_;
+    std::uint64_t packed_cases_;
+    std::uint64_t compact_cases_;
+    std::uint64_t packed_mismatches_;
+    std::uint64_t compact_mismatches_;
+    double seconds_;
+    std::vector<OracleMismatch> mismatches_;
+};
+
+#endif // ORACLE_HH
@@ -0,0 +1,213 @@
+#include "packedboard.hh"
+#include "gameboard.hh"
+#include <vector>
+
+static_assert(SIZE == 4, "PackedBoard only supports 4x4 boards");
+
+namespace
+{
+
+const int ROW_COUNT = 1 << 16;
+
+// Precomputed results for every possible row of four nibbles
+struct RowTables
+{
+    std::vector<std::uint16_t> left;
+    std::vector<std::uint16_t> right;
+    std::vector<std::uint32_t> merged_mask;
+    std::vector<std::uint32_t> score;
+
+    RowTables();
+};
+
+std::uint16_t reverse_row(std::uint16_t row)
+{
+    return ((row >> 12) & 0x000F) | ((row >> 4) & 0x00F0) |
+           ((row << 4) & 0x0F00) | ((row << 12) & 0xF000);
+}
+
+RowTables::RowTables():
+    left(ROW_COUNT), right(ROW_COUNT), merged_mask(ROW_COUNT), score(ROW_COUNT)
+{
+    for( int row = 0; row < ROW_COUNT; ++row )
+    {
+        int out[4] = {0, 0, 0, 0};
+        bool merged[4] = {false, false, false, false};
+        int count = 0;
+        std::uint32_t mask = 0;
+        std::uint32_t points = 0;
+
+        // Same as NumberTile::move: the tile nearest to the wall goes
+        // first, and a merged tile can not merge again
+        for( int i = 0; i < 4; ++i )
+        {
+            int value = (row >> (4 * i)) & 0xF;
+            if( value == 0 )
+            {
+                continue;
+            }
+            if( count > 0 and out[count - 1] == value and
+                not merged[count - 1] and value < MAX_PACKED_EXPONENT )
+            {
+                out[count - 1] = value + 1;
+                merged[count - 1] = true;
+                mask |= 1u << (value + 1);
+                points += 1u << (value + 1);
+            }
+            else
+            {
+                out[count++] = value;
+            }
+        }
+
+        std::uint16_t result = 0;
+        for( int i = 0; i < 4; ++i )
+        {
+            result |= out[i] << (4 * i);
+        }
+        left.at(row) = result;
+        right.at(reverse_row(row)) = reverse_row(result);
+        merged_mask.at(row) = mask;
+        score.at(row) = points;
+    }
+}
+
+const RowTables& tables()
+{
+    static const RowTables instance;
+    return instance;
+}
+
+std::uint16_t get_row(PackedBoard board, int y)
+{
+    return (board >> (16 * y)) & 0xFFFF;
+}
+
+}
+
+namespace packed
+{
+
+Coords to_coords(Direction dir)
+{
+    switch( dir )
+    {
+    case UP:
+        return std::make_pair(-1, 0);
+    case RIGHT:
+        return std::make_pair(0, 1);
+    case DOWN:
+        return std::make_pair(1, 0);
+    default:
+        return std::make_pair(0, -1);
+    }
+}
+
+Direction from_coords(Coords coords)
+{
+    if( coords.first != 0 )
+    {
+        return coords.first < 0 ? UP : DOWN;
+    }
+    return coords.second > 0 ? RIGHT : LEFT;
+}
+
+PackedBoard from_game_board(GameBoard& board)
+{
+    PackedBoard result = 0;
+    for( int y = 0; y < SIZE; ++y )
+    {
+        for( int x = 0; x < SIZE; ++x )
+        {
+            int exponent =
+                    board.get_item(std::make_pair(y, x))->get_exponent();
+            if( exponent > MAX_PACKED_EXPONENT )
+            {
+                exponent = MAX_PACKED_EXPONENT;
+            }
+            result = set_exponent(result, y, x, exponent);
+        }
+    }
+    return result;
+}
+
+PackedMove move(PackedBoard board, Direction dir)
+{
+    const RowTables& t = tables();
+    bool vertical = dir == UP or dir == DOWN;
+    const std::vector<std::uint16_t>& slide =
+            (dir == LEFT or dir == UP) ? t.left : t.right;
+
+    PackedBoard source = vertical ? transpose(board) : board;
+    PackedMove result = {0, 0, 0};
+    for( int y = 0; y < SIZE; ++y )
+    {
+        std::uint16_t row = get_row(source, y);
+        result.board |= PackedBoard(slide[row]) << (16 * y);
+        result.merged_mask |= t.merged_mask[row];
+        result.score += t.score[row];
+    }
+    if( vertical )
+    {
+        result.board = transpose(result.board);
+    }
+    return result;
+}
+
+int count_empty(PackedBoard board)
+{
+    int empty = 0;
+    for( int i = 0; i < SIZE * SIZE; ++i )
+    {
+        if( ((board >> (4 * i)) & 0xF) == 0 )
+        {
+            ++empty;
+        }
+    }
+    return empty;
+}
+
+int max_exponent(PackedBoard board)
+{
+    int largest = 0;
+    for( int i = 0; i < SIZE * SIZE; ++i )
+    {
+        int exponent = (board >> (4 * i)) & 0xF;
+        if( exponent > largest )
+        {
+            largest = exponent;
+        }
+    }
+    return largest;
+}
+
+PackedBoard transpose(PackedBoard board)
+{
+    PackedBoard a1 = board & 0xF0F00F0FF0F00F0FULL;
+    PackedBoard a2 = board & 0x0000F0F00000F0F0ULL;
+    PackedBoard a3 = board & 0x0F0F00000F0F0000ULL;
+    PackedBoard a = a1 | (a2 << 12) | (a3 >> 12);
+    PackedBoard b1 = a & 0xFF00FF0000FF00FFULL;
+    PackedBoard b2 = a & 0x00FF00FF00000000ULL;
+    PackedBoard b3 = a & 0x00000000FF00FF00ULL;
+    return b1 | (b2 >> 24) | (b3 << 24);
+}
+
+PackedBoard flip_horizontal(PackedBoard board)
+{
+    // Swap the bytes of every row, then the nibbles of every byte
+    board = ((board & 0x00FF00FF00FF00FFULL) << 8) |
+            ((board >> 8) & 0x00FF00FF00FF00FFULL);
+    return ((board & 0x0F0F0F0F0F0F0F0FULL) << 4) |
+           ((board >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+}
+
+PackedBoard flip_vertical(PackedBoard board)
+{
+    // Swap the halves, then the rows of every half
+    board = (board << 32) | (board >> 32);
+    return ((board & 0x0000FFFF0000FFFFULL) << 16) |
+           ((board >> 16) & 0x0000FFFF0000FFFFULL);
+}
+
+}
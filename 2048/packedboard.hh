@@ -0,0 +1,94 @@
+/* PackedBoard
+ *
+ * A compact representation of the 4x4 game board used by the
+ * built-in strategies. Every tile is stored as its exponent in one
+ * nibble (0 is an empty tile, 1 is 2, 2 is 4 and so on), so the whole
+ * board fits in a single 64 bit integer and can be copied, hashed and
+ * compared for free.
+ *
+ * Moves are done with precomputed row tables and follow the same
+ * rules as NumberTile::move: tiles slide as far as possible and every
+ * tile can merge at most once per move. The largest storable tile is
+ * 2^15, two such tiles are treated as unmergeable.
+ *
+ * Cell (y, x) is stored in the nibble y * SIZE + x, counted from the
+ * least significant end.
+*/
+
+#ifndef PACKEDBOARD_HH
+#define PACKEDBOARD_HH
+
+#include "numbertile.hh"
+#include <cstdint>
+
+class GameBoard;
+
+using PackedBoard = std::uint64_t;
+
+// The directions, in the order used by every strategy
+enum Direction { UP, RIGHT, DOWN, LEFT };
+const int DIRECTION_COUNT = 4;
+
+// The largest exponent that fits in a nibble
+const int MAX_PACKED_EXPONENT = 15;
+
+// Result of moving a packed board
+struct PackedMove
+{
+    // The board after the slide, without a new tile
+    PackedBoard board;
+
+    // Bit e is set if a merge produced a tile with the exponent e
+    std::uint32_t merged_mask;
+
+    // Sum of the values of the merged tiles
+    std::uint32_t score;
+};
+
+namespace packed
+{
+    // Converts the given direction to the coordinate pair used by
+    // GameBoard::move.
+    Coords to_coords(Direction dir);
+
+    // Converts a coordinate pair of GameBoard::move to the direction.
+    Direction from_coords(Coords coords);
+
+    // Reads the current state of the given gameboard.
+    PackedBoard from_game_board(GameBoard& board);
+
+    // Returns the exponent in the given cell.
+    inline int get_exponent(PackedBoard board, int y, int x)
+    {
+        return (board >> (4 * (y * 4 + x))) & 0xF;
+    }
+
+    // Returns a copy of the board with the given cell set.
+    inline PackedBoard set_exponent(PackedBoard board, int y, int x,
+                                    int exponent)
+    {
+        int shift = 4 * (y * 4 + x);
+        return (board & ~(PackedBoard(0xF) << shift)) |
+               (PackedBoard(exponent) << shift);
+    }
+
+    // Moves the board in the given direction.
+    PackedMove move(PackedBoard board, Direction dir);
+
+    // Returns the number of empty cells.
+    int count_empty(PackedBoard board);
+
+    // Returns the largest exponent on the board.
+    int max_exponent(PackedBoard board);
+
+    // Swaps rows and columns.
+    PackedBoard transpose(PackedBoard board);
+
+    // Mirrors the board left to right.
+    PackedBoard flip_horizontal(PackedBoard board);
+
+    // Mirrors the board top to bottom.
+    PackedBoard flip_vertical(PackedBoard board);
+}
+
+#endif // PACKEDBOARD_HH
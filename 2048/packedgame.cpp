@@ -0,0 +1,118 @@
+#include "packedgame.hh"
+#include "gameboard.hh"
+
+namespace
+{
+
+// Exponent of NEW_VALUE
+const int NEW_EXPONENT = 1;
+
+}
+
+PackedGame::PackedGame():
+    board_(0), score_(0), moves_(0), goal_exponent_(0), state_(LOST),
+    rng_(SIZE)
+{
+}
+
+void PackedGame::start(int seed, int goal_exponent, RngMode mode)
+{
+    // Also wipes out the first random number, as GameBoard::fill does
+    rng_.seed(seed, mode);
+
+    board_ = 0;
+    score_ = 0;
+    moves_ = 0;
+    goal_exponent_ = goal_exponent;
+    state_ = PLAYING;
+    for( int i = 0; i < SIZE; ++i )
+    {
+        new_value();
+    }
+}
+
+GameState PackedGame::step(Direction dir)
+{
+    if( state_ != PLAYING )
+    {
+        return state();
+    }
+
+    // A move that changes nothing is ignored, as in the GUI, unless no
+    // move changes the board, which loses the game
+    PackedMove result = packed::move(board_, dir);
+    if( result.board == board_ )
+    {
+        bool stuck = true;
+        for( int d = 0; stuck and d < DIRECTION_COUNT; ++d )
+        {
+            stuck = packed::move(board_, Direction(d)).board == board_;
+        }
+        if( stuck )
+        {
+            state_ = LOST;
+        }
+        return state();
+    }
+    board_ = result.board;
+    score_ += result.score;
+    ++moves_;
+    // A move that changed the board always leaves an empty cell
+    if( result.merged_mask & (1u << goal_exponent_) )
+    {
+        state_ = WON;
+    }
+    else
+    {
+        new_value();
+    }
+    return state();
+}
+
+PackedBoard PackedGame::board() const
+{
+    return board_;
+}
+
+GameState PackedGame::state() const
+{
+    return GameState(state_);
+}
+
+int PackedGame::goal_exponent() const
+{
+    return goal_exponent_;
+}
+
+std::uint32_t PackedGame::score() const
+{
+    return score_;
+}
+
+std::uint32_t PackedGame::moves() const
+{
+    return moves_;
+}
+
+const SpawnRng& PackedGame::rng() const
+{
+    return rng_;
+}
+
+void PackedGame::new_value()
+{
+    std::uint64_t empty_mask = 0;
+    for( int i = 0; i < SIZE * SIZE; ++i )
+    {
+        if( ((board_ >> (4 * i)) & 0xF) == 0 )
+        {
+            empty_mask |= std::uint64_t(1) << i;
+        }
+    }
+    if( empty_mask == 0 )
+    {
+        return;
+    }
+    int cell = rng_.pick_empty_cell(empty_mask);
+    board_ |= PackedBoard(NEW_EXPONENT) << (4 * cell);
+}
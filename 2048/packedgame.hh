@@ -0,0 +1,66 @@
+/* PackedGame
+ *
+ * A complete game on a packed board, without any GUI. The rules are
+ * the same as in the GUI: the opening comes from GameBoard::fill with
+ * the same seed, a new tile is drawn the same way as in
+ * GameBoard::new_value after every move, and the game is won when a
+ * merge produces the target tile. A move that doesn't change the board
+ * is ignored, unless no move changes it, which loses the game.
+ *
+ * The object is small and has no pointers, so large numbers of games
+ * can be kept in a plain vector.
+*/
+
+#ifndef PACKEDGAME_HH
+#define PACKEDGAME_HH
+
+#include "packedboard.hh"
+#include "rng.hh"
+
+enum GameState { PLAYING, WON, LOST };
+
+// Target exponent of a game that can't be won
+const int NO_GOAL = 0;
+
+class PackedGame
+{
+public:
+    PackedGame();
+
+    // Starts a new game with the given seed and target exponent,
+    // e.g. 11 for 2048. With NO_GOAL the game goes on until it is lost.
+    void start(int seed, int goal_exponent, RngMode mode = LEGACY_RNG);
+
+    // Makes a move and returns the state of the game after it.
+    // Moving a finished game, or in a direction that changes nothing,
+    // does nothing.
+    GameState step(Direction dir);
+
+    PackedBoard board() const;
+    GameState state() const;
+    int goal_exponent() const;
+
+    // Sum of the values of all the merged tiles
+    std::uint32_t score() const;
+
+    // Number of moves made
+    std::uint32_t moves() const;
+
+    // The generator of the new tiles, e.g. for its counters.
+    const SpawnRng& rng() const;
+
+private:
+    PackedBoard board_;
+    std::uint32_t score_;
+    std::uint32_t moves_;
+    std::uint8_t goal_exponent_;
+    std::uint8_t state_;
+
+    // Same generator as in GameBoard, so that a seed gives the same game
+    SpawnRng rng_;
+
+    // Puts NEW_VALUE on a random empty cell, see GameBoard::new_value.
+    void new_value();
+};
+
+#endif // PACKEDGAME_HH
@@ -0,0 +1,187 @@
+#include "playbackview.hh"
+#include <QCloseEvent>
+#include <QGuiApplication>
+#include <QHBoxLayout>
+#include <QScreen>
+#include <QSignalBlocker>
+#include <QVBoxLayout>
+
+using namespace std;
+
+PlaybackView::PlaybackView(int slotSize, QWidget* parent)
+    : QWidget(parent)
+    , slotSize(slotSize)
+{
+    setWindowTitle("2048");
+
+    // The empty squares under the tiles, as on the main board
+    scene = new QGraphicsScene(this);
+    scene->setSceneRect(0, 0, SIZE * slotSize, SIZE * slotSize);
+    for ( int y = 0; y < SIZE; ++y ) {
+        for ( int x = 0; x < SIZE; ++x ) {
+            scene->addRect(x * slotSize, y * slotSize, slotSize, slotSize);
+        }
+    }
+    boardItem = new BoardItem(SIZE, slotSize);
+    scene->addItem(boardItem);
+    view = new QGraphicsView(scene, this);
+    view->setFixedSize(SIZE * slotSize + 3, SIZE * slotSize + 3);
+
+    // 0 plays as fast as the frames can be read
+    speedLabel = new QLabel(this);
+    speedSpinBox = new QSpinBox(this);
+    speedSpinBox->setSpecialValueText("max");
+    speedSpinBox->setMaximum(100000);
+    speedSpinBox->setValue(60);
+    connect(speedSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &PlaybackView::restartPacing);
+    // The slider follows the playback, and the user can drag it
+    seekSlider = new QSlider(Qt::Horizontal, this);
+    connect(seekSlider, &QSlider::valueChanged, this, &PlaybackView::seekTo);
+    statusLabel = new QLabel(this);
+
+    QHBoxLayout* speedLayout = new QHBoxLayout;
+    speedLayout->addWidget(speedLabel);
+    speedLayout->addWidget(speedSpinBox);
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(view);
+    layout->addLayout(speedLayout);
+    layout->addWidget(seekSlider);
+    layout->addWidget(statusLabel);
+    setFinnish(false);
+
+    frameTimer = new QTimer(this);
+    frameTimer->setTimerType(Qt::PreciseTimer);
+    qreal refreshRate = QGuiApplication::primaryScreen()->refreshRate();
+    frameTimer->setInterval(qMax(1, qRound(1000.0 / refreshRate)));
+    connect(frameTimer, &QTimer::timeout, this, &PlaybackView::renderFrame);
+}
+
+void PlaybackView::setAtlas(const TileAtlas* atlas)
+{
+    boardItem->setAtlas(atlas);
+}
+
+void PlaybackView::setFallback(function<QPixmap(int)> fallback)
+{
+    boardItem->setFallback(fallback);
+}
+
+void PlaybackView::setAtlasEnabled(bool enabled)
+{
+    boardItem->setAtlasEnabled(enabled);
+}
+
+void PlaybackView::setFinnish(bool finnish)
+{
+    isFinnish = finnish;
+    if ( !isFinnish ) {
+        speedLabel->setText("Speed:");
+        speedSpinBox->setSuffix(" moves/s");
+    } else {
+        speedLabel->setText("Nopeus:");
+        speedSpinBox->setSuffix(" siirtoa/s");
+    }
+    updateStatus();
+}
+
+bool PlaybackView::openStream(const QString& path)
+{
+    if ( !reader.open(path.toStdString()) ) {
+        return false;
+    }
+    boardItem->setBoard(reader.current().board);
+    updateStatus();
+    restartPacing();
+    frameTimer->start();
+    return true;
+}
+
+void PlaybackView::closeEvent(QCloseEvent* event)
+{
+    frameTimer->stop();
+    event->accept();
+}
+
+void PlaybackView::renderFrame()
+{
+    // Find out how many moves are due by now
+    int speed = speedSpinBox->value();
+    qint64 movesDue = MAX_MOVES_PER_FRAME;
+    if ( speed > 0 ) {
+        movesDue = speed * playClock.elapsed() / 1000 - movesDone;
+    }
+
+    // Only the last board read is drawn
+    bool moved = false;
+    while ( movesDue > 0 && reader.next() ) {
+        ++movesDone;
+        --movesDue;
+        moved = true;
+    }
+
+    // A stream that is being written has no backlog to catch up
+    if ( movesDue > 0 && speed > 0 ) {
+        movesDone += movesDue;
+    }
+    if ( moved ) {
+        boardItem->setBoard(reader.current().board);
+        updateStatus();
+    } else if ( reader.finished() ) {
+        frameTimer->stop();
+        updateStatus();
+    }
+}
+
+void PlaybackView::restartPacing()
+{
+    playClock.start();
+    movesDone = 0;
+}
+
+void PlaybackView::seekTo(int move)
+{
+    reader.seek(move);
+    boardItem->setBoard(reader.current().board);
+    updateStatus();
+
+    // Play on from the new move
+    restartPacing();
+    if ( !frameTimer->isActive() ) {
+        frameTimer->start();
+    }
+}
+
+void PlaybackView::updateStatus()
+{
+    if ( !reader.is_open() ) {
+        statusLabel->clear();
+        return;
+    }
+    const StreamFrame& frame = reader.current();
+
+    // Moving the slider here doesn't seek
+    QSignalBlocker blocker(seekSlider);
+    seekSlider->setMaximum(reader.moves());
+    seekSlider->setValue(frame.move);
+
+    QString state;
+    if ( !isFinnish ) {
+        if ( reader.finished() && reader.final_state() != PLAYING ) {
+            state = reader.final_state() == WON ? ", won" : ", lost";
+        }
+        statusLabel->setText("Seed " + QString::number(reader.header().seed)
+                             + ", move " + QString::number(frame.move)
+                             + ", " + QString::number(frame.score)
+                             + " points" + state);
+    } else {
+        if ( reader.finished() && reader.final_state() != PLAYING ) {
+            state = reader.final_state() == WON ? ", voitto" : ", häviö";
+        }
+        statusLabel->setText("Siemen "
+                             + QString::number(reader.header().seed)
+                             + ", siirto " + QString::number(frame.move)
+                             + ", " + QString::number(frame.score)
+                             + " pistettä" + state);
+    }
+}
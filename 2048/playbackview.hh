@@ -0,0 +1,95 @@
+/* PlaybackView
+ *
+ * A window that plays back a recorded game from its frame stream,
+ * see FrameStream. The frames only tell the changed cells, so playing
+ * back doesn't need the rules of the game and any speed up to
+ * thousands of moves per second costs no more than drawing the board
+ * once per display refresh.
+ *
+ * A stream that is still being written, e.g. the game being played
+ * with recording on, is followed: the new frames are shown as they
+ * come.
+ *
+ * The slider goes to any move of the stream. Going to a move starts
+ * from the keyframe before it, so it takes at most the keyframe
+ * interval of frames however long the game is.
+*/
+
+#ifndef PLAYBACKVIEW_HH
+#define PLAYBACKVIEW_HH
+
+#include "boarditem.hh"
+#include "framestream.hh"
+#include "tileatlas.hh"
+#include <QElapsedTimer>
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QLabel>
+#include <QSlider>
+#include <QSpinBox>
+#include <QTimer>
+#include <QWidget>
+#include <functional>
+
+class PlaybackView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    // Constructor, the tiles are slotSize pixels
+    PlaybackView(int slotSize, QWidget* parent = nullptr);
+
+    // Same as in BoardItem
+    void setAtlas(const TileAtlas* atlas);
+    void setFallback(std::function<QPixmap(int exponent)> fallback);
+    void setAtlasEnabled(bool enabled);
+
+    // Changes the texts to Finnish or English
+    void setFinnish(bool finnish);
+
+    // Starts playing the given stream from the beginning. Returns
+    // false, if the file isn't a frame stream.
+    bool openStream(const QString& path);
+
+protected:
+    // Stops playing when the window is closed
+    void closeEvent(QCloseEvent* event) override;
+
+private slots:
+    // Reads the frames that are due and draws the board
+    void renderFrame();
+
+    // Restarts the pacing with the new speed
+    void restartPacing();
+
+    // Goes to the move chosen with the slider
+    void seekTo(int move);
+
+private:
+    int slotSize;
+    bool isFinnish = false;
+
+    QGraphicsScene* scene;
+    QGraphicsView* view;
+    BoardItem* boardItem;
+    QLabel* speedLabel;
+    QSpinBox* speedSpinBox;
+    QSlider* seekSlider;
+    QLabel* statusLabel;
+    QTimer* frameTimer;
+
+    FrameStreamReader reader;
+
+    // Moves shown since the pacing was (re)started
+    QElapsedTimer playClock;
+    qint64 movesDone = 0;
+
+    // The most moves read in one frame at 'max' speed
+    const int MAX_MOVES_PER_FRAME = 100000;
+
+    // Shows the move, the score and whether the game goes on, and
+    // moves the slider along
+    void updateStatus();
+};
+
+#endif // PLAYBACKVIEW_HH
@@ -0,0 +1,93 @@
+/* Corner
+ *
+ * An example strategy plugin, see numbers_strategy.h. Keeps the tiles
+ * in the bottom left corner: moves down if it can, then left, then
+ * right, and up only when nothing else changes the board.
+ *
+ * Build with corner.pro, or with
+ *      cc -O2 -shared -fPIC -I../.. corner.c -o libcorner.so
+ * and play with e.g. numbers_cli tournament 1000 plugin:./libcorner.so
+*/
+
+#include "numbers_strategy.h"
+#include <stdlib.h>
+
+enum { UP, RIGHT, DOWN, LEFT };
+
+/* The moves in the order they are tried */
+static const uint8_t ORDER[4] = {DOWN, LEFT, RIGHT, UP};
+
+static int cell(uint64_t board, int y, int x)
+{
+    return (board >> (4 * (4 * y + x))) & 0xF;
+}
+
+/* Returns true, if the move changes the board: a tile can slide to an
+ * empty cell or merge with the next tile towards the move. */
+static int can_move(uint64_t board, int dir)
+{
+    int dy = dir == DOWN ? 1 : dir == UP ? -1 : 0;
+    int dx = dir == RIGHT ? 1 : dir == LEFT ? -1 : 0;
+    for( int y = 0; y < 4; ++y )
+    {
+        for( int x = 0; x < 4; ++x )
+        {
+            int ny = y + dy;
+            int nx = x + dx;
+            int value = cell(board, y, x);
+            if( value == 0 || ny < 0 || ny > 3 || nx < 0 || nx > 3 )
+            {
+                continue;
+            }
+            int next = cell(board, ny, nx);
+            if( next == 0 || (next == value && value < 15) )
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void* create(void)
+{
+    /* The strategy has no state, but every instance must be its own */
+    return malloc(1);
+}
+
+static void destroy(void* instance)
+{
+    free(instance);
+}
+
+static void choose(void* instance, const uint64_t* boards, uint32_t count,
+                   uint8_t* directions)
+{
+    (void)instance;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        directions[i] = UP;
+        for( int o = 0; o < 4; ++o )
+        {
+            if( can_move(boards[i], ORDER[o]) )
+            {
+                directions[i] = ORDER[o];
+                break;
+            }
+        }
+    }
+}
+
+NUMBERS_STRATEGY_EXPORT const numbers_strategy* numbers_strategy_api(void)
+{
+    static const struct numbers_strategy api = {
+        NUMBERS_STRATEGY_ABI_VERSION,
+        sizeof(struct numbers_strategy),
+        "corner",
+        create,
+        destroy,
+        NULL,
+        choose
+    };
+    return &api;
+}
@@ -0,0 +1,18 @@
+# Example strategy plugin, see numbers_strategy.h. Builds libcorner.so
+# (libcorner.dylib on macOS, corner.dll on Windows), to be played with
+# "plugin:<path>".
+
+TEMPLATE = lib
+TARGET = corner
+
+QT -= core gui
+CONFIG += plugin c++11
+CONFIG -= qt
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    corner.c
+
+HEADERS += \
+    ../../numbers_strategy.h
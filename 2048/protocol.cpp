@@ -0,0 +1,86 @@
+#include "protocol.hh"
+
+namespace
+{
+
+void put_u32(unsigned char* out, std::uint32_t value)
+{
+    for( int i = 0; i < 4; ++i )
+    {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+void put_u64(unsigned char* out, std::uint64_t value)
+{
+    for( int i = 0; i < 8; ++i )
+    {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+std::uint32_t get_u32(const unsigned char* in)
+{
+    std::uint32_t value = 0;
+    for( int i = 0; i < 4; ++i )
+    {
+        value |= std::uint32_t(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+std::uint64_t get_u64(const unsigned char* in)
+{
+    std::uint64_t value = 0;
+    for( int i = 0; i < 8; ++i )
+    {
+        value |= std::uint64_t(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+}
+
+void encode_request(const Request& request, unsigned char* out)
+{
+    out[0] = request.opcode;
+    out[1] = request.argument;
+    out[2] = 0;
+    out[3] = 0;
+    put_u32(out + 4, request.session);
+    put_u32(out + 8, request.seed);
+}
+
+Request decode_request(const unsigned char* in)
+{
+    Request request;
+    request.opcode = in[0];
+    request.argument = in[1];
+    request.session = get_u32(in + 4);
+    request.seed = get_u32(in + 8);
+    return request;
+}
+
+void encode_response(const Response& response, unsigned char* out)
+{
+    out[0] = response.status;
+    out[1] = response.state;
+    out[2] = 0;
+    out[3] = 0;
+    put_u32(out + 4, response.session);
+    put_u64(out + 8, response.board);
+    put_u32(out + 16, response.score);
+    put_u32(out + 20, response.moves);
+}
+
+Response decode_response(const unsigned char* in)
+{
+    Response response;
+    response.status = in[0];
+    response.state = in[1];
+    response.session = get_u32(in + 4);
+    response.board = get_u64(in + 8);
+    response.score = get_u32(in + 16);
+    response.moves = get_u32(in + 20);
+    return response;
+}
@@ -0,0 +1,83 @@
+/* Protocol
+ *
+ * The binary protocol of the headless game server. Every request and
+ * every response has a fixed size, and all the numbers are sent in
+ * little-endian byte order:
+ *
+ * Request (12 bytes):
+ *      opcode (1), argument (1), reserved (2), session (4), seed (4)
+ *
+ *      NEW_GAME:  argument is the target exponent (2..15), seed is the
+ *                 seed of the game. The response has the new session.
+ *      MOVE:      argument is the Direction. A move that changes nothing
+ *                 is ignored, as in the GUI.
+ *      GET_STATE: argument and seed are ignored.
+ *      CLOSE:     frees the session.
+ *
+ * A session can only be used by the connection that opened it, and
+ * the sessions left open are freed when the connection closes.
+ *
+ * Response (24 bytes):
+ *      status (1), game state (1), reserved (2), session (4),
+ *      packed board (8), score (4), moves (4)
+ *
+ * A client may send any number of requests without waiting, the
+ * responses come back in the same order.
+*/
+
+#ifndef PROTOCOL_HH
+#define PROTOCOL_HH
+
+#include <cstdint>
+#include <cstddef>
+
+const std::size_t REQUEST_SIZE = 12;
+const std::size_t RESPONSE_SIZE = 24;
+
+enum Opcode
+{
+    OP_NEW_GAME = 1,
+    OP_MOVE = 2,
+    OP_GET_STATE = 3,
+    OP_CLOSE = 4
+};
+
+enum Status
+{
+    STATUS_OK = 0,
+    STATUS_UNKNOWN_SESSION = 1,
+    STATUS_BAD_REQUEST = 2,
+    STATUS_SERVER_FULL = 3
+};
+
+struct Request
+{
+    std::uint8_t opcode;
+    std::uint8_t argument;
+    std::uint32_t session;
+    std::uint32_t seed;
+};
+
+struct Response
+{
+    std::uint8_t status;
+    std::uint8_t state;
+    std::uint32_t session;
+    std::uint64_t board;
+    std::uint32_t score;
+    std::uint32_t moves;
+};
+
+// Writes the request in REQUEST_SIZE bytes.
+void encode_request(const Request& request, unsigned char* out);
+
+// Reads a request from REQUEST_SIZE bytes.
+Request decode_request(const unsigned char* in);
+
+// Writes the response in RESPONSE_SIZE bytes.
+void encode_response(const Response& response, unsigned char* out);
+
+// Reads a response from RESPONSE_SIZE bytes.
+Response decode_response(const unsigned char* in);
+
+#endif // PROTOCOL_HH
@@ -0,0 +1,333 @@
+#include "quantizedntuple.hh"
+#include "packedgame.hh"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+const std::int16_t MAX_QUANTIZED = 32767;
+
+const std::size_t FILE_SIZE = sizeof(QuantizedNTupleHeader) +
+        NTUPLE_COUNT * NTUPLE_WEIGHTS * sizeof(std::int16_t);
+
+// Boards the benchmark evaluates, taken from games of the network
+const std::size_t BENCHMARK_BOARDS = 100000;
+
+// Evicts the file from the page cache, so that it is read from the
+// disk again
+void drop_from_cache(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if( fd >= 0 )
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+}
+
+}
+
+QuantizedNTuple::QuantizedNTuple():
+    data_(nullptr), size_(0), weights_(nullptr)
+{
+}
+
+QuantizedNTuple::~QuantizedNTuple()
+{
+    if( data_ != nullptr )
+    {
+        munmap(data_, size_);
+    }
+}
+
+bool QuantizedNTuple::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if( fd < 0 )
+    {
+        return false;
+    }
+    struct stat status;
+    if( fstat(fd, &status) != 0 or
+        std::size_t(status.st_size) != FILE_SIZE )
+    {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, FILE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if( data == MAP_FAILED )
+    {
+        return false;
+    }
+
+    // Check that the file is what it should be
+    const QuantizedNTupleHeader* header =
+            static_cast<QuantizedNTupleHeader*>(data);
+    if( std::memcmp(header->magic, QUANTIZED_NTUPLE_MAGIC, 8) != 0 or
+        header->version != QUANTIZED_NTUPLE_VERSION or
+        header->tuples != NTUPLE_COUNT or
+        header->cells != NTUPLE_CELLS )
+    {
+        munmap(data, FILE_SIZE);
+        return false;
+    }
+
+    if( data_ != nullptr )
+    {
+        munmap(data_, size_);
+    }
+    data_ = data;
+    size_ = FILE_SIZE;
+    weights_ = reinterpret_cast<const std::int16_t*>(
+                static_cast<const char*>(data_)
+                + sizeof(QuantizedNTupleHeader));
+    return true;
+}
+
+bool QuantizedNTuple::is_open() const
+{
+    return data_ != nullptr;
+}
+
+const QuantizedNTupleHeader& QuantizedNTuple::header() const
+{
+    return *static_cast<const QuantizedNTupleHeader*>(data_);
+}
+
+double QuantizedNTuple::value(PackedBoard board) const
+{
+    std::uint32_t indices[NTUPLE_LOOKUPS];
+    ntuple_indices(board, indices);
+
+    double sum = 0.0;
+    for( int t = 0; t < NTUPLE_COUNT; ++t )
+    {
+        const std::int16_t* table = weights_ + t * NTUPLE_WEIGHTS;
+        const std::uint32_t* tuple_indices = indices + t * SYMMETRY_COUNT;
+        std::int32_t tuple_sum = 0;
+        for( int s = 0; s < SYMMETRY_COUNT; ++s )
+        {
+            tuple_sum += table[tuple_indices[s]];
+        }
+        sum += double(header().scales[t]) * tuple_sum;
+    }
+    return sum;
+}
+
+bool QuantizedNTuple::best_move(PackedBoard board, Direction& dir,
+                                PackedMove& result, double& value) const
+{
+    bool found = false;
+    for( int d = 0; d < DIRECTION_COUNT; ++d )
+    {
+        PackedMove candidate = packed::move(board, Direction(d));
+        if( candidate.board == board )
+        {
+            continue;
+        }
+        double candidate_value = candidate.score +
+                                 this->value(candidate.board);
+        if( not found or candidate_value > value )
+        {
+            found = true;
+            value = candidate_value;
+            dir = Direction(d);
+            result = candidate;
+        }
+    }
+    return found;
+}
+
+bool QuantizedNTuple::write(const NTupleNetwork& network,
+                            const std::string& path)
+{
+    // Write to a temporary file, so that a network is never half done
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if( fd < 0 or ftruncate(fd, FILE_SIZE) != 0 )
+    {
+        std::cerr << temporary << ": " << std::strerror(errno) << std::endl;
+        if( fd >= 0 )
+        {
+            close(fd);
+        }
+        return false;
+    }
+    void* data = mmap(nullptr, FILE_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    close(fd);
+    if( data == MAP_FAILED )
+    {
+        std::cerr << temporary << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    QuantizedNTupleHeader* header = static_cast<QuantizedNTupleHeader*>(data);
+    std::memset(header, 0, sizeof(QuantizedNTupleHeader));
+    std::memcpy(header->magic, QUANTIZED_NTUPLE_MAGIC,
+                sizeof(header->magic));
+    header->version = QUANTIZED_NTUPLE_VERSION;
+    header->tuples = NTUPLE_COUNT;
+    header->cells = NTUPLE_CELLS;
+    header->games = network.games();
+
+    std::int16_t* weights = reinterpret_cast<std::int16_t*>(
+                static_cast<char*>(data) + sizeof(QuantizedNTupleHeader));
+    for( int t = 0; t < NTUPLE_COUNT; ++t )
+    {
+        // The largest weight of the tuple gets the largest integer
+        float largest = 0.0f;
+        for( std::uint32_t i = 0; i < NTUPLE_WEIGHTS; ++i )
+        {
+            largest = std::max(largest, std::fabs(network.weight(t, i)));
+        }
+        float scale = largest == 0.0f ? 1.0f : largest / MAX_QUANTIZED;
+        header->scales[t] = scale;
+
+        std::int16_t* table = weights + t * NTUPLE_WEIGHTS;
+        for( std::uint32_t i = 0; i < NTUPLE_WEIGHTS; ++i )
+        {
+            long quantized = std::lround(network.weight(t, i) / scale);
+            if( quantized > MAX_QUANTIZED )
+            {
+                quantized = MAX_QUANTIZED;
+            }
+            else if( quantized < -MAX_QUANTIZED )
+            {
+                quantized = -MAX_QUANTIZED;
+            }
+            table[i] = std::int16_t(quantized);
+        }
+    }
+    msync(data, FILE_SIZE, MS_SYNC);
+    munmap(data, FILE_SIZE);
+
+    if( std::rename(temporary.c_str(), path.c_str()) != 0 )
+    {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool run_ntuple_benchmark(const std::string& float_path,
+                          const std::string& quantized_path,
+                          std::uint64_t evaluations, std::ostream& out)
+{
+    drop_from_cache(float_path);
+    drop_from_cache(quantized_path);
+
+    std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+    NTupleNetwork network;
+    if( not network.load(float_path) )
+    {
+        std::cerr << "Not an n-tuple network: " << float_path << std::endl;
+        return false;
+    }
+    double float_load = seconds_since(begin);
+
+    begin = std::chrono::steady_clock::now();
+    QuantizedNTuple quantized;
+    if( not quantized.open(quantized_path) )
+    {
+        std::cerr << "Not a quantized n-tuple network: " << quantized_path
+                  << std::endl;
+        return false;
+    }
+    double quantized_load = seconds_since(begin);
+
+    // Boards the network really meets
+    std::vector<PackedBoard> boards;
+    PackedGame game;
+    for( int seed = 0; boards.size() < BENCHMARK_BOARDS; ++seed )
+    {
+        game.start(seed, NO_GOAL, FAST_RNG);
+        Direction dir;
+        PackedMove result;
+        double value = 0.0;
+        while( boards.size() < BENCHMARK_BOARDS and
+               network.best_move(game.board(), dir, result, value) )
+        {
+            boards.push_back(game.board());
+            game.step(dir);
+        }
+    }
+
+    // The first pass over the boards faults the pages in
+    double sum = 0.0;
+    begin = std::chrono::steady_clock::now();
+    for( PackedBoard board : boards )
+    {
+        sum += quantized.value(board);
+    }
+    double first_pass = seconds_since(begin);
+
+    begin = std::chrono::steady_clock::now();
+    for( std::uint64_t i = 0; i < evaluations; ++i )
+    {
+        sum += network.value(boards[i % boards.size()]);
+    }
+    double float_seconds = seconds_since(begin);
+
+    begin = std::chrono::steady_clock::now();
+    for( std::uint64_t i = 0; i < evaluations; ++i )
+    {
+        sum += quantized.value(boards[i % boards.size()]);
+    }
+    double quantized_seconds = seconds_since(begin);
+
+    // How much the rounding changes the play
+    std::size_t same = 0;
+    double largest_error = 0.0;
+    for( PackedBoard board : boards )
+    {
+        Direction float_dir = UP;
+        Direction quantized_dir = UP;
+        PackedMove result;
+        double float_value = 0.0;
+        double quantized_value = 0.0;
+        network.best_move(board, float_dir, result, float_value);
+        quantized.best_move(board, quantized_dir, result, quantized_value);
+        if( float_dir == quantized_dir )
+        {
+            ++same;
+        }
+        largest_error = std::max(largest_error,
+                                 std::fabs(float_value - quantized_value));
+    }
+
+    out << "load: float " << float_load * 1000 << " ms, quantized "
+        << quantized_load * 1000 << " ms" << std::endl;
+    out << "first " << boards.size() << " quantized evaluations: "
+        << first_pass * 1000 << " ms" << std::endl;
+    out << "evaluations/s: float " << evaluations / float_seconds
+        << ", quantized " << evaluations / quantized_seconds << std::endl;
+    out << "same move: " << 100.0 * same / boards.size()
+        << "%, largest value error " << largest_error << std::endl;
+
+    // Keeps the evaluations from being optimized away
+    if( sum == 0.123456789 )
+    {
+        out << std::endl;
+    }
+    return true;
+}
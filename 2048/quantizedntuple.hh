@@ -0,0 +1,99 @@
+/* QuantizedNTuple
+ *
+ * The weights of an NTupleNetwork in a file that is used as it is.
+ * Every weight is a 16 bit integer and every tuple has a scale, the
+ * weight being the integer times the scale, so the file is half the
+ * size of the float one and opening it only maps it: the pages are
+ * read from the disk, or shared from the page cache, when they are
+ * first looked at.
+ *
+ * A board is evaluated tuple by tuple: the positions of all the
+ * lookups are computed first, then the weights of each tuple are added
+ * up as integers and scaled once. The loads don't depend on each
+ * other, so the processor can wait for all their cache lines at the
+ * same time.
+ *
+ * The file starts with a header:
+ *
+ *      magic "2048NTQZ" (8), version (4), tuples (4), cells (4),
+ *      reserved (4), games trained (8), scale of every tuple (4 * 4),
+ *      reserved (16)
+ *
+ * followed by the weights of every tuple, all in the byte order of
+ * the machine.
+*/
+
+#ifndef QUANTIZEDNTUPLE_HH
+#define QUANTIZEDNTUPLE_HH
+
+#include "ntuple.hh"
+#include <ostream>
+#include <string>
+
+struct QuantizedNTupleHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t tuples;
+    std::uint32_t cells;
+    std::uint32_t reserved;
+    std::uint64_t games;
+    float scales[NTUPLE_COUNT];
+    char reserved_end[16];
+};
+
+static_assert(sizeof(QuantizedNTupleHeader) == 64,
+              "Unexpected header size");
+
+const char QUANTIZED_NTUPLE_MAGIC[8] = {'2', '0', '4', '8',
+                                        'N', 'T', 'Q', 'Z'};
+const std::uint32_t QUANTIZED_NTUPLE_VERSION = 1;
+
+class QuantizedNTuple
+{
+public:
+    QuantizedNTuple();
+
+    // Destructor, unmaps the file.
+    ~QuantizedNTuple();
+
+    QuantizedNTuple(const QuantizedNTuple&) = delete;
+    QuantizedNTuple& operator=(const QuantizedNTuple&) = delete;
+
+    // Maps the given file for reading. Returns false, if the file
+    // doesn't exist or isn't a quantized network.
+    bool open(const std::string& path);
+
+    // Returns true, if a network is open.
+    bool is_open() const;
+
+    // Header of the open network.
+    const QuantizedNTupleHeader& header() const;
+
+    // Same as NTupleNetwork::value and NTupleNetwork::best_move,
+    // within the rounding of the weights.
+    double value(PackedBoard board) const;
+    bool best_move(PackedBoard board, Direction& dir, PackedMove& result,
+                   double& value) const;
+
+    // Writes the weights of the network to the given file, each tuple
+    // scaled so that its largest weight fits.
+    static bool write(const NTupleNetwork& network,
+                      const std::string& path);
+
+private:
+    void* data_;
+    std::size_t size_;
+    const std::int16_t* weights_;
+};
+
+// Compares the float network in float_path with the quantized one in
+// quantized_path: the time to load them from the disk, the time of the
+// first evaluations, which bring the pages of the quantized weights in,
+// the evaluations per second and how often they choose the same move.
+// Returns false, if either file can't be loaded.
+bool run_ntuple_benchmark(const std::string& float_path,
+                          const std::string& quantized_path,
+                          std::uint64_t evaluations, std::ostream& out);
+
+#endif // QUANTIZEDNTUPLE_HH
@@ -0,0 +1,256 @@
+#include "rng.hh"
+
+namespace
+{
+
+// Parameters of std::minstd_rand0
+const std::uint64_t MINSTD_MULTIPLIER = 16807;
+const std::uint64_t MINSTD_MODULUS = 2147483647;
+const std::uint32_t MINSTD_MIN = 1;
+const std::uint32_t MINSTD_MAX = MINSTD_MODULUS - 1;
+
+std::uint64_t rotate_left(std::uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+std::uint64_t splitmix64(std::uint64_t& x)
+{
+    std::uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+int count_bits(std::uint64_t mask)
+{
+    int count = 0;
+    for( ; mask != 0; mask &= mask - 1 )
+    {
+        ++count;
+    }
+    return count;
+}
+
+int lowest_bit(std::uint64_t mask)
+{
+    int bit = 0;
+    while( not (mask & 1) )
+    {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+}
+
+}
+
+LegacyRng::LegacyRng():
+    state_(1)
+{
+}
+
+void LegacyRng::seed(int seed)
+{
+    // The seed is converted to the (64 bit) result type first
+    std::uint64_t value = static_cast<std::uint64_t>(
+                static_cast<std::int64_t>(seed)) % MINSTD_MODULUS;
+    state_ = value == 0 ? 1 : value;
+}
+
+int LegacyRng::uniform(int range)
+{
+    // Scale down by rejecting the numbers beyond the last full bucket,
+    // as libstdc++ does when the engine has a wider range
+    const std::uint32_t engine_range = MINSTD_MAX - MINSTD_MIN;
+    const std::uint32_t scaling = engine_range / range;
+    const std::uint32_t past = range * scaling;
+    std::uint32_t result = 0;
+    do
+    {
+        result = next() - MINSTD_MIN;
+    } while( result >= past );
+    return result / scaling;
+}
+
+std::uint32_t LegacyRng::state() const
+{
+    return state_;
+}
+
+void LegacyRng::set_state(std::uint32_t state)
+{
+    state_ = state;
+}
+
+std::uint32_t LegacyRng::next()
+{
+    state_ = (MINSTD_MULTIPLIER * state_) % MINSTD_MODULUS;
+    return state_;
+}
+
+FastRng::FastRng()
+{
+    seed(0);
+}
+
+void FastRng::seed(std::uint64_t seed)
+{
+    for( int i = 0; i < 4; ++i )
+    {
+        state_[i] = splitmix64(seed);
+    }
+}
+
+std::uint64_t FastRng::next()
+{
+    std::uint64_t result = rotate_left(state_[1] * 5, 7) * 9;
+    std::uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotate_left(state_[3], 45);
+    return result;
+}
+
+std::uint32_t FastRng::uniform(std::uint32_t range)
+{
+    // Lemire's multiply and shift, with rejection to remove the bias
+    std::uint64_t product = (next() >> 32) * range;
+    std::uint32_t low = static_cast<std::uint32_t>(product);
+    if( low < range )
+    {
+        std::uint32_t threshold = (0u - range) % range;
+        while( low < threshold )
+        {
+            product = (next() >> 32) * range;
+            low = static_cast<std::uint32_t>(product);
+        }
+    }
+    return product >> 32;
+}
+
+void FastRng::jump()
+{
+    static const std::uint64_t JUMP[] = {
+        0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+        0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+
+    std::uint64_t result[4] = {0, 0, 0, 0};
+    for( int i = 0; i < 4; ++i )
+    {
+        for( int b = 0; b < 64; ++b )
+        {
+            if( JUMP[i] & (std::uint64_t(1) << b) )
+            {
+                for( int j = 0; j < 4; ++j )
+                {
+                    result[j] ^= state_[j];
+                }
+            }
+            next();
+        }
+    }
+    set_state(result);
+}
+
+void FastRng::get_state(std::uint64_t state[4]) const
+{
+    for( int i = 0; i < 4; ++i )
+    {
+        state[i] = state_[i];
+    }
+}
+
+void FastRng::set_state(const std::uint64_t state[4])
+{
+    for( int i = 0; i < 4; ++i )
+    {
+        state_[i] = state[i];
+    }
+}
+
+SpawnRng::SpawnRng(int size):
+    size_(size), mode_(LEGACY_RNG), spawns_(0), spawn_retries_(0)
+{
+}
+
+void SpawnRng::seed(int seed, RngMode mode)
+{
+    mode_ = mode;
+    spawns_ = 0;
+    spawn_retries_ = 0;
+    if( mode_ == LEGACY_RNG )
+    {
+        legacy_.seed(seed);
+
+        // Wiping out the first random number (which is almost almost 0)
+        legacy_.uniform(size_);
+    }
+    else
+    {
+        fast_.seed(static_cast<std::uint32_t>(seed));
+    }
+}
+
+RngMode SpawnRng::mode() const
+{
+    return mode_;
+}
+
+int SpawnRng::pick_empty_cell(std::uint64_t empty_mask)
+{
+    ++spawns_;
+    if( mode_ == LEGACY_RNG )
+    {
+        int random_x = legacy_.uniform(size_);
+        int random_y = legacy_.uniform(size_);
+        while( not ((empty_mask >> (random_y * size_ + random_x)) & 1) )
+        {
+            ++spawn_retries_;
+            random_x = legacy_.uniform(size_);
+            random_y = legacy_.uniform(size_);
+        }
+        return random_y * size_ + random_x;
+    }
+
+    // Skip the empty cells before the chosen one
+    int skip = fast_.uniform(count_bits(empty_mask));
+    for( int i = 0; i < skip; ++i )
+    {
+        empty_mask &= empty_mask - 1;
+    }
+    return lowest_bit(empty_mask);
+}
+
+LegacyRng& SpawnRng::legacy()
+{
+    return legacy_;
+}
+
+FastRng& SpawnRng::fast()
+{
+    return fast_;
+}
+
+const LegacyRng& SpawnRng::legacy() const
+{
+    return legacy_;
+}
+
+const FastRng& SpawnRng::fast() const
+{
+    return fast_;
+}
+
+std::uint32_t SpawnRng::spawns() const
+{
+    return spawns_;
+}
+
+std::uint32_t SpawnRng::spawn_retries() const
+{
+    return spawn_retries_;
+}
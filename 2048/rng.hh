@@ -0,0 +1,151 @@
+/* Rng
+ *
+ * Random number generators used to place the new tiles.
+ *
+ * LegacyRng reproduces what std::default_random_engine and
+ * std::uniform_int_distribution do with GCC's standard library, which
+ * the game has always used. It is written out here so that the seeds
+ * give the same games with any compiler.
+ *
+ * FastRng is xoshiro256**. It is faster, and a stream can be split in
+ * 2^128 long independent parts with jump(), so every worker thread can
+ * have its own part of the same stream. seed() runs the seed through
+ * splitmix64, so every game gets its own stream just from its number.
+ *
+ * SpawnRng chooses the cell of a new tile with either of them. In the
+ * legacy mode cells are drawn until an empty one is found, like
+ * GameBoard::new_value has always done, in the fast mode one of the
+ * empty cells is picked directly. Both give every empty cell the same
+ * probability, but different games for the same seed.
+*/
+
+#ifndef RNG_HH
+#define RNG_HH
+
+#include <cstdint>
+
+enum RngMode { LEGACY_RNG, FAST_RNG };
+
+class LegacyRng
+{
+public:
+    LegacyRng();
+
+    // Same as std::minstd_rand0::seed.
+    void seed(int seed);
+
+    // Same as std::uniform_int_distribution<int>(0, range - 1) with
+    // std::minstd_rand0.
+    int uniform(int range);
+
+    // The state, and setting it back.
+    std::uint32_t state() const;
+    void set_state(std::uint32_t state);
+
+private:
+    std::uint32_t state_;
+
+    std::uint32_t next();
+};
+
+class FastRng
+{
+public:
+    FastRng();
+
+    // Sets the state from the given seed with splitmix64.
+    void seed(std::uint64_t seed);
+
+    // Returns the next 64 random bits.
+    std::uint64_t next();
+
+    // Returns a number in [0, range).
+    std::uint32_t uniform(std::uint32_t range);
+
+    // Moves the stream 2^128 steps ahead.
+    void jump();
+
+    // The state, and setting it back.
+    void get_state(std::uint64_t state[4]) const;
+    void set_state(const std::uint64_t state[4]);
+
+private:
+    std::uint64_t state_[4];
+};
+
+class SpawnRng
+{
+public:
+    // Constructor, cells are numbered y * size + x.
+    explicit SpawnRng(int size);
+
+    // Seeds the generator for a new game. Like GameBoard::fill, the
+    // legacy mode throws away the first number.
+    void seed(int seed, RngMode mode = LEGACY_RNG);
+
+    RngMode mode() const;
+
+    // Returns the number of one of the cells whose bit is set in
+    // empty_mask, which must not be 0. For boards up to 8x8.
+    int pick_empty_cell(std::uint64_t empty_mask);
+
+    // Same for boards of any size, is_empty(cell) tells if the cell
+    // is empty. At least one cell must be empty.
+    template <typename IsEmpty>
+    int pick_empty_cell(IsEmpty is_empty);
+
+    // The generators, for saving and restoring the state.
+    LegacyRng& legacy();
+    FastRng& fast();
+    const LegacyRng& legacy() const;
+    const FastRng& fast() const;
+
+    // Cells picked since the last seed, and the cells the legacy mode
+    // drew and threw away because they weren't empty.
+    std::uint32_t spawns() const;
+    std::uint32_t spawn_retries() const;
+
+private:
+    int size_;
+    RngMode mode_;
+    LegacyRng legacy_;
+    FastRng fast_;
+    std::uint32_t spawns_;
+    std::uint32_t spawn_retries_;
+};
+
+template <typename IsEmpty>
+int SpawnRng::pick_empty_cell(IsEmpty is_empty)
+{
+    ++spawns_;
+    if( mode_ == LEGACY_RNG )
+    {
+        int random_x = legacy_.uniform(size_);
+        int random_y = legacy_.uniform(size_);
+        while( not is_empty(random_y * size_ + random_x) )
+        {
+            ++spawn_retries_;
+            random_x = legacy_.uniform(size_);
+            random_y = legacy_.uniform(size_);
+        }
+        return random_y * size_ + random_x;
+    }
+
+    int cells = size_ * size_;
+    int empty = 0;
+    for( int i = 0; i < cells; ++i )
+    {
+        empty += is_empty(i) ? 1 : 0;
+    }
+    int skip = fast_.uniform(empty);
+    for( int i = 0; i < cells; ++i )
+    {
+        if( is_empty(i) and skip-- == 0 )
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#endif // RNG_HH
@@ -0,0 +1,131 @@
+#include "seedindex.hh"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SeedIndex::SeedIndex():
+    data_(nullptr), size_(0)
+{
+}
+
+SeedIndex::~SeedIndex()
+{
+    if( data_ != nullptr )
+    {
+        munmap(data_, size_);
+    }
+}
+
+bool SeedIndex::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if( fd < 0 )
+    {
+        return false;
+    }
+    struct stat status;
+    if( fstat(fd, &status) != 0 or
+        std::size_t(status.st_size) < sizeof(SeedIndexHeader) )
+    {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if( data == MAP_FAILED )
+    {
+        return false;
+    }
+
+    // Check that the file is what it should be
+    const SeedIndexHeader* header = static_cast<SeedIndexHeader*>(data);
+    if( std::memcmp(header->magic, SEED_INDEX_MAGIC, 8) != 0 or
+        header->version != SEED_INDEX_VERSION or
+        std::size_t(status.st_size) < sizeof(SeedIndexHeader)
+                                      + header->count * sizeof(SeedRecord) )
+    {
+        munmap(data, status.st_size);
+        return false;
+    }
+
+    if( data_ != nullptr )
+    {
+        munmap(data_, size_);
+    }
+    data_ = data;
+    size_ = status.st_size;
+    return true;
+}
+
+bool SeedIndex::is_open() const
+{
+    return data_ != nullptr;
+}
+
+const SeedIndexHeader& SeedIndex::header() const
+{
+    return *static_cast<const SeedIndexHeader*>(data_);
+}
+
+const SeedRecord* SeedIndex::find(std::uint32_t seed) const
+{
+    if( data_ == nullptr or seed < header().first_seed or
+        seed - header().first_seed >= header().count )
+    {
+        return nullptr;
+    }
+    const SeedRecord* record = records() + (seed - header().first_seed);
+    return record->runs > 0 ? record : nullptr;
+}
+
+bool SeedIndex::suggest(bool easy, std::uint32_t start,
+                        std::uint32_t& seed) const
+{
+    if( data_ == nullptr or header().count == 0 )
+    {
+        return false;
+    }
+
+    bool found = false;
+    double best = 0.0;
+    std::uint32_t count = header().count;
+    for( std::uint32_t i = 0; i < count; ++i )
+    {
+        std::uint32_t index = (start + i) % count;
+        const SeedRecord& record = records()[index];
+        if( record.runs == 0 )
+        {
+            continue;
+        }
+
+        // Easier seeds have a higher win rate
+        double rate = win_rate(record);
+        if( (easy and rate >= EASY_WIN_RATE) or
+            (not easy and rate <= HARD_WIN_RATE) )
+        {
+            seed = header().first_seed + index;
+            return true;
+        }
+        double difficulty = easy ? rate : -rate;
+        if( not found or difficulty > best )
+        {
+            found = true;
+            best = difficulty;
+            seed = header().first_seed + index;
+        }
+    }
+    return found;
+}
+
+const SeedRecord* SeedIndex::records() const
+{
+    return reinterpret_cast<const SeedRecord*>(
+                static_cast<const char*>(data_) + sizeof(SeedIndexHeader));
+}
+
+double win_rate(const SeedRecord& record)
+{
+    return record.runs > 0 ? double(record.wins) / record.runs : 0.0;
+}
@@ -0,0 +1,99 @@
+/* SeedIndex
+ *
+ * Difficulty of every seed, written by SeedSweep and read by the GUI.
+ *
+ * The index is a file of fixed size records that is memory-mapped,
+ * so opening it costs nothing and the record of a seed is found by
+ * its position. The file starts with a header:
+ *
+ *      magic "2048SIDX" (8), version (4), first seed (4), count (4),
+ *      runs per seed (4), target exponent (4), reserved (4),
+ *      strategy name (32)
+ *
+ * and is followed by one record per seed:
+ *
+ *      opening board (8), mean moves (4), wins (2), runs (2)
+ *
+ * The opening is the packed board GameBoard::fill makes from the seed.
+ * A record with 0 runs hasn't been played yet. All the numbers are in
+ * the byte order of the machine.
+*/
+
+#ifndef SEEDINDEX_HH
+#define SEEDINDEX_HH
+
+#include "packedboard.hh"
+#include <string>
+
+struct SeedIndexHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t first_seed;
+    std::uint32_t count;
+    std::uint32_t runs;
+    std::uint32_t target_exponent;
+    std::uint32_t reserved;
+    char strategy[32];
+};
+
+struct SeedRecord
+{
+    PackedBoard opening;
+    std::uint32_t mean_moves;
+    std::uint16_t wins;
+    std::uint16_t runs;
+};
+
+static_assert(sizeof(SeedIndexHeader) == 64, "Unexpected header size");
+static_assert(sizeof(SeedRecord) == 16, "Unexpected record size");
+
+const char SEED_INDEX_MAGIC[8] = {'2', '0', '4', '8', 'S', 'I', 'D', 'X'};
+const std::uint32_t SEED_INDEX_VERSION = 1;
+
+// Win rates at or above this are easy, at or below HARD_WIN_RATE hard
+const double EASY_WIN_RATE = 0.75;
+const double HARD_WIN_RATE = 0.25;
+
+class SeedIndex
+{
+public:
+    SeedIndex();
+
+    // Destructor, unmaps the file.
+    ~SeedIndex();
+
+    SeedIndex(const SeedIndex&) = delete;
+    SeedIndex& operator=(const SeedIndex&) = delete;
+
+    // Maps the given index file for reading. Returns false, if the file
+    // doesn't exist or isn't a seed index.
+    bool open(const std::string& path);
+
+    // Returns true, if an index is open.
+    bool is_open() const;
+
+    // Header of the open index.
+    const SeedIndexHeader& header() const;
+
+    // Returns the record of the given seed, or nullptr if the seed
+    // isn't in the index or hasn't been played yet.
+    const SeedRecord* find(std::uint32_t seed) const;
+
+    // Looks for an easy (or a hard) seed, starting from the given
+    // position so that different calls can give different seeds. If
+    // there is no easy (hard) seed, gives the easiest (hardest) one.
+    // Returns false, if no seed has been played.
+    bool suggest(bool easy, std::uint32_t start, std::uint32_t& seed) const;
+
+private:
+    void* data_;
+    std::size_t size_;
+
+    const SeedRecord* records() const;
+};
+
+// Win rate of the given record.
+double win_rate(const SeedRecord& record);
+
+#endif // SEEDINDEX_HH
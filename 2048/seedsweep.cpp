@@ -0,0 +1,214 @@
+#include "seedsweep.hh"
+#include "batchrunner.hh"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Number of seeds a thread takes at a time
+const std::uint32_t CHUNK_SIZE = 16;
+
+// How often the progress is printed
+const int PROGRESS_INTERVAL_MS = 1000;
+
+const int MAX_RUNS = 65535;
+
+// Targets a PackedGame can reach, it doesn't merge two 2^15 tiles
+const int MIN_TARGET_EXPONENT = 2;
+
+}
+
+SeedSweep::SeedSweep(const std::string& strategy, int target_exponent,
+                     int runs, int threads):
+    strategy_(strategy), target_exponent_(target_exponent), runs_(runs),
+    threads_(threads)
+{
+    if( threads_ <= 0 )
+    {
+        threads_ = std::thread::hardware_concurrency();
+    }
+    if( threads_ <= 0 )
+    {
+        threads_ = 1;
+    }
+}
+
+bool SeedSweep::run(const std::string& path, std::uint32_t first_seed,
+                    std::uint32_t count, std::ostream& progress)
+{
+    if( not create_strategy(strategy_) or strategy_.size() >= 32 )
+    {
+        std::cerr << "Unknown strategy: " << strategy_ << std::endl;
+        return false;
+    }
+    if( runs_ < 1 or runs_ > MAX_RUNS )
+    {
+        std::cerr << "Runs per seed must be 1.." << MAX_RUNS << std::endl;
+        return false;
+    }
+    if( target_exponent_ < MIN_TARGET_EXPONENT or
+        target_exponent_ > MAX_PACKED_EXPONENT )
+    {
+        std::cerr << "The target must be " << MIN_TARGET_EXPONENT << ".."
+                  << MAX_PACKED_EXPONENT << std::endl;
+        return false;
+    }
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat status;
+    if( fd < 0 or fstat(fd, &status) != 0 )
+    {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // A new file gets a header and empty records, an old one has to
+    // come from a sweep with the same settings
+    SeedIndexHeader header = make_header(first_seed, count);
+    std::size_t size = sizeof(SeedIndexHeader) + count * sizeof(SeedRecord);
+    bool resumed = status.st_size != 0;
+    if( resumed )
+    {
+        SeedIndexHeader old;
+        if( std::size_t(status.st_size) != size or
+            pread(fd, &old, sizeof(old), 0) != sizeof(old) or
+            std::memcmp(&old, &header, sizeof(header)) != 0 )
+        {
+            std::cerr << path << " was made with different settings"
+                      << std::endl;
+            close(fd);
+            return false;
+        }
+    }
+    else if( ftruncate(fd, size) != 0 or
+             pwrite(fd, &header, sizeof(header), 0) != sizeof(header) )
+    {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd, 0);
+    close(fd);
+    if( data == MAP_FAILED )
+    {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    SeedRecord* records = reinterpret_cast<SeedRecord*>(
+                static_cast<char*>(data) + sizeof(SeedIndexHeader));
+
+    std::uint32_t missing = 0;
+    for( std::uint32_t i = 0; i < count; ++i )
+    {
+        if( records[i].runs == 0 )
+        {
+            ++missing;
+        }
+    }
+    if( resumed )
+    {
+        progress << "Resuming, " << count - missing << " of " << count
+                 << " seeds done" << std::endl;
+    }
+
+    std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+    std::atomic<std::uint32_t> next_chunk(0);
+    std::atomic<std::uint32_t> finished(0);
+    std::vector<std::thread> workers;
+    for( int t = 0; t < threads_; ++t )
+    {
+        workers.push_back(std::thread([&]()
+        {
+            std::unique_ptr<Strategy> strategy = create_strategy(strategy_);
+            while( true )
+            {
+                std::uint32_t first = next_chunk.fetch_add(CHUNK_SIZE);
+                if( first >= count )
+                {
+                    break;
+                }
+                std::uint32_t last = first + CHUNK_SIZE < count ?
+                            first + CHUNK_SIZE : count;
+                for( std::uint32_t i = first; i < last; ++i )
+                {
+                    if( records[i].runs != 0 )
+                    {
+                        continue;
+                    }
+                    std::uint32_t seed = first_seed + i;
+                    PackedGame opening;
+                    opening.start(seed, target_exponent_);
+
+                    std::uint32_t wins = 0;
+                    std::uint64_t moves = 0;
+                    for( int r = 0; r < runs_; ++r )
+                    {
+                        GameRecord game = play_game(*strategy, seed,
+                                                    target_exponent_,
+                                                    seed * runs_ + r);
+                        wins += game.state == WON;
+                        moves += game.moves;
+                    }
+
+                    // Mark the record done only when it is complete
+                    records[i].opening = opening.board();
+                    records[i].mean_moves = moves / runs_;
+                    records[i].wins = wins;
+                    std::atomic_thread_fence(std::memory_order_release);
+                    records[i].runs = runs_;
+                    ++finished;
+                }
+            }
+        }));
+    }
+
+    while( finished < missing )
+    {
+        std::this_thread::sleep_for(
+                    std::chrono::milliseconds(PROGRESS_INTERVAL_MS));
+        progress << "\r" << count - missing + finished << " / " << count
+                 << " seeds" << std::flush;
+    }
+    for( std::thread& worker : workers )
+    {
+        worker.join();
+    }
+    msync(data, size, MS_SYNC);
+    munmap(data, size);
+
+    double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+    progress << "\rPlayed " << missing << " seeds (" << missing * runs_
+             << " games) in " << seconds << " s on " << threads_
+             << " threads" << std::endl;
+    return true;
+}
+
+SeedIndexHeader SeedSweep::make_header(std::uint32_t first_seed,
+                                       std::uint32_t count) const
+{
+    SeedIndexHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SEED_INDEX_MAGIC, sizeof(header.magic));
+    header.version = SEED_INDEX_VERSION;
+    header.first_seed = first_seed;
+    header.count = count;
+    header.runs = runs_;
+    header.target_exponent = target_exponent_;
+    std::strncpy(header.strategy, strategy_.c_str(),
+                 sizeof(header.strategy) - 1);
+    return header;
+}
@@ -0,0 +1,47 @@
+/* SeedSweep
+ *
+ * Plays every seed in a range several times with a reference strategy
+ * and writes the results to a SeedIndex file.
+ *
+ * The index file is memory-mapped for writing and every worker thread
+ * writes the records of its seeds straight into it. A record is marked
+ * done only after it has been fully written, so an interrupted sweep
+ * can be run again with the same arguments and it plays only the seeds
+ * that are missing.
+ *
+ * Run r of seed s starts the strategy with s * runs + r, so that a
+ * randomized strategy plays every run differently.
+*/
+
+#ifndef SEEDSWEEP_HH
+#define SEEDSWEEP_HH
+
+#include "seedindex.hh"
+#include <ostream>
+#include <string>
+
+class SeedSweep
+{
+public:
+    // Constructor, 0 threads means one per core.
+    SeedSweep(const std::string& strategy, int target_exponent, int runs,
+              int threads = 0);
+
+    // Creates the index file, or opens an unfinished one made with the
+    // same settings, and plays the seeds that haven't been played.
+    // Returns false, and prints the reason, if that isn't possible.
+    bool run(const std::string& path, std::uint32_t first_seed,
+             std::uint32_t count, std::ostream& progress);
+
+private:
+    std::string strategy_;
+    int target_exponent_;
+    int runs_;
+    int threads_;
+
+    // Fills in the header of a new index file.
+    SeedIndexHeader make_header(std::uint32_t first_seed,
+                                std::uint32_t count) const;
+};
+
+#endif // SEEDSWEEP_HH
@@ -0,0 +1,529 @@
+#include "shardedrunner.hh"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <poll.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "The rings need lock free atomics between processes");
+
+namespace
+{
+
+// Shards per worker, if the seeds are enough, so that a worker that
+// gets slow seeds doesn't hold up the others
+const std::uint32_t SHARDS_PER_WORKER = 8;
+
+// Games a worker plays between writing its results to the ring
+const std::uint32_t BLOCK_SIZE = 4 * BATCH_CHUNK_SIZE;
+
+// How long the coordinator waits for messages before reading the rings
+// again, and how long a worker waits for room in a full ring
+const int POLL_MILLISECONDS = 20;
+const int FULL_RING_MICROSECONDS = 200;
+
+// Sends a message, false if the other end is gone
+bool send_message(int socket, const ShardMessage& message)
+{
+    return send(socket, &message, sizeof(message), MSG_NOSIGNAL) ==
+            ssize_t(sizeof(message));
+}
+
+// Receives a message, false if the other end is gone
+bool receive_message(int socket, ShardMessage& message)
+{
+    while( true )
+    {
+        ssize_t received = recv(socket, &message, sizeof(message), 0);
+        if( received < 0 and errno == EINTR )
+        {
+            continue;
+        }
+        return received == ssize_t(sizeof(message));
+    }
+}
+
+// The cores this process may run on
+std::vector<int> allowed_cores()
+{
+    std::vector<int> cores;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if( sched_getaffinity(0, sizeof(set), &set) == 0 )
+    {
+        for( int c = 0; c < CPU_SETSIZE; ++c )
+        {
+            if( CPU_ISSET(c, &set) )
+            {
+                cores.push_back(c);
+            }
+        }
+    }
+    return cores;
+}
+
+// Cores of the given worker: an equal share of the allowed cores, or
+// one of them when there are more workers than cores
+std::vector<int> worker_cores(const std::vector<int>& allowed, int worker,
+                              int workers)
+{
+    std::vector<int> cores;
+    int n = allowed.size();
+    if( n == 0 )
+    {
+        return cores;
+    }
+    if( workers >= n )
+    {
+        cores.push_back(allowed.at(worker % n));
+        return cores;
+    }
+    for( int c = worker * n / workers; c < (worker + 1) * n / workers; ++c )
+    {
+        cores.push_back(allowed.at(c));
+    }
+    return cores;
+}
+
+// Describes how a worker ended
+std::string describe_status(int status, bool quit)
+{
+    if( WIFSIGNALED(status) )
+    {
+        return "killed by signal " + std::to_string(WTERMSIG(status)) +
+               " (" + strsignal(WTERMSIG(status)) + ")";
+    }
+    if( WIFEXITED(status) and WEXITSTATUS(status) != 0 )
+    {
+        return "exited with status " + std::to_string(WEXITSTATUS(status));
+    }
+    return quit ? "done" : "lost";
+}
+
+}
+
+ShardedRunner::ShardedRunner(const std::string& strategy, int workers):
+    strategy_(strategy), workers_(workers), rng_mode_(LEGACY_RNG),
+    seconds_(0.0), moves_(0)
+{
+    if( workers_ <= 0 )
+    {
+        workers_ = std::thread::hardware_concurrency();
+    }
+    if( workers_ <= 0 )
+    {
+        workers_ = 1;
+    }
+}
+
+bool ShardedRunner::run(std::uint32_t first_seed, std::uint32_t count,
+                        int goal_exponent, std::vector<GameRecord>& records)
+{
+    records.clear();
+    last_workers_.clear();
+    if( not check_strategy(strategy_) )
+    {
+        return false;
+    }
+    std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+
+    // The shards start at multiples of the chunk size from the first
+    // seed, as the chunks of BatchRunner do
+    std::uint32_t shard_size = count / (workers_ * SHARDS_PER_WORKER);
+    shard_size = (shard_size + BATCH_CHUNK_SIZE - 1) / BATCH_CHUNK_SIZE *
+                 BATCH_CHUNK_SIZE;
+    if( shard_size == 0 )
+    {
+        shard_size = BATCH_CHUNK_SIZE;
+    }
+    std::uint32_t next_shard = 0;
+
+    // The rings are mapped before forking, so every worker shares its
+    // own with the coordinator
+    std::size_t ring_bytes = workers_ * sizeof(ShardRing);
+    void* memory = mmap(nullptr, ring_bytes, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if( memory == MAP_FAILED )
+    {
+        std::cerr << "Can't map the result rings: " << std::strerror(errno)
+                  << std::endl;
+        return false;
+    }
+    ShardRing* rings = static_cast<ShardRing*>(memory);
+    for( int w = 0; w < workers_; ++w )
+    {
+        new(&rings[w].head) std::atomic<std::uint64_t>(0);
+        new(&rings[w].tail) std::atomic<std::uint64_t>(0);
+    }
+
+    std::vector<int> allowed = allowed_cores();
+    bool ok = true;
+    for( int w = 0; w < workers_; ++w )
+    {
+        Worker worker = Worker();
+        worker.cores = worker_cores(allowed, w, workers_);
+        int sockets[2];
+        if( socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets) != 0 )
+        {
+            std::cerr << "Can't create a control socket: "
+                      << std::strerror(errno) << std::endl;
+            ok = false;
+            break;
+        }
+        worker.pid = fork();
+        if( worker.pid < 0 )
+        {
+            std::cerr << "Can't start a worker: " << std::strerror(errno)
+                      << std::endl;
+            close(sockets[0]);
+            close(sockets[1]);
+            ok = false;
+            break;
+        }
+        if( worker.pid == 0 )
+        {
+            // The worker doesn't outlive the coordinator, and keeps only
+            // its own end of its own channel
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            close(sockets[0]);
+            for( const Worker& other : last_workers_ )
+            {
+                close(other.socket);
+            }
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for( int core : worker.cores )
+            {
+                CPU_SET(core, &set);
+            }
+            if( not worker.cores.empty() )
+            {
+                sched_setaffinity(0, sizeof(set), &set);
+            }
+            int threads = worker.cores.empty() ? 0 : worker.cores.size();
+            _exit(work(sockets[1], rings[w], threads, goal_exponent));
+        }
+        close(sockets[1]);
+        worker.socket = sockets[0];
+        last_workers_.push_back(worker);
+    }
+
+    // Hand out the shards until every worker has quit or died
+    std::vector<GameRecord> slots(count);
+    std::vector<bool> received(count, false);
+    std::vector<ShardMessage> again;
+    auto playing = [this]()
+    {
+        for( const Worker& worker : last_workers_ )
+        {
+            if( worker.socket >= 0 and worker.shard_count != 0 )
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+    std::vector<pollfd> fds;
+    std::size_t open_sockets = last_workers_.size();
+    while( open_sockets > 0 )
+    {
+        fds.clear();
+        for( const Worker& worker : last_workers_ )
+        {
+            fds.push_back({worker.socket, POLLIN, 0});
+        }
+        if( poll(fds.data(), fds.size(), POLL_MILLISECONDS) < 0 and
+            errno != EINTR )
+        {
+            break;
+        }
+        for( std::size_t w = 0; w < last_workers_.size(); ++w )
+        {
+            Worker& worker = last_workers_[w];
+            drain(rings[w], worker, first_seed, slots, received);
+            if( worker.socket < 0 or fds[w].revents == 0 )
+            {
+                continue;
+            }
+
+            ShardMessage message;
+            if( not receive_message(worker.socket, message) )
+            {
+                // A worker that goes away without being told has died,
+                // its shard is played again once
+                drain(rings[w], worker, first_seed, slots, received);
+                close(worker.socket);
+                worker.socket = -1;
+                --open_sockets;
+                if( worker.shard_count != 0 and not worker.shard_again )
+                {
+                    ShardMessage shard = ShardMessage();
+                    shard.type = SHARD_WORK;
+                    shard.first_seed = worker.shard_first;
+                    shard.count = worker.shard_count;
+                    again.push_back(shard);
+                }
+                continue;
+            }
+            if( message.type == SHARD_DONE )
+            {
+                worker.moves += message.moves;
+                worker.busy_seconds += message.seconds;
+                ++worker.shards;
+                worker.shard_count = 0;
+            }
+            worker.waiting = true;
+        }
+
+        // The shards of the dead workers go first. A worker quits only
+        // when no other one is playing a shard that may still be lost.
+        for( Worker& worker : last_workers_ )
+        {
+            if( worker.socket < 0 or not worker.waiting )
+            {
+                continue;
+            }
+            ShardMessage reply = ShardMessage();
+            if( not again.empty() )
+            {
+                reply = again.back();
+                again.pop_back();
+                worker.shard_again = true;
+            }
+            else if( next_shard < count )
+            {
+                reply.type = SHARD_WORK;
+                reply.first_seed = first_seed + next_shard;
+                reply.count = count - next_shard < shard_size ?
+                            count - next_shard : shard_size;
+                next_shard += reply.count;
+                worker.shard_again = false;
+            }
+            else if( playing() )
+            {
+                continue;
+            }
+            else
+            {
+                reply.type = SHARD_QUIT;
+                worker.quit = true;
+            }
+            if( reply.type == SHARD_WORK )
+            {
+                worker.shard_first = reply.first_seed;
+                worker.shard_count = reply.count;
+            }
+            worker.waiting = false;
+            send_message(worker.socket, reply);
+        }
+    }
+
+    for( std::size_t w = 0; w < last_workers_.size(); ++w )
+    {
+        Worker& worker = last_workers_[w];
+        if( worker.socket >= 0 )
+        {
+            kill(worker.pid, SIGKILL);
+            close(worker.socket);
+            worker.socket = -1;
+        }
+        while( waitpid(worker.pid, &worker.status, 0) < 0 and
+               errno == EINTR )
+        {
+        }
+        drain(rings[w], worker, first_seed, slots, received);
+        bool clean = worker.quit and WIFEXITED(worker.status) and
+                     WEXITSTATUS(worker.status) == 0;
+        if( not clean )
+        {
+            ok = false;
+            std::cerr << "Worker " << worker.pid << " "
+                      << describe_status(worker.status, worker.quit);
+            if( worker.shard_count != 0 )
+            {
+                std::cerr << " in the shard of seeds "
+                          << worker.shard_first << ".."
+                          << worker.shard_first + worker.shard_count - 1
+                          << (worker.shard_again ? ", played again" : "");
+            }
+            std::cerr << std::endl;
+        }
+    }
+    munmap(memory, ring_bytes);
+
+    // Seeds that were lost, or that no worker got to when every worker
+    // died
+    moves_ = 0;
+    for( std::uint32_t i = 0; i < count; ++i )
+    {
+        if( received[i] )
+        {
+            records.push_back(slots[i]);
+            moves_ += slots[i].moves;
+            continue;
+        }
+        std::uint32_t last = i;
+        while( last + 1 < count and not received[last + 1] )
+        {
+            ++last;
+        }
+        std::cerr << "Seeds " << first_seed + i << ".." << first_seed + last
+                  << " weren't played" << std::endl;
+        ok = false;
+        i = last;
+    }
+    seconds_ = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+    return ok;
+}
+
+bool ShardedRunner::check_strategy(const std::string& strategy)
+{
+    pid_t pid = fork();
+    if( pid < 0 )
+    {
+        std::cerr << "Can't check the strategy: " << std::strerror(errno)
+                  << std::endl;
+        return false;
+    }
+    if( pid == 0 )
+    {
+        _exit(create_strategy(strategy) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    int status = 0;
+    while( waitpid(pid, &status, 0) < 0 and errno == EINTR )
+    {
+    }
+    if( WIFSIGNALED(status) )
+    {
+        std::cerr << "Creating " << strategy << " was "
+                  << describe_status(status, false) << std::endl;
+    }
+    return WIFEXITED(status) and WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+void ShardedRunner::set_rng_mode(RngMode mode)
+{
+    rng_mode_ = mode;
+}
+
+int ShardedRunner::workers() const
+{
+    return workers_;
+}
+
+double ShardedRunner::seconds() const
+{
+    return seconds_;
+}
+
+std::uint64_t ShardedRunner::moves() const
+{
+    return moves_;
+}
+
+void ShardedRunner::print_workers(std::ostream& out) const
+{
+    for( const Worker& worker : last_workers_ )
+    {
+        out << "worker " << worker.pid << ", cores";
+        for( int core : worker.cores )
+        {
+            out << " " << core;
+        }
+        out << ": " << worker.shards << " shards, " << worker.games
+            << " games, " << worker.moves << " moves in "
+            << worker.busy_seconds << " s, "
+            << describe_status(worker.status, worker.quit) << std::endl;
+    }
+}
+
+int ShardedRunner::work(int socket, ShardRing& ring, int threads,
+                        int goal_exponent)
+{
+    ShardMessage message = ShardMessage();
+    message.type = SHARD_HELLO;
+    if( not send_message(socket, message) )
+    {
+        return EXIT_FAILURE;
+    }
+    BatchRunner runner(strategy_, threads);
+    runner.set_rng_mode(rng_mode_);
+    std::vector<GameRecord> block;
+    while( receive_message(socket, message) and message.type == SHARD_WORK )
+    {
+        std::chrono::steady_clock::time_point begin =
+                std::chrono::steady_clock::now();
+        std::uint64_t moves = 0;
+        for( std::uint32_t done = 0; done < message.count;
+             done += BLOCK_SIZE )
+        {
+            std::uint32_t size = message.count - done < BLOCK_SIZE ?
+                        message.count - done : BLOCK_SIZE;
+            if( not runner.run(message.first_seed + done, size,
+                               goal_exponent, block) )
+            {
+                return EXIT_FAILURE;
+            }
+            moves += runner.moves();
+
+            // Only this process writes the head
+            std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+            for( const GameRecord& record : block )
+            {
+                while( head - ring.tail.load(std::memory_order_acquire) ==
+                       SHARD_RING_SIZE )
+                {
+                    usleep(FULL_RING_MICROSECONDS);
+                }
+                ring.records[head % SHARD_RING_SIZE] = record;
+                ring.head.store(++head, std::memory_order_release);
+            }
+        }
+
+        ShardMessage done = ShardMessage();
+        done.type = SHARD_DONE;
+        done.moves = moves;
+        done.seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - begin).count();
+        if( not send_message(socket, done) )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    close(socket);
+    return EXIT_SUCCESS;
+}
+
+void ShardedRunner::drain(ShardRing& ring, Worker& worker,
+                          std::uint32_t first_seed,
+                          std::vector<GameRecord>& slots,
+                          std::vector<bool>& received)
+{
+    std::uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    std::uint64_t head = ring.head.load(std::memory_order_acquire);
+    for( ; tail != head; ++tail )
+    {
+        const GameRecord& record = ring.records[tail % SHARD_RING_SIZE];
+        std::uint32_t index = record.seed - first_seed;
+        if( index < slots.size() )
+        {
+            slots[index] = record;
+            received[index] = true;
+            ++worker.games;
+        }
+    }
+    ring.tail.store(tail, std::memory_order_release);
+}
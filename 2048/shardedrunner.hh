@@ -0,0 +1,162 @@
+/* ShardedRunner
+ *
+ * Plays a range of seeds like BatchRunner, but in worker processes
+ * forked for the run, so that a strategy that crashes takes only its
+ * own worker down, and every worker has its own allocator and threads.
+ *
+ * Every worker is pinned to its own set of the cores the process may
+ * use and plays on all of them with a BatchRunner. The seeds are cut
+ * into shards, aligned to BATCH_CHUNK_SIZE so that the games are the
+ * same as in one process, and handed out one at a time to the workers
+ * that ask for more.
+ *
+ * The coordinator and the workers talk through a Unix socket pair per
+ * worker, with fixed size messages (ShardMessage):
+ *
+ *      worker:      HELLO, DONE after every shard
+ *      coordinator: WORK (first seed, count), or QUIT when no shard
+ *                   is left
+ *
+ * The results of the games don't go through the sockets. Every worker
+ * has a ring of GameRecords in memory shared with the coordinator,
+ * written by the worker and read by the coordinator, so a result costs
+ * no system call. A worker waits, when its ring is full.
+ *
+ * A worker that dies is reported with its signal or exit status, and
+ * its shard is played again by the next worker that asks for one. The
+ * workers that run out of shards wait until the others are done, in
+ * case one of them dies. A shard is played again only once, so a seed
+ * that crashes the strategy every time can't take down all the
+ * workers. The seeds that were still lost are reported, and are
+ * missing from the results.
+ *
+ * The coordinator never creates the strategy, not even to check the
+ * name: a plugin that crashes while starting would take it down. The
+ * strategy is created in a forked process instead, see
+ * check_strategy().
+*/
+
+#ifndef SHARDEDRUNNER_HH
+#define SHARDEDRUNNER_HH
+
+#include "batchrunner.hh"
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+// Records in the ring of a worker, a power of two
+const std::size_t SHARD_RING_SIZE = 4096;
+
+// A message of the control channel
+struct ShardMessage
+{
+    std::uint32_t type;
+    std::uint32_t first_seed;
+    std::uint32_t count;
+    std::uint32_t reserved;
+
+    // Of DONE: the moves of the shard and the time it took
+    std::uint64_t moves;
+    double seconds;
+};
+
+enum ShardMessageType
+{
+    SHARD_HELLO = 1,
+    SHARD_WORK,
+    SHARD_DONE,
+    SHARD_QUIT
+};
+
+// Results of one worker, in the memory shared with the coordinator
+struct ShardRing
+{
+    // Records written by the worker and read by the coordinator, on
+    // cache lines of their own
+    std::atomic<std::uint64_t> head;
+    char head_padding[64 - sizeof(std::atomic<std::uint64_t>)];
+    std::atomic<std::uint64_t> tail;
+    char tail_padding[64 - sizeof(std::atomic<std::uint64_t>)];
+
+    GameRecord records[SHARD_RING_SIZE];
+};
+
+class ShardedRunner
+{
+public:
+    // Constructor, 0 workers means one per core.
+    ShardedRunner(const std::string& strategy, int workers = 0);
+
+    // Plays a game for every seed in [first_seed, first_seed + count)
+    // and puts the results in records, in seed order. Returns false, if
+    // the strategy doesn't exist or a worker failed, records then has
+    // only the games that were played. Must be called when the process
+    // has no other threads, the workers are forked.
+    bool run(std::uint32_t first_seed, std::uint32_t count,
+             int goal_exponent, std::vector<GameRecord>& records);
+
+    // Returns true, if the strategy exists. It is created in a forked
+    // process, which is reported if it crashes. Must be called when the
+    // process has no other threads.
+    static bool check_strategy(const std::string& strategy);
+
+    // Chooses the generator for the new tiles, see BatchRunner.
+    void set_rng_mode(RngMode mode);
+
+    // Number of worker processes.
+    int workers() const;
+
+    // Wall clock time and the total number of moves of the last run.
+    double seconds() const;
+    std::uint64_t moves() const;
+
+    // Prints a line per worker of the last run: its cores, the games
+    // and moves it played and how it ended.
+    void print_workers(std::ostream& out) const;
+
+private:
+    // A worker of the last run
+    struct Worker
+    {
+        pid_t pid;
+        int socket;
+        std::vector<int> cores;
+
+        // The shard being played, whether it is played again, and the
+        // shards done
+        std::uint32_t shard_first;
+        std::uint32_t shard_count;
+        bool shard_again;
+        std::uint32_t shards;
+
+        // Whether it has asked for a shard and got no answer yet
+        bool waiting;
+
+        std::uint64_t games;
+        std::uint64_t moves;
+        double busy_seconds;
+
+        // Status from waitpid, and whether it quit when told to
+        int status;
+        bool quit;
+    };
+
+    std::string strategy_;
+    int workers_;
+    RngMode rng_mode_;
+    double seconds_;
+    std::uint64_t moves_;
+    std::vector<Worker> last_workers_;
+
+    // The body of a worker process, returns its exit status.
+    int work(int socket, ShardRing& ring, int threads, int goal_exponent);
+
+    // Takes the new records of the ring.
+    void drain(ShardRing& ring, Worker& worker, std::uint32_t first_seed,
+               std::vector<GameRecord>& slots,
+               std::vector<bool>& received);
+};
+
+#endif // SHARDEDRUNNER_HH
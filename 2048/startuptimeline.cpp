@@ -0,0 +1,69 @@
+#include "startuptimeline.hh"
+#include <QtGlobal>
+#include <cstdio>
+
+namespace {
+
+// The step the budget is for
+const char FIRST_FRAME[] = "first frame";
+
+}
+
+StartupTimeline& StartupTimeline::instance()
+{
+    static StartupTimeline timeline;
+    return timeline;
+}
+
+StartupTimeline::StartupTimeline()
+{
+}
+
+void StartupTimeline::start()
+{
+    clock.start();
+    marks.clear();
+    trace = qEnvironmentVariableIsSet("NUMBERS_STARTUP_TRACE");
+    exitAfterFrame = qEnvironmentVariableIsSet("NUMBERS_STARTUP_EXIT");
+    budget = qEnvironmentVariableIntValue("NUMBERS_STARTUP_BUDGET_MS");
+}
+
+void StartupTimeline::mark(const QString& step)
+{
+    if ( !clock.isValid() || elapsed(step) >= 0 ) {
+        return;
+    }
+    qint64 now = clock.elapsed();
+    marks.append(qMakePair(step, now));
+
+    if ( trace ) {
+        fprintf(stderr, "startup: %-20s %6lld ms\n", qPrintable(step),
+                static_cast<long long>(now));
+    }
+    if ( step == FIRST_FRAME && budget > 0 && now > budget ) {
+        fprintf(stderr, "startup: first frame took %lld ms, the budget is "
+                "%lld ms\n", static_cast<long long>(now),
+                static_cast<long long>(budget));
+    }
+}
+
+qint64 StartupTimeline::elapsed(const QString& step) const
+{
+    for ( auto& mark : marks ) {
+        if ( mark.first == step ) {
+            return mark.second;
+        }
+    }
+    return -1;
+}
+
+bool StartupTimeline::withinBudget() const
+{
+    qint64 frame = elapsed(FIRST_FRAME);
+    return budget <= 0 || (frame >= 0 && frame <= budget);
+}
+
+bool StartupTimeline::exitAfterFirstFrame() const
+{
+    return exitAfterFrame;
+}
@@ -0,0 +1,59 @@
+/* StartupTimeline
+ *
+ * Measures how long the start of the program takes. The clock starts
+ * in main() and every step of the start is marked once, with the time
+ * from the start, for example "first frame" when the board is painted
+ * for the first time and "first move drawn" when the result of the
+ * first move is on the screen.
+ *
+ * The timeline is printed to stderr when the environment variable
+ * NUMBERS_STARTUP_TRACE is set. NUMBERS_STARTUP_BUDGET_MS sets the
+ * largest allowed time to the first frame, going over it prints a
+ * warning. With NUMBERS_STARTUP_EXIT set the program quits after the
+ * first frame, with the exit status 1 if it was over the budget, so
+ * the start can be checked in a script.
+*/
+
+#ifndef STARTUPTIMELINE_HH
+#define STARTUPTIMELINE_HH
+
+#include <QElapsedTimer>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class StartupTimeline
+{
+public:
+    // The timeline of this program
+    static StartupTimeline& instance();
+
+    // Starts the clock and reads the settings from the environment
+    void start();
+
+    // Marks the given step done now, only the first mark of every
+    // step counts
+    void mark(const QString& step);
+
+    // Milliseconds from the start to the step, -1 if not done yet
+    qint64 elapsed(const QString& step) const;
+
+    // True, if the first frame was not later than the budget
+    bool withinBudget() const;
+
+    // True, if the program should quit after the first frame
+    bool exitAfterFirstFrame() const;
+
+private:
+    StartupTimeline();
+
+    QElapsedTimer clock;
+    QVector<QPair<QString, qint64>> marks;
+    bool trace = false;
+    bool exitAfterFrame = false;
+
+    // Budget of the first frame in milliseconds, 0 if there is none
+    qint64 budget = 0;
+};
+
+#endif // STARTUPTIMELINE_HH
@@ -0,0 +1,894 @@
+#include "strategy.hh"
+#include "gameboard.hh"
+#include "symmetry.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <mutex>
+
+namespace
+{
+
+const double EMPTY_WEIGHT = 4.0;
+const double MERGE_WEIGHT = 1.0;
+const double MONOTONIC_WEIGHT = 1.0;
+
+const int MAX_EXPECTIMAX_DEPTH = 6;
+
+// Longest time per move of AnytimeExpectimaxStrategy, in microseconds
+const long MAX_ANYTIME_MICROSECONDS = 10000000;
+
+// Nodes searched between looking at the clock, a power of two
+const std::uint64_t CLOCK_INTERVAL = 64;
+
+// The search stops this part of its time before the deadline, to have
+// time to return
+const int DEADLINE_MARGIN = 32;
+
+// Probability of a random move in NoisyGreedyStrategy, per mille
+const std::uint32_t NOISE = 100;
+
+// Exponent of NEW_VALUE
+const int NEW_EXPONENT = 1;
+
+// How well the given line is sorted in either direction. A perfectly
+// sorted line gets 0, every step the wrong way costs its size.
+double line_monotonicity(const int line[SIZE])
+{
+    double increasing = 0.0;
+    double decreasing = 0.0;
+    for( int i = 0; i + 1 < SIZE; ++i )
+    {
+        if( line[i] > line[i + 1] )
+        {
+            increasing -= line[i] - line[i + 1];
+        }
+        else
+        {
+            decreasing -= line[i + 1] - line[i];
+        }
+    }
+    return increasing > decreasing ? increasing : decreasing;
+}
+
+// Heuristic value of every possible row, evaluate_board adds up
+// the values of the rows and the columns
+struct HeuristicTable
+{
+    std::vector<float> values;
+
+    HeuristicTable();
+};
+
+HeuristicTable::HeuristicTable():
+    values(1 << 16)
+{
+    for( int row = 0; row < 1 << 16; ++row )
+    {
+        int line[SIZE];
+        int empty = 0;
+        int merges = 0;
+        int previous = 0;
+        for( int i = 0; i < SIZE; ++i )
+        {
+            line[i] = (row >> (4 * i)) & 0xF;
+            if( line[i] == 0 )
+            {
+                ++empty;
+                continue;
+            }
+            if( line[i] == previous )
+            {
+                ++merges;
+            }
+            previous = line[i];
+        }
+        values.at(row) = EMPTY_WEIGHT * empty + MERGE_WEIGHT * merges +
+                         MONOTONIC_WEIGHT * line_monotonicity(line);
+    }
+}
+
+const HeuristicTable& heuristic()
+{
+    static const HeuristicTable instance;
+    return instance;
+}
+
+// Counters of the AnytimeExpectimaxStrategy objects destroyed so far,
+// by name
+std::mutex search_statistics_mutex;
+std::map<std::string, SearchStatistics> search_statistics;
+
+// A move at the root of AnytimeExpectimaxStrategy
+struct RootMove
+{
+    Direction dir;
+    PackedMove result;
+    double value;
+};
+
+// Sorts the moves by their values, best first, keeping the order of
+// equal values
+void sort_root_moves(RootMove* moves, int count)
+{
+    std::stable_sort(moves, moves + count,
+                     [](const RootMove& a, const RootMove& b)
+    {
+        return a.value > b.value;
+    });
+}
+
+}
+
+Strategy::~Strategy()
+{
+}
+
+void Strategy::start_game(std::uint32_t)
+{
+}
+
+void Strategy::choose_batch(const PackedBoard* boards, std::size_t count,
+                            Direction* dirs)
+{
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        dirs[i] = UP;
+        choose(boards[i], dirs[i]);
+    }
+}
+
+bool Strategy::prefers_batches() const
+{
+    return false;
+}
+
+Direction legal_move(PackedBoard board, Direction dir)
+{
+    if( packed::move(board, dir).board != board )
+    {
+        return dir;
+    }
+    for( int d = 0; d < DIRECTION_COUNT; ++d )
+    {
+        if( packed::move(board, Direction(d)).board != board )
+        {
+            return Direction(d);
+        }
+    }
+    return dir;
+}
+
+double evaluate_board(PackedBoard board)
+{
+    const std::vector<float>& values = heuristic().values;
+    PackedBoard columns = packed::transpose(board);
+    double value = 0.0;
+    for( int i = 0; i < SIZE; ++i )
+    {
+        value += values[(board >> (16 * i)) & 0xFFFF];
+        value += values[(columns >> (16 * i)) & 0xFFFF];
+    }
+    return value;
+}
+
+std::string RandomStrategy::name() const
+{
+    return "random";
+}
+
+void RandomStrategy::start_game(std::uint32_t seed)
+{
+    randomEng_.seed(seed);
+}
+
+bool RandomStrategy::choose(PackedBoard board, Direction& dir)
+{
+    Direction moves[DIRECTION_COUNT];
+    int count = 0;
+    for( int d = 0; d < DIRECTION_COUNT; ++d )
+    {
+        if( packed::move(board, Direction(d)).board != board )
+        {
+            moves[count++] = Direction(d);
+        }
+    }
+    if( count == 0 )
+    {
+        return false;
+    }
+    dir = moves[randomEng_.uniform(count)];
+    return true;
+}
+
+std::string GreedyStrategy::name() const
+{
+    return "greedy";
+}
+
+bool GreedyStrategy::choose(PackedBoard board, Direction& dir)
+{
+    bool found = false;
+    double best = 0.0;
+    for( int d = 0; d < DIRECTION_COUNT; ++d )
+    {
+        PackedMove result = packed::move(board, Direction(d));
+        if( result.board == board )
+        {
+            continue;
+        }
+
+        // The game is lost, if the board is full after the move
+        double value = packed::count_empty(result.board) == 0 ?
+                    LOSS_VALUE : result.score + evaluate_board(result.board);
+        if( not found or value > best )
+        {
+            found = true;
+            best = value;
+            dir = Direction(d);
+        }
+    }
+    return found;
+}
+
+std::string NoisyGreedyStrategy::name() const
+{
+    return "noisy-greedy";
+}
+
+void NoisyGreedyStrategy::start_game(std::uint32_t seed)
+{
+    randomEng_.seed(seed);
+    random_.start_game(seed + 1);
+}
+
+bool NoisyGreedyStrategy::choose(PackedBoard board, Direction& dir)
+{
+    if( randomEng_.uniform(1000) < NOISE )
+    {
+        return random_.choose(board, dir);
+    }
+    return GreedyStrategy::choose(board, dir);
+}
+
+ExpectimaxStrategy::ExpectimaxStrategy(
+        int depth, std::shared_ptr<TranspositionTable> table,
+        std::size_t table_megabytes):
+    depth_(depth), table_(table), table_megabytes_(table_megabytes),
+    searcher_(table ? table->add_searcher() : 0)
+{
+}
+
+std::string ExpectimaxStrategy::name() const
+{
+    std::string result = "expectimax:" + std::to_string(depth_);
+    if( table_ )
+    {
+        result += ":tt" + std::to_string(table_megabytes_);
+    }
+    return result;
+}
+
+bool ExpectimaxStrategy::choose(PackedBoard board, Direction& dir)
+{
+    if( table_ )
+    {
+        table_->new_search(searcher_);
+    }
+    bool found = false;
+    double best = 0.0;
+    for( int d = 0; d < DIRECTION_COUNT; ++d )
+    {
+        PackedMove result = packed::move(board, Direction(d));
+        if( result.board == board )
+        {
+            continue;
+        }
+        double value = result.score + chance_node(result.board, depth_);
+        if( not found or value > best )
+        {
+            found = true;
+            best = value;
+            dir = Direction(d);
+        }
+    }
+    return found;
+}
+
+double ExpectimaxStrategy::max_node(PackedBoard board, int depth)
+{
+    if( depth == 0 )
+    {
+        return evaluate_board(board);
+    }
+
+    // The images of a board have the same value, so they share an entry
+    PackedBoard key = 0;
+    if( table_ )
+    {
+        key = symmetry::canonical(board);
+        double cached = 0.0;
+        if( table_->probe(key, depth, cached) )
+        {
+            return cached;
+        }
+    }
+
+    double best = LOSS_VALUE;
+    for( int d = 0; d < DIRECTION_COUNT; ++d )
+    {
+        PackedMove result = packed::move(board, Direction(d));
+        if( result.board == board )
+        {
+            continue;
+        }
+        double value = result.score + chance_node(result.board, depth);
+        if( value > best )
+        {
+            best = value;
+        }
+    }
+    if( table_ )
+    {
+        table_->store(key, depth, best, searcher_);
+    }
+    return best;
+}
+
+double ExpectimaxStrategy::chance_node(PackedBoard board, int depth)
+{
+    int empty = 0;
+    double sum = 0.0;
+    for( int i = 0; i < SIZE * SIZE; ++i )
+    {
+        if( ((board >> (4 * i)) & 0xF) != 0 )
+        {
+            continue;
+        }
+        ++empty;
+        sum += max_node(board | (PackedBoard(NEW_EXPONENT) << (4 * i)),
+                        depth - 1);
+    }
+
+    // The game is lost, if the board is full after the move
+    return empty == 0 ? LOSS_VALUE : sum / empty;
+}
+
+SearchStatistics::SearchStatistics():
+    searches(0), nodes(0), seconds(0.0), depths(), overruns(0),
+    max_overrun_seconds(0.0)
+{
+}
+
+void SearchStatistics::add(const SearchStatistics& other)
+{
+    searches += other.searches;
+    nodes += other.nodes;
+    seconds += other.seconds;
+    for( int d = 0; d <= MAX_ANYTIME_DEPTH; ++d )
+    {
+        depths[d] += other.depths[d];
+    }
+    overruns += other.overruns;
+    max_overrun_seconds = std::max(max_overrun_seconds,
+                                   other.max_overrun_seconds);
+}
+
+void SearchStatistics::print(std::ostream& out,
+                             const std::string& name) const
+{
+    double depth_sum = 0.0;
+    for( int d = 0; d <= MAX_ANYTIME_DEPTH; ++d )
+    {
+        depth_sum += double(d) * depths[d];
+    }
+    double mean_depth = searches == 0 ? 0.0 : depth_sum / searches;
+    double nodes_per_second = seconds == 0.0 ? 0.0 : nodes / seconds;
+    double overrun_rate = searches == 0 ?
+                0.0 : 100.0 * overruns / searches;
+    out << name << ": " << searches << " searches, mean depth "
+        << std::fixed << std::setprecision(2) << mean_depth << ", "
+        << std::setprecision(0) << nodes_per_second << " nodes/s"
+        << std::endl;
+    out << "  depth reached:" << std::setprecision(1);
+    for( int d = 0; d <= MAX_ANYTIME_DEPTH; ++d )
+    {
+        if( depths[d] != 0 )
+        {
+            out << " " << d << ": " << 100.0 * depths[d] / searches << "%";
+        }
+    }
+    out << std::endl;
+    out << "  deadline overruns " << overruns << " (" << std::setprecision(3)
+        << overrun_rate << "%), longest " << max_overrun_seconds * 1.0e6
+        << " us" << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+AnytimeExpectimaxStrategy::AnytimeExpectimaxStrategy(
+        std::chrono::microseconds budget,
+        std::shared_ptr<TranspositionTable> table,
+        std::size_t table_megabytes):
+    budget_(budget), table_(table), table_megabytes_(table_megabytes),
+    searcher_(table ? table->add_searcher() : 0), last_depth_(0),
+    nodes_(0), stopped_(false)
+{
+}
+
+AnytimeExpectimaxStrategy::~AnytimeExpectimaxStrategy()
+{
+    if( statistics_.searches != 0 )
+    {
+        std::lock_guard<std::mutex> lock(search_statistics_mutex);
+        search_statistics[name()].add(statistics_);
+    }
+}
+
+std::string AnytimeExpectimaxStrategy::name() const
+{
+    std::string result = "anytime:" + std::to_string(budget_.count());
+    if( table_ )
+    {
+        result += ":tt" + std::to_string(table_megabytes_);
+    }
+    return result;
+}
+
+bool AnytimeExpectimaxStrategy::choose(PackedBoard board, Direction& dir)
+{
+    return choose_until(board, dir,
+                        std::chrono::steady_clock::now() + budget_);
+}
+
+bool AnytimeExpectimaxStrategy::choose_until(
+        PackedBoard board, Direction& dir,
+        std::chrono::steady_clock::time_point deadline)
+{
+    std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+    stop_time_ = deadline - (deadline - begin) / DEADLINE_MARGIN;
+    nodes_ = 0;
+    stopped_ = false;
+    if( table_ )
+    {
+        table_->new_search(searcher_);
+    }
+
+    // The first order is the one of GreedyStrategy
+    RootMove moves[DIRECTION_COUNT];
+    int count = 0;
+    for( int d = 0; d < DIRECTION_COUNT; ++d )
+    {
+        PackedMove result = packed::move(board, Direction(d));
+        if( result.board == board )
+        {
+            continue;
+        }
+        double value = packed::count_empty(result.board) == 0 ?
+                    LOSS_VALUE : result.score + evaluate_board(result.board);
+        moves[count++] = {Direction(d), result, value};
+    }
+    if( count == 0 )
+    {
+        return false;
+    }
+    sort_root_moves(moves, count);
+
+    int depth = 0;
+    double last_seconds = 0.0;
+    double previous_seconds = 0.0;
+    for( int d = 1; count > 1 and d <= MAX_ANYTIME_DEPTH; ++d )
+    {
+        // A depth takes about as many times longer than the last one
+        // as the last one did than the one before
+        std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+        double remaining =
+                std::chrono::duration<double>(stop_time_ - start).count();
+        if( previous_seconds > 0.0 and
+            last_seconds * last_seconds / previous_seconds > remaining )
+        {
+            break;
+        }
+
+        double values[DIRECTION_COUNT];
+        int completed = 0;
+        for( int m = 0; m < count; ++m )
+        {
+            double value = moves[m].result.score +
+                           chance_node(moves[m].result.board, d);
+            if( stopped_ )
+            {
+                break;
+            }
+            values[m] = value;
+            ++completed;
+        }
+
+        // The best move of the last depth is searched first, so any
+        // move completed is compared to it at the same depth
+        for( int m = 0; m < completed; ++m )
+        {
+            moves[m].value = values[m];
+        }
+        sort_root_moves(moves, completed);
+        if( stopped_ )
+        {
+            break;
+        }
+        depth = d;
+        previous_seconds = last_seconds;
+        last_seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+    }
+    dir = moves[0].dir;
+
+    std::chrono::steady_clock::time_point end =
+            std::chrono::steady_clock::now();
+    ++statistics_.searches;
+    statistics_.nodes += nodes_;
+    statistics_.seconds +=
+            std::chrono::duration<double>(end - begin).count();
+    ++statistics_.depths[depth];
+    if( end > deadline )
+    {
+        ++statistics_.overruns;
+        statistics_.max_overrun_seconds = std::max(
+                    statistics_.max_overrun_seconds,
+                    std::chrono::duration<double>(end - deadline).count());
+    }
+    last_depth_ = depth;
+    return true;
+}
+
+int AnytimeExpectimaxStrategy::last_depth() const
+{
+    return last_depth_;
+}
+
+std::uint64_t AnytimeExpectimaxStrategy::last_nodes() const
+{
+    return nodes_;
+}
+
+const SearchStatistics& AnytimeExpectimaxStrategy::statistics() const
+{
+    return statistics_;
+}
+
+bool AnytimeExpectimaxStrategy::out_of_time()
+{
+    if( not stopped_ and (++nodes_ & (CLOCK_INTERVAL - 1)) == 0 and
+        std::chrono::steady_clock::now() >= stop_time_ )
+    {
+        stopped_ = true;
+    }
+    return stopped_;
+}
+
+double AnytimeExpectimaxStrategy::max_node(PackedBoard board, int depth)
+{
+    if( out_of_time() )
+    {
+        return 0.0;
+    }
+    if( depth == 0 )
+    {
+        return evaluate_board(board);
+    }
+
+    PackedBoard key = 0;
+    if( table_ )
+    {
+        key = symmetry::canonical(board);
+        double cached = 0.0;
+        if( table_->probe(key, depth, cached) )
+        {
+            return cached;
+        }
+    }
+
+    double best = LOSS_VALUE;
+    for( int d = 0; d < DIRECTION_COUNT; ++d )
+    {
+        PackedMove result = packed::move(board, Direction(d));
+        if( result.board == board )
+        {
+            continue;
+        }
+        double value = result.score + chance_node(result.board, depth);
+        if( value > best )
+        {
+            best = value;
+        }
+    }
+
+    // The value of a stopped search is not a value
+    if( table_ and not stopped_ )
+    {
+        table_->store(key, depth, best, searcher_);
+    }
+    return best;
+}
+
+double AnytimeExpectimaxStrategy::chance_node(PackedBoard board, int depth)
+{
+    int empty = 0;
+    double sum = 0.0;
+    for( int i = 0; i < SIZE * SIZE and not stopped_; ++i )
+    {
+        if( ((board >> (4 * i)) & 0xF) != 0 )
+        {
+            continue;
+        }
+        ++empty;
+        sum += max_node(board | (PackedBoard(NEW_EXPONENT) << (4 * i)),
+                        depth - 1);
+    }
+
+    // The game is lost, if the board is full after the move
+    return empty == 0 ? LOSS_VALUE : sum / empty;
+}
+
+void print_search_statistics(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(search_statistics_mutex);
+    for( const auto& statistics : search_statistics )
+    {
+        statistics.second.print(out, statistics.first);
+    }
+}
+
+NTupleStrategy::NTupleStrategy(const std::string& path):
+    path_(path)
+{
+    // A quantized network is only mapped, so every thread can have its
+    // own without taking more memory
+    if( not quantized_.open(path) )
+    {
+        network_ = shared_ntuple_network(path);
+    }
+}
+
+bool NTupleStrategy::is_open() const
+{
+    return quantized_.is_open() or network_ != nullptr;
+}
+
+std::string NTupleStrategy::name() const
+{
+    return "ntuple:" + path_;
+}
+
+bool NTupleStrategy::choose(PackedBoard board, Direction& dir)
+{
+    PackedMove result;
+    double value = 0.0;
+    if( quantized_.is_open() )
+    {
+        return quantized_.best_move(board, dir, result, value);
+    }
+    return network_->best_move(board, dir, result, value);
+}
+
+TablebaseStrategy::TablebaseStrategy(const std::string& path):
+    path_(path)
+{
+    tablebase_.open(path);
+}
+
+bool TablebaseStrategy::is_open() const
+{
+    return tablebase_.is_open();
+}
+
+std::string TablebaseStrategy::name() const
+{
+    return "tablebase:" + path_;
+}
+
+bool TablebaseStrategy::choose(PackedBoard board, Direction& dir)
+{
+    TablebaseAnswer answer;
+    if( tablebase_.lookup(board, answer) and answer.win_probability > 0.0
+        and packed::move(board, answer.best).board != board )
+    {
+        dir = answer.best;
+        return true;
+    }
+    return GreedyStrategy::choose(board, dir);
+}
+
+PluginStrategy::PluginStrategy(const std::string& path):
+    path_(path), plugin_(shared_strategy_plugin(path)), instance_(nullptr)
+{
+    if( plugin_ )
+    {
+        instance_ = plugin_->api()->create();
+    }
+}
+
+PluginStrategy::~PluginStrategy()
+{
+    if( instance_ != nullptr )
+    {
+        plugin_->api()->destroy(instance_);
+    }
+}
+
+bool PluginStrategy::is_open() const
+{
+    return instance_ != nullptr;
+}
+
+std::string PluginStrategy::plugin_name() const
+{
+    const char* name = plugin_ ? plugin_->api()->name : nullptr;
+    return name != nullptr ? name : path_;
+}
+
+std::string PluginStrategy::name() const
+{
+    return "plugin:" + path_;
+}
+
+void PluginStrategy::start_game(std::uint32_t seed)
+{
+    if( plugin_->api()->start_game != nullptr )
+    {
+        plugin_->api()->start_game(instance_, seed);
+    }
+}
+
+bool PluginStrategy::choose(PackedBoard board, Direction& dir)
+{
+    // choose_batch has already replaced a move that changes nothing,
+    // unless no move changes the board
+    choose_batch(&board, 1, &dir);
+    return packed::move(board, dir).board != board;
+}
+
+void PluginStrategy::choose_batch(const PackedBoard* boards,
+                                  std::size_t count, Direction* dirs)
+{
+    // The boards are passed as they are, PackedBoard is the board of
+    // the interface
+    static_assert(sizeof(PackedBoard) == sizeof(std::uint64_t),
+                  "Unexpected board size");
+    directions_.resize(count);
+    plugin_->api()->choose(instance_, boards, std::uint32_t(count),
+                           directions_.data());
+    // A direction out of range, or one that doesn't change the board,
+    // is replaced with the first one that does
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        Direction dir = directions_[i] < DIRECTION_COUNT ?
+                    Direction(directions_[i]) : UP;
+        dirs[i] = legal_move(boards[i], dir);
+    }
+}
+
+bool PluginStrategy::prefers_batches() const
+{
+    return true;
+}
+
+std::unique_ptr<Strategy> create_strategy(const std::string& name)
+{
+    if( name == "random" )
+    {
+        return std::unique_ptr<Strategy>(new RandomStrategy);
+    }
+    if( name == "greedy" )
+    {
+        return std::unique_ptr<Strategy>(new GreedyStrategy);
+    }
+    if( name == "noisy-greedy" )
+    {
+        return std::unique_ptr<Strategy>(new NoisyGreedyStrategy);
+    }
+
+    const std::string expectimax = "expectimax:";
+    if( name.compare(0, expectimax.size(), expectimax) == 0 )
+    {
+        // The depth may be followed by ":tt<megabytes>"
+        char* end = nullptr;
+        long depth = std::strtol(name.c_str() + expectimax.size(), &end, 10);
+        if( depth < 1 or depth > MAX_EXPECTIMAX_DEPTH )
+        {
+            return std::unique_ptr<Strategy>();
+        }
+        if( *end == '\0' )
+        {
+            return std::unique_ptr<Strategy>(new ExpectimaxStrategy(depth));
+        }
+        const std::string table = ":tt";
+        if( std::string(end).compare(0, table.size(), table) == 0 )
+        {
+            long megabytes = std::strtol(end + table.size(), &end, 10);
+            if( *end == '\0' and megabytes >= 1 and
+                std::size_t(megabytes) <= MAX_TRANSPOSITION_MEGABYTES )
+            {
+                return std::unique_ptr<Strategy>(new ExpectimaxStrategy(
+                        depth, shared_transposition_table(megabytes),
+                        megabytes));
+            }
+        }
+    }
+
+    const std::string anytime = "anytime:";
+    if( name.compare(0, anytime.size(), anytime) == 0 )
+    {
+        // The time per move may be followed by ":tt<megabytes>"
+        char* end = nullptr;
+        long budget = std::strtol(name.c_str() + anytime.size(), &end, 10);
+        if( budget < 1 or budget > MAX_ANYTIME_MICROSECONDS )
+        {
+            return std::unique_ptr<Strategy>();
+        }
+        std::chrono::microseconds micros(budget);
+        if( *end == '\0' )
+        {
+            return std::unique_ptr<Strategy>(
+                        new AnytimeExpectimaxStrategy(micros));
+        }
+        const std::string table = ":tt";
+        if( std::string(end).compare(0, table.size(), table) == 0 )
+        {
+            long megabytes = std::strtol(end + table.size(), &end, 10);
+            if( *end == '\0' and megabytes >= 1 and
+                std::size_t(megabytes) <= MAX_TRANSPOSITION_MEGABYTES )
+            {
+                return std::unique_ptr<Strategy>(
+                            new AnytimeExpectimaxStrategy(
+                                micros, shared_transposition_table(megabytes),
+                                megabytes));
+            }
+        }
+    }
+
+    const std::string ntuple = "ntuple:";
+    if( name.compare(0, ntuple.size(), ntuple) == 0 )
+    {
+        std::unique_ptr<NTupleStrategy> strategy(
+                    new NTupleStrategy(name.substr(ntuple.size())));
+        if( strategy->is_open() )
+        {
+            return std::unique_ptr<Strategy>(strategy.release());
+        }
+    }
+
+    const std::string tablebase = "tablebase:";
+    if( name.compare(0, tablebase.size(), tablebase) == 0 )
+    {
+        std::unique_ptr<TablebaseStrategy> strategy(
+                    new TablebaseStrategy(name.substr(tablebase.size())));
+        if( strategy->is_open() )
+        {
+            return std::unique_ptr<Strategy>(strategy.release());
+        }
+    }
+
+    const std::string plugin = "plugin:";
+    if( name.compare(0, plugin.size(), plugin) == 0 )
+    {
+        std::unique_ptr<PluginStrategy> strategy(
+                    new PluginStrategy(name.substr(plugin.size())));
+        if( strategy->is_open() )
+        {
+            return std::unique_ptr<Strategy>(strategy.release());
+        }
+    }
+    return std::unique_ptr<Strategy>();
+}
+
+std::vector<std::string> strategy_names()
+{
+    std::vector<std::string> names;
+    names.push_back("random");
+    names.push_back("greedy");
+    names.push_back("noisy-greedy");
+    names.push_back("expectimax:1");
+    names.push_back("expectimax:2");
+    return names;
+}
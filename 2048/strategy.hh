@@ -0,0 +1,307 @@
+/* Strategy
+ *
+ * Built-in players that choose the next move from a packed board.
+ * They are used by the autoplay mode of the GUI and by the batch tools
+ * of the headless build.
+ *
+ * A strategy object keeps its own state (for example a random number
+ * generator), so every thread has to use its own instance. Strategies
+ * are created by name with create_strategy, e.g. "greedy",
+ * "expectimax:2", "expectimax:3:tt64", "anytime:2000",
+ * "ntuple:weights.nt", "tablebase:4x4-8.tb" or "plugin:./libcorner.so".
+*/
+
+#ifndef STRATEGY_HH
+#define STRATEGY_HH
+
+#include "packedboard.hh"
+#include "quantizedntuple.hh"
+#include "rng.hh"
+#include "strategyplugin.hh"
+#include "tablebase.hh"
+#include "transpositiontable.hh"
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Strategy
+{
+public:
+    virtual ~Strategy();
+
+    // Returns the name of the strategy.
+    virtual std::string name() const = 0;
+
+    // Called before every game, so that the moves of a randomized
+    // strategy depend only on the seed of the game.
+    virtual void start_game(std::uint32_t seed);
+
+    // Chooses a move for the given board. Returns false, if no move
+    // changes the board, i.e. the game is lost.
+    virtual bool choose(PackedBoard board, Direction& dir) = 0;
+
+    // Chooses a move for each of the given boards of games played at
+    // the same time. A board no move changes gets UP. By default the
+    // boards are chosen for one by one.
+    virtual void choose_batch(const PackedBoard* boards, std::size_t count,
+                              Direction* dirs);
+
+    // Returns true, if the strategy is faster with choose_batch than
+    // with choose, so the games should be played in batches.
+    virtual bool prefers_batches() const;
+};
+
+// Picks one of the moves that change the board at random.
+class RandomStrategy : public Strategy
+{
+public:
+    std::string name() const override;
+    void start_game(std::uint32_t seed) override;
+    bool choose(PackedBoard board, Direction& dir) override;
+
+private:
+    FastRng randomEng_;
+};
+
+// Picks the move that leads to the best looking board right away.
+class GreedyStrategy : public Strategy
+{
+public:
+    std::string name() const override;
+    bool choose(PackedBoard board, Direction& dir) override;
+};
+
+// Plays like GreedyStrategy, but makes a random move every now and
+// then. Used where the same seed has to be played several times with
+// different results, e.g. to measure how hard a seed is.
+class NoisyGreedyStrategy : public GreedyStrategy
+{
+public:
+    std::string name() const override;
+    void start_game(std::uint32_t seed) override;
+    bool choose(PackedBoard board, Direction& dir) override;
+
+private:
+    RandomStrategy random_;
+    FastRng randomEng_;
+};
+
+// Looks the given number of moves ahead, averaging over every cell
+// where the new tile can appear. The values of the boards are kept in
+// the given transposition table, if there is one.
+class ExpectimaxStrategy : public Strategy
+{
+public:
+    explicit ExpectimaxStrategy(
+            int depth,
+            std::shared_ptr<TranspositionTable> table = nullptr,
+            std::size_t table_megabytes = 0);
+
+    std::string name() const override;
+    bool choose(PackedBoard board, Direction& dir) override;
+
+private:
+    int depth_;
+    std::shared_ptr<TranspositionTable> table_;
+    std::size_t table_megabytes_;
+
+    // Number of this object in the table, see add_searcher
+    int searcher_;
+
+    // Best value the player can get from the board.
+    double max_node(PackedBoard board, int depth);
+
+    // Average value over the new tiles added to the board after a move.
+    double chance_node(PackedBoard board, int depth);
+};
+
+// Deepest search of AnytimeExpectimaxStrategy
+const int MAX_ANYTIME_DEPTH = 12;
+
+// Counters of the searches of AnytimeExpectimaxStrategy
+struct SearchStatistics
+{
+    std::uint64_t searches;
+    std::uint64_t nodes;
+    double seconds;
+
+    // Searches by the deepest depth they completed, 0 for the moves
+    // that were taken without a search
+    std::uint64_t depths[MAX_ANYTIME_DEPTH + 1];
+
+    // Searches that returned after their deadline, and the longest time
+    // one was late
+    std::uint64_t overruns;
+    double max_overrun_seconds;
+
+    SearchStatistics();
+
+    // Adds the counters of other.
+    void add(const SearchStatistics& other);
+
+    // Prints the counters on three lines, under the given name.
+    void print(std::ostream& out, const std::string& name) const;
+};
+
+// Searches like ExpectimaxStrategy, one move deeper at a time until the
+// deadline, and plays the best move of the deepest search. A search
+// cut by the deadline still counts for the moves it completed: the
+// moves are searched in the order of the previous depth, best first,
+// so a move found better than that one at the new depth can be
+// trusted. The next depth isn't started if it wouldn't end in time,
+// judging by how much longer the last depth took than the one before.
+// A board with a single move isn't searched at all.
+//
+// The searches of all the objects with the same name are counted
+// together, see print_search_statistics.
+class AnytimeExpectimaxStrategy : public Strategy
+{
+public:
+    // Constructor, every move is searched for the given time.
+    explicit AnytimeExpectimaxStrategy(
+            std::chrono::microseconds budget,
+            std::shared_ptr<TranspositionTable> table = nullptr,
+            std::size_t table_megabytes = 0);
+
+    // Destructor, adds the counters to the ones of the process.
+    ~AnytimeExpectimaxStrategy();
+
+    std::string name() const override;
+    bool choose(PackedBoard board, Direction& dir) override;
+
+    // Chooses a move, searching until the given time.
+    bool choose_until(PackedBoard board, Direction& dir,
+                      std::chrono::steady_clock::time_point deadline);
+
+    // Deepest depth completed and nodes searched by the last search.
+    int last_depth() const;
+    std::uint64_t last_nodes() const;
+
+    // Counters of the searches of this object.
+    const SearchStatistics& statistics() const;
+
+private:
+    std::chrono::microseconds budget_;
+    std::shared_ptr<TranspositionTable> table_;
+    std::size_t table_megabytes_;
+
+    // Number of this object in the table, see add_searcher
+    int searcher_;
+    SearchStatistics statistics_;
+    int last_depth_;
+
+    // The search in progress, stopped a little before the deadline
+    std::chrono::steady_clock::time_point stop_time_;
+    std::uint64_t nodes_;
+    bool stopped_;
+
+    // Returns true, if it is time to stop. Looks at the clock only
+    // every CLOCK_INTERVAL nodes.
+    bool out_of_time();
+
+    // Same as in ExpectimaxStrategy, but the values are meaningless
+    // once the search has been stopped.
+    double max_node(PackedBoard board, int depth);
+    double chance_node(PackedBoard board, int depth);
+};
+
+// Prints the counters of the searches of every AnytimeExpectimaxStrategy
+// destroyed so far, by name.
+void print_search_statistics(std::ostream& out);
+
+// Picks the move that gives the best score plus the value of the
+// board after the slide, as learned by NTupleTrainer. The weights may
+// be a float network or a quantized one.
+class NTupleStrategy : public Strategy
+{
+public:
+    explicit NTupleStrategy(const std::string& path);
+
+    // Returns true, if the weights could be loaded.
+    bool is_open() const;
+
+    std::string name() const override;
+    bool choose(PackedBoard board, Direction& dir) override;
+
+private:
+    std::string path_;
+    QuantizedNTuple quantized_;
+    std::shared_ptr<const NTupleNetwork> network_;
+};
+
+// Plays the best moves of a tablebase, and like GreedyStrategy on the
+// boards that are not in it or where the target can't be reached
+// any more.
+class TablebaseStrategy : public GreedyStrategy
+{
+public:
+    explicit TablebaseStrategy(const std::string& path);
+
+    // Returns true, if the tablebase could be opened.
+    bool is_open() const;
+
+    std::string name() const override;
+    bool choose(PackedBoard board, Direction& dir) override;
+
+private:
+    std::string path_;
+    Tablebase tablebase_;
+};
+
+// Plays a strategy plugin, see StrategyPlugin. Every object has its own
+// instance of the plugin. The plugin is called once per batch, so it
+// prefers batches. A direction the plugin gives that is out of range or
+// doesn't change the board is replaced with the first one that does.
+class PluginStrategy : public Strategy
+{
+public:
+    explicit PluginStrategy(const std::string& path);
+    ~PluginStrategy();
+
+    PluginStrategy(const PluginStrategy&) = delete;
+    PluginStrategy& operator=(const PluginStrategy&) = delete;
+
+    // Returns true, if the plugin could be loaded and its instance
+    // created.
+    bool is_open() const;
+
+    // Name given by the plugin itself
+    std::string plugin_name() const;
+
+    std::string name() const override;
+    void start_game(std::uint32_t seed) override;
+    bool choose(PackedBoard board, Direction& dir) override;
+    void choose_batch(const PackedBoard* boards, std::size_t count,
+                      Direction* dirs) override;
+    bool prefers_batches() const override;
+
+private:
+    std::string path_;
+    std::shared_ptr<const StrategyPlugin> plugin_;
+    void* instance_;
+    std::vector<std::uint8_t> directions_;
+};
+
+// Returns the given move, if it changes the board, otherwise the first
+// move that does. The games ignore a move that changes nothing, so the
+// drivers play this instead of the move of the strategy. A board no
+// move changes keeps the given move, which loses the game.
+Direction legal_move(PackedBoard board, Direction dir);
+
+// Creates the strategy with the given name, or returns nullptr if
+// there is no such strategy.
+std::unique_ptr<Strategy> create_strategy(const std::string& name);
+
+// Names of the built-in strategies, in the order they are listed.
+std::vector<std::string> strategy_names();
+
+// Heuristic value of a board, used by the strategies. Rewards empty
+// cells, possible merges and monotonic rows and columns.
+double evaluate_board(PackedBoard board);
+
+// Value given to a lost board.
+const double LOSS_VALUE = -1.0e6;
+
+#endif // STRATEGY_HH
@@ -0,0 +1,101 @@
+#include "strategyplugin.hh"
+#include <cstring>
+#include <dlfcn.h>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+namespace
+{
+
+// Plugins of shared_strategy_plugin by their library
+std::mutex shared_plugins_mutex;
+std::map<std::string, std::shared_ptr<const StrategyPlugin>> shared_plugins;
+
+}
+
+StrategyPlugin::StrategyPlugin():
+    library_(nullptr), api_(nullptr)
+{
+}
+
+StrategyPlugin::~StrategyPlugin()
+{
+    if( library_ != nullptr )
+    {
+        dlclose(library_);
+    }
+}
+
+bool StrategyPlugin::load(const std::string& path)
+{
+    // A name without a slash would be looked up in the library path
+    std::string file = path.find('/') == std::string::npos ?
+                "./" + path : path;
+    library_ = dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if( library_ == nullptr )
+    {
+        std::cerr << "Can't load " << path << ": " << dlerror() << std::endl;
+        return false;
+    }
+
+    // Going through a data pointer is how POSIX wants it done
+    void* symbol = dlsym(library_, NUMBERS_STRATEGY_API_SYMBOL);
+    numbers_strategy_api_function entry = nullptr;
+    static_assert(sizeof(entry) == sizeof(symbol), "Unexpected pointer size");
+    std::memcpy(&entry, &symbol, sizeof(entry));
+    if( entry != nullptr )
+    {
+        api_ = entry();
+    }
+    if( api_ == nullptr )
+    {
+        std::cerr << path << " is not a strategy plugin" << std::endl;
+    }
+    else if( api_->abi_version != NUMBERS_STRATEGY_ABI_VERSION or
+             api_->struct_size < sizeof(numbers_strategy) )
+    {
+        std::cerr << path << " is made for version " << api_->abi_version
+                  << " of the plugin interface, not "
+                  << NUMBERS_STRATEGY_ABI_VERSION << std::endl;
+        api_ = nullptr;
+    }
+    else if( api_->create == nullptr or api_->destroy == nullptr or
+             api_->choose == nullptr )
+    {
+        std::cerr << path << " lacks a function of the plugin interface"
+                  << std::endl;
+        api_ = nullptr;
+    }
+
+    if( api_ == nullptr )
+    {
+        dlclose(library_);
+        library_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+const numbers_strategy* StrategyPlugin::api() const
+{
+    return api_;
+}
+
+std::shared_ptr<const StrategyPlugin> shared_strategy_plugin(
+        const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(shared_plugins_mutex);
+    std::shared_ptr<const StrategyPlugin>& plugin = shared_plugins[path];
+    if( not plugin )
+    {
+        std::shared_ptr<StrategyPlugin> loaded(new StrategyPlugin);
+        if( not loaded->load(path) )
+        {
+            shared_plugins.erase(path);
+            return nullptr;
+        }
+        plugin = loaded;
+    }
+    return plugin;
+}
@@ -0,0 +1,47 @@
+/* StrategyPlugin
+ *
+ * A strategy plugin loaded from a shared library at run time, see
+ * numbers_strategy.h for the interface the library implements. The
+ * plugins are played with PluginStrategy, e.g. "plugin:./libcorner.so".
+ *
+ * A library is loaded once per process and kept loaded, the strategy
+ * objects of all the threads share it.
+*/
+
+#ifndef STRATEGYPLUGIN_HH
+#define STRATEGYPLUGIN_HH
+
+#include "numbers_strategy.h"
+#include <memory>
+#include <string>
+
+class StrategyPlugin
+{
+public:
+    StrategyPlugin();
+
+    // Destructor, unloads the library.
+    ~StrategyPlugin();
+
+    StrategyPlugin(const StrategyPlugin&) = delete;
+    StrategyPlugin& operator=(const StrategyPlugin&) = delete;
+
+    // Loads the library and checks the version of its interface.
+    // Returns false, and prints the reason, if it isn't a plugin this
+    // build can use.
+    bool load(const std::string& path);
+
+    // The functions of the plugin, nullptr if none is loaded.
+    const numbers_strategy* api() const;
+
+private:
+    void* library_;
+    const numbers_strategy* api_;
+};
+
+// Returns the plugin in the given library, loading it on the first
+// call, or nullptr if it can't be loaded.
+std::shared_ptr<const StrategyPlugin> shared_strategy_plugin(
+        const std::string& path);
+
+#endif // STRATEGYPLUGIN_HH
@@ -0,0 +1,150 @@
+#include "symmetry.hh"
+
+namespace
+{
+
+const int TRANSPOSE = 1;
+const int MIRROR_X = 2;
+const int MIRROR_Y = 4;
+
+// The directions swapped by the parts of a symmetry
+Direction transposed(Direction dir)
+{
+    const Direction swapped[DIRECTION_COUNT] = {LEFT, DOWN, RIGHT, UP};
+    return swapped[dir];
+}
+
+Direction mirrored_x(Direction dir)
+{
+    return dir == LEFT ? RIGHT : dir == RIGHT ? LEFT : dir;
+}
+
+Direction mirrored_y(Direction dir)
+{
+    return dir == UP ? DOWN : dir == DOWN ? UP : dir;
+}
+
+}
+
+namespace symmetry
+{
+
+void map_cell(int size, int s, int y, int x, int& to_y, int& to_x)
+{
+    to_y = y;
+    to_x = x;
+    if( s & TRANSPOSE )
+    {
+        to_y = x;
+        to_x = y;
+    }
+    if( s & MIRROR_X )
+    {
+        to_x = size - 1 - to_x;
+    }
+    if( s & MIRROR_Y )
+    {
+        to_y = size - 1 - to_y;
+    }
+}
+
+Direction map_direction(Direction dir, int s)
+{
+    if( s & TRANSPOSE )
+    {
+        dir = transposed(dir);
+    }
+    if( s & MIRROR_X )
+    {
+        dir = mirrored_x(dir);
+    }
+    if( s & MIRROR_Y )
+    {
+        dir = mirrored_y(dir);
+    }
+    return dir;
+}
+
+Direction unmap_direction(Direction dir, int s)
+{
+    // Every part undoes itself, so they are undone in reverse order
+    if( s & MIRROR_Y )
+    {
+        dir = mirrored_y(dir);
+    }
+    if( s & MIRROR_X )
+    {
+        dir = mirrored_x(dir);
+    }
+    if( s & TRANSPOSE )
+    {
+        dir = transposed(dir);
+    }
+    return dir;
+}
+
+PackedBoard apply(PackedBoard board, int s)
+{
+    if( s & TRANSPOSE )
+    {
+        board = packed::transpose(board);
+    }
+    if( s & MIRROR_X )
+    {
+        board = packed::flip_horizontal(board);
+    }
+    if( s & MIRROR_Y )
+    {
+        board = packed::flip_vertical(board);
+    }
+    return board;
+}
+
+PackedBoard undo(PackedBoard board, int s)
+{
+    if( s & MIRROR_Y )
+    {
+        board = packed::flip_vertical(board);
+    }
+    if( s & MIRROR_X )
+    {
+        board = packed::flip_horizontal(board);
+    }
+    if( s & TRANSPOSE )
+    {
+        board = packed::transpose(board);
+    }
+    return board;
+}
+
+PackedBoard canonical(PackedBoard board, int& s)
+{
+    // One transpose and six mirrors make all the images
+    PackedBoard best = board;
+    s = 0;
+    PackedBoard bases[2] = {board, packed::transpose(board)};
+    for( int t = 0; t < 2; ++t )
+    {
+        PackedBoard x = packed::flip_horizontal(bases[t]);
+        PackedBoard images[4] = {bases[t], x,
+                                 packed::flip_vertical(bases[t]),
+                                 packed::flip_vertical(x)};
+        for( int i = 0; i < 4; ++i )
+        {
+            if( images[i] < best )
+            {
+                best = images[i];
+                s = t | (i << 1);
+            }
+        }
+    }
+    return best;
+}
+
+PackedBoard canonical(PackedBoard board)
+{
+    int s = 0;
+    return canonical(board, s);
+}
+
+}
@@ -0,0 +1,42 @@
+/* Symmetry
+ *
+ * The 8 rotations and reflections of a square board. A move on a
+ * board does the same as the matching move on any of its images, and
+ * the value of a board doesn't change, so the caches can keep only one
+ * of the 8 images, the canonical one, and turn the answers back.
+ *
+ * Symmetry s transposes the board if bit 0 of s is set, then mirrors
+ * it left to right if bit 1 is set and top to bottom if bit 2 is set.
+ * Symmetry 0 leaves the board as it is.
+*/
+
+#ifndef SYMMETRY_HH
+#define SYMMETRY_HH
+
+#include "packedboard.hh"
+
+const int SYMMETRY_COUNT = 8;
+
+namespace symmetry
+{
+    // Cell (to_y, to_x) where symmetry s moves the cell (y, x) of a
+    // board of the given size.
+    void map_cell(int size, int s, int y, int x, int& to_y, int& to_x);
+
+    // Direction on the image that does the same as dir on the board.
+    Direction map_direction(Direction dir, int s);
+
+    // Direction on the board that does the same as dir on the image.
+    Direction unmap_direction(Direction dir, int s);
+
+    // Image of the board in symmetry s, and the board of an image.
+    PackedBoard apply(PackedBoard board, int s);
+    PackedBoard undo(PackedBoard board, int s);
+
+    // Returns the smallest image of the board, which is the same for
+    // all the 8 images, and puts the symmetry that gives it in s.
+    PackedBoard canonical(PackedBoard board, int& s);
+    PackedBoard canonical(PackedBoard board);
+}
+
+#endif // SYMMETRY_HH
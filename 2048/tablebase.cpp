@@ -0,0 +1,156 @@
+#include "tablebase.hh"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Tablebase::Tablebase():
+    data_(nullptr), size_(0)
+{
+}
+
+Tablebase::~Tablebase()
+{
+    if( data_ != nullptr )
+    {
+        munmap(data_, size_);
+    }
+}
+
+bool Tablebase::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if( fd < 0 )
+    {
+        return false;
+    }
+    struct stat status;
+    if( fstat(fd, &status) != 0 or
+        std::size_t(status.st_size) < sizeof(TablebaseHeader) )
+    {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if( data == MAP_FAILED )
+    {
+        return false;
+    }
+
+    // Check that the file is what it should be
+    const TablebaseHeader* header = static_cast<TablebaseHeader*>(data);
+    if( std::memcmp(header->magic, TABLEBASE_MAGIC, 8) != 0 or
+        header->version != TABLEBASE_VERSION or
+        header->states != tablebase_states(header->size,
+                                           header->target_exponent) or
+        header->states == 0 or
+        std::size_t(status.st_size) < sizeof(TablebaseHeader)
+                                      + header->states * 2 )
+    {
+        munmap(data, status.st_size);
+        return false;
+    }
+
+    if( data_ != nullptr )
+    {
+        munmap(data_, size_);
+    }
+    data_ = data;
+    size_ = status.st_size;
+    return true;
+}
+
+bool Tablebase::is_open() const
+{
+    return data_ != nullptr;
+}
+
+const TablebaseHeader& Tablebase::header() const
+{
+    return *static_cast<const TablebaseHeader*>(data_);
+}
+
+bool Tablebase::lookup(const CompactBoard& board,
+                       TablebaseAnswer& answer) const
+{
+    if( data_ == nullptr or board.size() != int(header().size) )
+    {
+        return false;
+    }
+    std::uint64_t base = header().target_exponent;
+    std::uint64_t index = 0;
+    std::uint64_t digit = 1;
+    for( int y = 0; y < board.size(); ++y )
+    {
+        for( int x = 0; x < board.size(); ++x )
+        {
+            std::uint64_t exponent = board.get_exponent(y, x);
+            if( exponent >= base )
+            {
+                return false;
+            }
+            index += exponent * digit;
+            digit *= base;
+        }
+    }
+    answer = this->answer(index);
+    return true;
+}
+
+bool Tablebase::lookup(PackedBoard board, TablebaseAnswer& answer) const
+{
+    if( data_ == nullptr or header().size != 4 )
+    {
+        return false;
+    }
+    std::uint64_t base = header().target_exponent;
+    std::uint64_t index = 0;
+    std::uint64_t digit = 1;
+    for( int i = 0; i < 16; ++i )
+    {
+        std::uint64_t exponent = (board >> (4 * i)) & 0xF;
+        if( exponent >= base )
+        {
+            return false;
+        }
+        index += exponent * digit;
+        digit *= base;
+    }
+    answer = this->answer(index);
+    return true;
+}
+
+TablebaseAnswer Tablebase::answer(std::uint64_t index) const
+{
+    const std::uint16_t* entries = reinterpret_cast<const std::uint16_t*>(
+                static_cast<const char*>(data_) + sizeof(TablebaseHeader));
+    std::uint16_t entry = entries[index];
+
+    TablebaseAnswer result;
+    result.win_probability = double(entry & TABLEBASE_PROBABILITY_SCALE)
+                             / TABLEBASE_PROBABILITY_SCALE;
+    result.best = Direction(entry >> TABLEBASE_MOVE_SHIFT);
+    return result;
+}
+
+std::uint64_t tablebase_states(int size, int target_exponent)
+{
+    // Counted with a limit, so that a large board can't overflow
+    if( size < 1 or target_exponent < 2 or
+        target_exponent > MAX_TABLEBASE_TARGET )
+    {
+        return 0;
+    }
+    std::uint64_t states = 1;
+    for( int i = 0; i < size * size; ++i )
+    {
+        states *= target_exponent;
+        if( states > MAX_TABLEBASE_STATES )
+        {
+            return 0;
+        }
+    }
+    return states;
+}
@@ -0,0 +1,107 @@
+/* Tablebase
+ *
+ * Exact answers for small games, written by TablebaseGenerator. For
+ * every board of the given size whose tiles are all below the target,
+ * the tablebase has the probability of reaching the target with the
+ * best play, and the move that gives it.
+ *
+ * The file is memory-mapped, and the entry of a board is found by its
+ * position: the exponents of the cells, row by row, are the digits of
+ * the position in base target exponent, the first cell being the
+ * lowest digit. The file starts with a header:
+ *
+ *      magic "2048TBAS" (8), version (4), size (4),
+ *      target exponent (4), reserved (4), states (8), reserved (32)
+ *
+ * and is followed by one entry of 2 bytes per board: the best move in
+ * the highest 2 bits (see Direction) and the win probability times
+ * TABLEBASE_PROBABILITY_SCALE in the others. All the numbers are in
+ * the byte order of the machine.
+ *
+ * The rules are the ones of the GUI and PackedGame: a move that
+ * doesn't change the board isn't played, a merge that makes the target
+ * wins, and otherwise a 2 appears in a random empty cell. A board no
+ * move changes is lost, its probability is 0 and its move UP.
+*/
+
+#ifndef TABLEBASE_HH
+#define TABLEBASE_HH
+
+#include "compactboard.hh"
+#include "packedboard.hh"
+#include <string>
+
+struct TablebaseHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t size;
+    std::uint32_t target_exponent;
+    std::uint32_t reserved;
+    std::uint64_t states;
+    char reserved_end[32];
+};
+
+static_assert(sizeof(TablebaseHeader) == 64, "Unexpected header size");
+
+const char TABLEBASE_MAGIC[8] = {'2', '0', '4', '8', 'T', 'B', 'A', 'S'};
+// Version 2 follows the rules of the GUI on moves that change nothing
+const std::uint32_t TABLEBASE_VERSION = 2;
+
+// The win probability is stored in the lowest 14 bits of an entry
+const int TABLEBASE_MOVE_SHIFT = 14;
+const std::uint16_t TABLEBASE_PROBABILITY_SCALE =
+        (1 << TABLEBASE_MOVE_SHIFT) - 1;
+
+// Largest tablebase that can be made, 512 MB on the disk
+const std::uint64_t MAX_TABLEBASE_STATES = std::uint64_t(1) << 28;
+
+// Largest target of a tablebase
+const int MAX_TABLEBASE_TARGET = 20;
+
+// Answer of the tablebase for one board
+struct TablebaseAnswer
+{
+    double win_probability;
+    Direction best;
+};
+
+class Tablebase
+{
+public:
+    Tablebase();
+
+    // Destructor, unmaps the file.
+    ~Tablebase();
+
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    // Maps the given tablebase for reading. Returns false, if the file
+    // doesn't exist or isn't a tablebase.
+    bool open(const std::string& path);
+
+    // Returns true, if a tablebase is open.
+    bool is_open() const;
+
+    // Header of the open tablebase.
+    const TablebaseHeader& header() const;
+
+    // Finds the answer for the given board. Returns false, if the board
+    // is of another size or has a tile at or above the target.
+    bool lookup(const CompactBoard& board, TablebaseAnswer& answer) const;
+    bool lookup(PackedBoard board, TablebaseAnswer& answer) const;
+
+private:
+    void* data_;
+    std::size_t size_;
+
+    // Answer in the given position
+    TablebaseAnswer answer(std::uint64_t index) const;
+};
+
+// Number of boards in a tablebase of the given size and target, 0 if
+// there can't be such a tablebase.
+std::uint64_t tablebase_states(int size, int target_exponent);
+
+#endif // TABLEBASE_HH
@@ -0,0 +1,351 @@
+#include "tablebasegenerator.hh"
+#include "symmetry.hh"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Number of boards a thread takes at a time
+const std::size_t CHUNK_SIZE = 4096;
+
+// How often the progress is printed
+const int PROGRESS_INTERVAL_MS = 1000;
+
+// Exponent of NEW_VALUE
+const int NEW_EXPONENT = 1;
+
+// Even with the target 2^2 a tablebase can't have more cells than
+// this, see MAX_TABLEBASE_STATES
+const int MAX_CELLS = 28;
+
+// Adds to layer the positions of the boards whose cells from the given
+// one on sum to remaining, the earlier cells giving index
+void collect(int cell, int cells, int remaining, std::uint32_t index,
+             int base, const std::vector<std::uint32_t>& digits,
+             std::vector<std::uint32_t>& layer)
+{
+    if( cell == cells )
+    {
+        if( remaining == 0 )
+        {
+            layer.push_back(index);
+        }
+        return;
+    }
+
+    // The cells after this one can hold at most this much
+    int room = (cells - cell - 1) * (1 << (base - 1));
+    for( int exponent = 0; exponent < base; ++exponent )
+    {
+        int value = exponent == 0 ? 0 : 1 << exponent;
+        if( value > remaining )
+        {
+            break;
+        }
+        if( remaining - value > room )
+        {
+            continue;
+        }
+        collect(cell + 1, cells, remaining - value,
+                index + exponent * digits[cell], base, digits, layer);
+    }
+}
+
+}
+
+TablebaseGenerator::TablebaseGenerator(int size, int target_exponent,
+                                       int threads):
+    size_(size), target_exponent_(target_exponent), threads_(threads)
+{
+    if( threads_ <= 0 )
+    {
+        threads_ = std::thread::hardware_concurrency();
+    }
+    if( threads_ <= 0 )
+    {
+        threads_ = 1;
+    }
+}
+
+bool TablebaseGenerator::run(const std::string& path,
+                             std::ostream& progress)
+{
+    std::uint64_t states = tablebase_states(size_, target_exponent_);
+    if( states == 0 )
+    {
+        std::cerr << "A " << size_ << "x" << size_ << " tablebase for 2^"
+                  << target_exponent_ << " would be too large, at most "
+                  << MAX_TABLEBASE_STATES << " boards are allowed"
+                  << std::endl;
+        return false;
+    }
+
+    int cells = size_ * size_;
+    std::vector<std::uint32_t> digits(cells);
+    for( int i = 0; i < cells; ++i )
+    {
+        digits[i] = i == 0 ? 1 : digits[i - 1] * target_exponent_;
+    }
+    values_.assign(states, 0.0f);
+    moves_.assign(states, 0);
+
+    // Where every symmetry moves every cell
+    image_cells_.resize(SYMMETRY_COUNT * cells);
+    for( int s = 0; s < SYMMETRY_COUNT; ++s )
+    {
+        for( int i = 0; i < cells; ++i )
+        {
+            int y = 0;
+            int x = 0;
+            symmetry::map_cell(size_, s, i / size_, i % size_, y, x);
+            image_cells_[s * cells + i] = y * size_ + x;
+        }
+    }
+
+    // Solve the layers from the largest sum down
+    std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point printed = begin;
+    std::uint64_t solved = 0;
+    int max_sum = cells * (1 << (target_exponent_ - 1));
+    std::vector<std::uint32_t> layer;
+    for( int sum = max_sum; sum >= 0; sum -= 2 )
+    {
+        layer.clear();
+        collect(0, cells, sum, 0, target_exponent_, digits, layer);
+
+        // Only the canonical boards are solved, the other images of a
+        // board take its answer afterwards. The images have the same
+        // sum, so they are all in this layer.
+        for_each_board(layer, [&](std::uint32_t index, CompactBoard& board)
+        {
+            int s = 0;
+            if( canonical(index, digits, s) == index )
+            {
+                solve(index, board, digits);
+            }
+        });
+        for_each_board(layer, [&](std::uint32_t index, CompactBoard&)
+        {
+            int s = 0;
+            std::uint32_t image = canonical(index, digits, s);
+            if( image != index )
+            {
+                values_[index] = values_[image];
+                moves_[index] = symmetry::unmap_direction(
+                            Direction(moves_[image]), s);
+            }
+        });
+
+        solved += layer.size();
+        std::chrono::steady_clock::time_point now =
+                std::chrono::steady_clock::now();
+        if( now - printed >= std::chrono::milliseconds(PROGRESS_INTERVAL_MS) )
+        {
+            printed = now;
+            progress << "\r" << solved << " / " << states << " boards"
+                     << std::flush;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - begin).count();
+    progress << "\rSolved " << solved << " boards in " << seconds
+             << " s on " << threads_ << " threads" << std::endl;
+    return write(path);
+}
+
+void TablebaseGenerator::for_each_board(
+        const std::vector<std::uint32_t>& layer,
+        const std::function<void(std::uint32_t, CompactBoard&)>& function)
+{
+    // Small layers are not worth starting the threads for
+    std::atomic<std::size_t> next_chunk(0);
+    std::vector<std::thread> workers;
+    int layer_threads = layer.size() > CHUNK_SIZE ? threads_ : 1;
+    for( int t = 0; t < layer_threads; ++t )
+    {
+        workers.push_back(std::thread([&]()
+        {
+            CompactBoard board(size_);
+            while( true )
+            {
+                std::size_t first = next_chunk.fetch_add(CHUNK_SIZE);
+                if( first >= layer.size() )
+                {
+                    break;
+                }
+                std::size_t last = first + CHUNK_SIZE < layer.size() ?
+                            first + CHUNK_SIZE : layer.size();
+                for( std::size_t i = first; i < last; ++i )
+                {
+                    function(layer[i], board);
+                }
+            }
+        }));
+    }
+    for( std::thread& worker : workers )
+    {
+        worker.join();
+    }
+}
+
+std::uint32_t TablebaseGenerator::canonical(
+        std::uint32_t index, const std::vector<std::uint32_t>& digits,
+        int& s) const
+{
+    int cells = size_ * size_;
+    std::uint8_t exponents[MAX_CELLS];
+    for( int i = 0; i < cells; ++i )
+    {
+        exponents[i] = (index / digits[i]) % target_exponent_;
+    }
+
+    // The smallest position of the images
+    std::uint32_t best = index;
+    s = 0;
+    for( int symmetry = 1; symmetry < SYMMETRY_COUNT; ++symmetry )
+    {
+        const int* image_cells = &image_cells_[symmetry * cells];
+        std::uint32_t image = 0;
+        for( int i = 0; i < cells; ++i )
+        {
+            image += exponents[i] * digits[image_cells[i]];
+        }
+        if( image < best )
+        {
+            best = image;
+            s = symmetry;
+        }
+    }
+    return best;
+}
+
+void TablebaseGenerator::solve(std::uint32_t index, CompactBoard& board,
+                               const std::vector<std::uint32_t>& digits)
+{
+    int cells = size_ * size_;
+    std::uint8_t exponents[MAX_CELLS];
+    for( int i = 0; i < cells; ++i )
+    {
+        exponents[i] = (index / digits[i]) % target_exponent_;
+    }
+
+    // A board no move changes is lost
+    float best_value = 0.0f;
+    int best_move = 0;
+    bool any_moved = false;
+    for( int dir = 0; dir < DIRECTION_COUNT; ++dir )
+    {
+        for( int i = 0; i < cells; ++i )
+        {
+            board.set_exponent(i / size_, i % size_, exponents[i]);
+        }
+        CompactMove move = board.move(Direction(dir));
+
+        // A move that changes nothing isn't played
+        if( not move.moved )
+        {
+            continue;
+        }
+
+        // A merge that reaches the target wins, otherwise a 2 comes to
+        // any of the empty cells. A move that changed the board always
+        // leaves one.
+        float value = 0.0f;
+        if( move.max_merged_exponent >= target_exponent_ )
+        {
+            value = 1.0f;
+        }
+        else
+        {
+            std::uint32_t after = 0;
+            for( int i = 0; i < cells; ++i )
+            {
+                after += board.get_exponent(i / size_, i % size_)
+                         * digits[i];
+            }
+            int empty = 0;
+            double sum = 0.0;
+            for( int i = 0; i < cells; ++i )
+            {
+                if( board.get_exponent(i / size_, i % size_) == 0 )
+                {
+                    sum += values_[after + NEW_EXPONENT * digits[i]];
+                    ++empty;
+                }
+            }
+            value = float(sum / empty);
+        }
+
+        if( not any_moved or value > best_value )
+        {
+            best_value = value;
+            best_move = dir;
+            any_moved = true;
+        }
+    }
+    values_[index] = best_value;
+    moves_[index] = best_move;
+}
+
+bool TablebaseGenerator::write(const std::string& path) const
+{
+    // Write to a temporary file, so that a tablebase is never half done
+    std::string temporary = path + ".tmp";
+    std::size_t size = sizeof(TablebaseHeader) + values_.size() * 2;
+    int fd = open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if( fd < 0 or ftruncate(fd, size) != 0 )
+    {
+        std::cerr << temporary << ": " << std::strerror(errno) << std::endl;
+        if( fd >= 0 )
+        {
+            close(fd);
+        }
+        return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd, 0);
+    close(fd);
+    if( data == MAP_FAILED )
+    {
+        std::cerr << temporary << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    TablebaseHeader* header = static_cast<TablebaseHeader*>(data);
+    std::memset(header, 0, sizeof(TablebaseHeader));
+    std::memcpy(header->magic, TABLEBASE_MAGIC, sizeof(header->magic));
+    header->version = TABLEBASE_VERSION;
+    header->size = size_;
+    header->target_exponent = target_exponent_;
+    header->states = values_.size();
+
+    std::uint16_t* entries = reinterpret_cast<std::uint16_t*>(
+                static_cast<char*>(data) + sizeof(TablebaseHeader));
+    for( std::size_t i = 0; i < values_.size(); ++i )
+    {
+        std::uint16_t probability = static_cast<std::uint16_t>(
+                    std::lround(values_[i] * TABLEBASE_PROBABILITY_SCALE));
+        entries[i] = (moves_[i] << TABLEBASE_MOVE_SHIFT) | probability;
+    }
+    msync(data, size, MS_SYNC);
+    munmap(data, size);
+
+    if( std::rename(temporary.c_str(), path.c_str()) != 0 )
+    {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+/* TablebaseGenerator
+ *
+ * Solves small games exactly and writes the answers to a Tablebase
+ * file.
+ *
+ * A move never changes the sum of the tiles and every new tile is a 2,
+ * so the sum grows by exactly 2 on every turn. The boards are solved
+ * backwards in layers of the same sum, starting from the largest one:
+ * the value of a board only depends on the boards of the next layer,
+ * so all the boards of a layer are independent and are split between
+ * the worker threads.
+ *
+ * The 8 images of a board (see Symmetry) have the same answer, turned
+ * the same way, so only the image with the smallest position is solved
+ * and the others copy it. The file still has every board, so that a
+ * lookup stays a single read.
+ *
+ * The values are kept as floats while solving and only rounded when
+ * the file is written, so the rounding errors don't add up over the
+ * layers. The file is written next to the given path and renamed in
+ * place when it is complete.
+*/
+
+#ifndef TABLEBASEGENERATOR_HH
+#define TABLEBASEGENERATOR_HH
+
+#include "tablebase.hh"
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class TablebaseGenerator
+{
+public:
+    // Constructor, 0 threads means one per core.
+    TablebaseGenerator(int size, int target_exponent, int threads = 0);
+
+    // Solves all the boards and writes the tablebase. Returns false,
+    // and prints the reason, if that isn't possible.
+    bool run(const std::string& path, std::ostream& progress);
+
+private:
+    int size_;
+    int target_exponent_;
+    int threads_;
+
+    // Win probability of every board and its best move
+    std::vector<float> values_;
+    std::vector<std::uint8_t> moves_;
+
+    // Cell of the image of every cell in every symmetry
+    std::vector<int> image_cells_;
+
+    // Calls the function for every board of the layer on all the
+    // threads. Every thread has its own board to work on.
+    void for_each_board(
+            const std::vector<std::uint32_t>& layer,
+            const std::function<void(std::uint32_t, CompactBoard&)>& function);
+
+    // Position of the canonical image of the board, the symmetry that
+    // gives it is put in s.
+    std::uint32_t canonical(std::uint32_t index,
+                            const std::vector<std::uint32_t>& digits,
+                            int& s) const;
+
+    // Solves one board, the next layer must be solved already.
+    void solve(std::uint32_t index, CompactBoard& board,
+               const std::vector<std::uint32_t>& digits);
+
+    // Writes the solved tablebase.
+    bool write(const std::string& path) const;
+};
+
+#endif // TABLEBASEGENERATOR_HH
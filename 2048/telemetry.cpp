@@ -0,0 +1,374 @@
+#include "telemetry.hh"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+
+const char* const PHASE_NAMES[TELEMETRY_PHASES] = {"choose", "step", "draw"};
+const char* const STATE_NAMES[] = {"playing", "won", "lost"};
+
+// Counts the merges of a slide into merges. A merge of two 2^(e-1)
+// tiles makes one 2^e tile, so going down from the largest exponent
+// the merges of every exponent follow from the tiles before and after.
+void count_merges(PackedBoard before, PackedBoard after,
+                  std::uint32_t merges[TELEMETRY_EXPONENTS])
+{
+    int tiles_before[TELEMETRY_EXPONENTS] = {};
+    int tiles_after[TELEMETRY_EXPONENTS] = {};
+    for( int i = 0; i < 16; ++i )
+    {
+        ++tiles_before[(before >> (4 * i)) & 0xF];
+        ++tiles_after[(after >> (4 * i)) & 0xF];
+    }
+    int merged_above = 0;
+    for( int e = TELEMETRY_EXPONENTS - 1; e >= 1; --e )
+    {
+        int merged = tiles_after[e] - tiles_before[e] + 2 * merged_above;
+        merges[e] += merged;
+        merged_above = merged;
+    }
+}
+
+// Label value with the characters the format reserves escaped
+std::string escape_label(const std::string& value)
+{
+    std::string result;
+    for( char c : value )
+    {
+        if( c == '\\' or c == '"' )
+        {
+            result += '\\';
+            result += c;
+        }
+        else if( c == '\n' )
+        {
+            result += "\\n";
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    return result;
+}
+
+// Field quoted for CSV
+std::string quote_csv(const std::string& value)
+{
+    std::string result = "\"";
+    for( char c : value )
+    {
+        if( c == '"' )
+        {
+            result += '"';
+        }
+        result += c;
+    }
+    return result + "\"";
+}
+
+// Renames the temporary file in place, so that a reader never sees
+// half a file
+bool finish_file(std::ofstream& out, const std::string& temporary,
+                 const std::string& path)
+{
+    out.close();
+    if( not out )
+    {
+        std::cerr << temporary << ": write failed" << std::endl;
+        return false;
+    }
+    if( std::rename(temporary.c_str(), path.c_str()) != 0 )
+    {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Totals of one source
+struct SourceTotals
+{
+    std::uint64_t games;
+    std::uint64_t won;
+    std::uint64_t moves;
+    std::uint64_t score;
+    std::uint64_t spawns;
+    std::uint64_t spawn_retries;
+    double seconds;
+    double phase_seconds[TELEMETRY_PHASES];
+    std::uint64_t merges[TELEMETRY_EXPONENTS];
+};
+
+}
+
+TelemetryRecorder::TelemetryRecorder(std::uint32_t source):
+    source_(source), in_game_(false), current_()
+{
+}
+
+void TelemetryRecorder::start_game(std::uint32_t seed)
+{
+    current_ = GameTelemetry();
+    current_.source = source_;
+    current_.seed = seed;
+    started_ = std::chrono::steady_clock::now();
+    in_game_ = true;
+}
+
+void TelemetryRecorder::record_move(PackedBoard before, PackedBoard after)
+{
+    ++current_.moves;
+    count_merges(before, after, current_.merges);
+}
+
+void TelemetryRecorder::record_phase(TelemetryPhase phase, double seconds)
+{
+    current_.phase_seconds[phase] += seconds;
+}
+
+void TelemetryRecorder::end_game(std::uint32_t score, int max_exponent,
+                                 GameState state, std::uint32_t spawns,
+                                 std::uint32_t spawn_retries)
+{
+    current_.score = score;
+    current_.max_exponent = max_exponent;
+    current_.state = state;
+    current_.spawns = spawns;
+    current_.spawn_retries = spawn_retries;
+    current_.seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - started_).count();
+    games_.push_back(current_);
+    in_game_ = false;
+}
+
+bool TelemetryRecorder::in_game() const
+{
+    return in_game_;
+}
+
+std::uint32_t TelemetryRecorder::source() const
+{
+    return source_;
+}
+
+void TelemetryRecorder::take_games(TelemetryRecorder& other)
+{
+    games_.insert(games_.end(), other.games_.begin(), other.games_.end());
+    other.games_.clear();
+}
+
+TelemetryTimer::TelemetryTimer(TelemetryRecorder* recorder,
+                               TelemetryPhase phase):
+    recorder_(recorder), phase_(phase)
+{
+    if( recorder_ != nullptr )
+    {
+        begin_ = std::chrono::steady_clock::now();
+    }
+}
+
+TelemetryTimer::~TelemetryTimer()
+{
+    if( recorder_ != nullptr )
+    {
+        recorder_->record_phase(phase_, std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - begin_).count());
+    }
+}
+
+std::uint32_t Telemetry::source(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for( std::size_t i = 0; i < sources_.size(); ++i )
+    {
+        if( sources_[i] == name )
+        {
+            return i;
+        }
+    }
+    sources_.push_back(name);
+    return sources_.size() - 1;
+}
+
+void Telemetry::flush(TelemetryRecorder& recorder)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    games_.insert(games_.end(), recorder.games_.begin(),
+                  recorder.games_.end());
+    recorder.games_.clear();
+}
+
+std::size_t Telemetry::games() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return games_.size();
+}
+
+bool Telemetry::write_prometheus(const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Add up the games of every source
+    std::vector<SourceTotals> totals(sources_.size(), SourceTotals());
+    for( const GameTelemetry& game : games_ )
+    {
+        if( game.source >= totals.size() )
+        {
+            continue;
+        }
+        SourceTotals& total = totals[game.source];
+        ++total.games;
+        total.won += game.state == WON ? 1 : 0;
+        total.moves += game.moves;
+        total.score += game.score;
+        total.spawns += game.spawns;
+        total.spawn_retries += game.spawn_retries;
+        total.seconds += game.seconds;
+        for( int p = 0; p < TELEMETRY_PHASES; ++p )
+        {
+            total.phase_seconds[p] += game.phase_seconds[p];
+        }
+        for( int e = 0; e < TELEMETRY_EXPONENTS; ++e )
+        {
+            total.merges[e] += game.merges[e];
+        }
+    }
+
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary.c_str());
+    if( not out )
+    {
+        std::cerr << temporary << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // One metric at a time, with a line for every source
+    struct Counter
+    {
+        const char* name;
+        const char* help;
+        std::uint64_t SourceTotals::* field;
+    };
+    const Counter counters[] = {
+        {"numbers_games_total", "Games played.", &SourceTotals::games},
+        {"numbers_games_won_total", "Games that reached the target.",
+         &SourceTotals::won},
+        {"numbers_moves_total", "Moves made.", &SourceTotals::moves},
+        {"numbers_score_total", "Points scored.", &SourceTotals::score},
+        {"numbers_spawns_total", "New tiles added.", &SourceTotals::spawns},
+        {"numbers_spawn_retries_total",
+         "Cells drawn for a new tile that were not empty.",
+         &SourceTotals::spawn_retries}
+    };
+    for( const Counter& counter : counters )
+    {
+        out << "# HELP " << counter.name << " " << counter.help << "\n"
+            << "# TYPE " << counter.name << " counter\n";
+        for( std::size_t s = 0; s < sources_.size(); ++s )
+        {
+            out << counter.name << "{source=\"" << escape_label(sources_[s])
+                << "\"} " << totals[s].*counter.field << "\n";
+        }
+    }
+
+    out << "# HELP numbers_merges_total Merges by the exponent of the"
+           " tile they made.\n"
+        << "# TYPE numbers_merges_total counter\n";
+    for( std::size_t s = 0; s < sources_.size(); ++s )
+    {
+        for( int e = 1; e < TELEMETRY_EXPONENTS; ++e )
+        {
+            out << "numbers_merges_total{source=\""
+                << escape_label(sources_[s]) << "\",exponent=\"" << e
+                << "\"} " << totals[s].merges[e] << "\n";
+        }
+    }
+
+    out << "# HELP numbers_phase_seconds_total Time spent in every part"
+           " of a turn.\n"
+        << "# TYPE numbers_phase_seconds_total counter\n";
+    for( std::size_t s = 0; s < sources_.size(); ++s )
+    {
+        for( int p = 0; p < TELEMETRY_PHASES; ++p )
+        {
+            out << "numbers_phase_seconds_total{source=\""
+                << escape_label(sources_[s]) << "\",phase=\""
+                << PHASE_NAMES[p] << "\"} " << totals[s].phase_seconds[p]
+                << "\n";
+        }
+    }
+
+    out << "# HELP numbers_game_seconds_total Wall clock time of the"
+           " games.\n"
+        << "# TYPE numbers_game_seconds_total counter\n";
+    for( std::size_t s = 0; s < sources_.size(); ++s )
+    {
+        out << "numbers_game_seconds_total{source=\""
+            << escape_label(sources_[s]) << "\"} " << totals[s].seconds
+            << "\n";
+    }
+
+    out << "# HELP numbers_moves_per_second Moves per second of game"
+           " time.\n"
+        << "# TYPE numbers_moves_per_second gauge\n";
+    for( std::size_t s = 0; s < sources_.size(); ++s )
+    {
+        out << "numbers_moves_per_second{source=\""
+            << escape_label(sources_[s]) << "\"} "
+            << (totals[s].seconds > 0.0 ?
+                    totals[s].moves / totals[s].seconds : 0.0)
+            << "\n";
+    }
+    return finish_file(out, temporary, path);
+}
+
+bool Telemetry::write_csv(const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary.c_str());
+    if( not out )
+    {
+        std::cerr << temporary << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    out << "source,seed,state,score,moves,max_tile,spawns,spawn_retries,"
+           "seconds,moves_per_second";
+    for( int p = 0; p < TELEMETRY_PHASES; ++p )
+    {
+        out << "," << PHASE_NAMES[p] << "_seconds";
+    }
+    for( int e = 1; e < TELEMETRY_EXPONENTS; ++e )
+    {
+        out << ",merges_" << (1 << e);
+    }
+    out << "\n";
+
+    for( const GameTelemetry& game : games_ )
+    {
+        out << quote_csv(game.source < sources_.size() ?
+                             sources_[game.source] : "")
+            << "," << game.seed << "," << STATE_NAMES[game.state]
+            << "," << game.score << "," << game.moves << ","
+            << (game.max_exponent == 0 ? 0 : 1 << game.max_exponent)
+            << "," << game.spawns << "," << game.spawn_retries << ","
+            << game.seconds << ","
+            << (game.seconds > 0.0 ? game.moves / game.seconds : 0.0);
+        for( int p = 0; p < TELEMETRY_PHASES; ++p )
+        {
+            out << "," << game.phase_seconds[p];
+        }
+        for( int e = 1; e < TELEMETRY_EXPONENTS; ++e )
+        {
+            out << "," << game.merges[e];
+        }
+        out << "\n";
+    }
+    return finish_file(out, temporary, path);
+}
@@ -0,0 +1,141 @@
+/* Telemetry
+ *
+ * Counters of the games played by the batch tools and by the GUI,
+ * written as a Prometheus text file and as a CSV file with a line per
+ * game.
+ *
+ * Every thread counts with its own TelemetryRecorder, so counting a
+ * move only adds to plain numbers of that thread. The finished games
+ * are handed over to the shared Telemetry with flush, which takes a
+ * lock, so a thread should flush every few games and not after every
+ * move.
+ *
+ * The games come from sources, e.g. the strategies of a tournament,
+ * and the Prometheus metrics have a label for the source:
+ *
+ *      numbers_games_total{source="greedy"} 1000
+ *      numbers_merges_total{source="greedy",exponent="3"} 48213
+*/
+
+#ifndef TELEMETRY_HH
+#define TELEMETRY_HH
+
+#include "packedgame.hh"
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The parts of a turn that are timed
+enum TelemetryPhase { CHOOSE_PHASE, STEP_PHASE, DRAW_PHASE };
+const int TELEMETRY_PHASES = 3;
+
+// Merges are counted for the exponents a packed board can hold
+const int TELEMETRY_EXPONENTS = MAX_PACKED_EXPONENT + 1;
+
+// Counters of one game
+struct GameTelemetry
+{
+    std::uint32_t source;
+    std::uint32_t seed;
+    std::uint32_t score;
+    std::uint32_t moves;
+    std::uint32_t spawns;
+    std::uint32_t spawn_retries;
+    std::uint8_t max_exponent;
+    std::uint8_t state;
+
+    // Wall clock time from the start to the end of the game, and the
+    // time spent in every phase
+    double seconds;
+    double phase_seconds[TELEMETRY_PHASES];
+
+    // Element e counts the merges that made a tile of 2^e
+    std::uint32_t merges[TELEMETRY_EXPONENTS];
+};
+
+class TelemetryRecorder
+{
+public:
+    // Constructor, the games are counted for the given source, see
+    // Telemetry::source.
+    explicit TelemetryRecorder(std::uint32_t source = 0);
+
+    // Starts counting a new game.
+    void start_game(std::uint32_t seed);
+
+    // Counts a move, given the board before and after the slide.
+    void record_move(PackedBoard before, PackedBoard after);
+
+    // Adds time to a phase of the current game.
+    void record_phase(TelemetryPhase phase, double seconds);
+
+    // Ends the current game. The counters of the generator come from
+    // SpawnRng::spawns and SpawnRng::spawn_retries.
+    void end_game(std::uint32_t score, int max_exponent, GameState state,
+                  std::uint32_t spawns, std::uint32_t spawn_retries);
+
+    // Returns true, if a game has been started and not ended.
+    bool in_game() const;
+
+    // Number of the source the games are counted for.
+    std::uint32_t source() const;
+
+    // Takes the ended games of another recorder, e.g. of one that
+    // counted a game played at the same time as others.
+    void take_games(TelemetryRecorder& other);
+
+private:
+    friend class Telemetry;
+
+    std::uint32_t source_;
+    bool in_game_;
+    GameTelemetry current_;
+    std::chrono::steady_clock::time_point started_;
+
+    // Ended games that haven't been flushed
+    std::vector<GameTelemetry> games_;
+};
+
+// Measures the time from its construction to its destruction and adds
+// it to a phase of the recorder, if there is one
+class TelemetryTimer
+{
+public:
+    TelemetryTimer(TelemetryRecorder* recorder, TelemetryPhase phase);
+    ~TelemetryTimer();
+
+private:
+    TelemetryRecorder* recorder_;
+    TelemetryPhase phase_;
+    std::chrono::steady_clock::time_point begin_;
+};
+
+class Telemetry
+{
+public:
+    // Returns the number of the source with the given name, adding it
+    // if it is new.
+    std::uint32_t source(const std::string& name);
+
+    // Takes the ended games of the recorder.
+    void flush(TelemetryRecorder& recorder);
+
+    // Number of games taken.
+    std::size_t games() const;
+
+    // Writes the totals of every source in the Prometheus text format.
+    // Returns false, and prints the reason, if the file can't be
+    // written.
+    bool write_prometheus(const std::string& path) const;
+
+    // Writes a line of counters per game.
+    bool write_csv(const std::string& path) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::string> sources_;
+    std::vector<GameTelemetry> games_;
+};
+
+#endif // TELEMETRY_HH
@@ -0,0 +1,302 @@
+#include "terminalview.hh"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+namespace
+{
+
+const char ESCAPE = '\x1b';
+const char CTRL_C = '\x03';
+
+// Control sequences of the terminal
+const char ALTERNATE_SCREEN_ON[] = "\x1b[?1049h";
+const char ALTERNATE_SCREEN_OFF[] = "\x1b[?1049l";
+const char HIDE_CURSOR[] = "\x1b[?25l";
+const char SHOW_CURSOR[] = "\x1b[?25h";
+const char CLEAR_SCREEN[] = "\x1b[H\x1b[2J";
+const char CLEAR_LINE_END[] = "\x1b[K";
+
+// Bytes read at a time
+const std::size_t READ_SIZE = 64;
+
+// Line of the status, below the board
+int status_line(int size)
+{
+    return 2 * size + 2;
+}
+
+// Final byte of a control sequence, after "ESC ["
+bool is_final_byte(char c)
+{
+    return c >= 0x40 and c <= 0x7E;
+}
+
+// Key of the last letter of an arrow sequence, "ESC [ A" or "ESC O A"
+bool arrow_key(char c, TerminalKey& key)
+{
+    switch( c )
+    {
+    case 'A': key = TERMINAL_UP; return true;
+    case 'B': key = TERMINAL_DOWN; return true;
+    case 'C': key = TERMINAL_RIGHT; return true;
+    case 'D': key = TERMINAL_LEFT; return true;
+    default: return false;
+    }
+}
+
+// Key of a plain character
+bool character_key(char c, TerminalKey& key)
+{
+    switch( c )
+    {
+    case 'w': case 'W': key = TERMINAL_UP; return true;
+    case 'd': case 'D': key = TERMINAL_RIGHT; return true;
+    case 's': case 'S': key = TERMINAL_DOWN; return true;
+    case 'a': case 'A': key = TERMINAL_LEFT; return true;
+    case 'n': case 'N': key = TERMINAL_NEXT_GAME; return true;
+    case 'q': case 'Q': case CTRL_C: key = TERMINAL_QUIT; return true;
+    default: return false;
+    }
+}
+
+}
+
+TerminalView::TerminalView(GameBoard& board):
+    board_(board), open_(false), saved_(),
+    shown_(board.size() * board.size(), -1), frames_(0), bytes_(0)
+{
+}
+
+TerminalView::~TerminalView()
+{
+    close();
+}
+
+bool TerminalView::open()
+{
+    if( not isatty(STDIN_FILENO) or not isatty(STDOUT_FILENO) )
+    {
+        std::cerr << "The game needs a terminal" << std::endl;
+        return false;
+    }
+    if( tcgetattr(STDIN_FILENO, &saved_) != 0 )
+    {
+        std::cerr << "tcgetattr: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Every key at once and without echo, Ctrl-C and Ctrl-S as keys.
+    // The output still turns "\n" into "\r\n", which GameBoard::print
+    // relies on.
+    termios raw = saved_;
+    raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+    raw.c_iflag &= ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if( tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0 )
+    {
+        std::cerr << "tcsetattr: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    open_ = true;
+    write_frame(std::string(ALTERNATE_SCREEN_ON) + HIDE_CURSOR);
+    return true;
+}
+
+void TerminalView::close()
+{
+    if( not open_ )
+    {
+        return;
+    }
+    write_frame(std::string(SHOW_CURSOR) + ALTERNATE_SCREEN_OFF);
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_);
+    open_ = false;
+}
+
+void TerminalView::draw_all(const std::string& status)
+{
+    std::ostringstream frame;
+    frame << CLEAR_SCREEN;
+    board_.print(frame);
+    shown_status_.clear();
+    add_status(frame, status);
+    for( int y = 0; y < board_.size(); ++y )
+    {
+        for( int x = 0; x < board_.size(); ++x )
+        {
+            shown_.at(y * board_.size() + x) =
+                    board_.get_item(std::make_pair(y, x))->get_exponent();
+        }
+    }
+    write_frame(frame.str());
+}
+
+void TerminalView::draw_changes(const std::string& status)
+{
+    std::ostringstream frame;
+    for( int y = 0; y < board_.size(); ++y )
+    {
+        // The cursor is already after the cell on the left, if that
+        // one was printed
+        bool cursor_here = false;
+        for( int x = 0; x < board_.size(); ++x )
+        {
+            NumberTile* tile = board_.get_item(std::make_pair(y, x));
+            int& shown = shown_.at(y * board_.size() + x);
+            if( tile->get_exponent() == shown )
+            {
+                cursor_here = false;
+                continue;
+            }
+            if( not cursor_here )
+            {
+                move_cursor(frame, 2 * y + 2, PRINT_WIDTH * x + 1);
+            }
+            tile->print(PRINT_WIDTH, frame);
+            shown = tile->get_exponent();
+            cursor_here = true;
+        }
+    }
+    if( status != shown_status_ )
+    {
+        add_status(frame, status);
+    }
+    std::string text = frame.str();
+    if( not text.empty() )
+    {
+        write_frame(text);
+    }
+}
+
+bool TerminalView::read_keys(std::vector<TerminalKey>& keys)
+{
+    keys.clear();
+    while( keys.empty() )
+    {
+        char buffer[READ_SIZE];
+        ssize_t count = read(STDIN_FILENO, buffer, sizeof(buffer));
+        if( count < 0 and errno == EINTR )
+        {
+            continue;
+        }
+        if( count <= 0 )
+        {
+            return false;
+        }
+        pending_.append(buffer, count);
+
+        // Take the complete keys, and leave an unfinished escape
+        // sequence for the next read
+        std::size_t i = 0;
+        while( i < pending_.size() )
+        {
+            TerminalKey key;
+            if( pending_[i] != ESCAPE )
+            {
+                if( character_key(pending_[i], key) )
+                {
+                    keys.push_back(key);
+                }
+                ++i;
+                continue;
+            }
+            if( i + 1 == pending_.size() )
+            {
+                break;
+            }
+            char kind = pending_[i + 1];
+            if( (kind == 'O' or kind == '[') and i + 2 == pending_.size() )
+            {
+                break;
+            }
+            if( kind == 'O' )
+            {
+                if( arrow_key(pending_[i + 2], key) )
+                {
+                    keys.push_back(key);
+                }
+                i += 3;
+            }
+            else if( kind == '[' )
+            {
+                // Skip the parameters of other sequences, e.g. F5
+                std::size_t end = i + 2;
+                while( end < pending_.size() and
+                       not is_final_byte(pending_[end]) )
+                {
+                    ++end;
+                }
+                if( end == pending_.size() )
+                {
+                    break;
+                }
+                if( end == i + 2 and arrow_key(pending_[end], key) )
+                {
+                    keys.push_back(key);
+                }
+                i = end + 1;
+            }
+            else
+            {
+                // Alt and a key, the key counts
+                ++i;
+            }
+        }
+        pending_.erase(0, i);
+    }
+    return true;
+}
+
+std::uint64_t TerminalView::frames() const
+{
+    return frames_;
+}
+
+std::uint64_t TerminalView::bytes() const
+{
+    return bytes_;
+}
+
+void TerminalView::move_cursor(std::ostream& frame, int line, int column)
+{
+    frame << ESCAPE << '[' << line << ';' << column << 'H';
+}
+
+void TerminalView::add_status(std::ostream& frame, const std::string& status)
+{
+    // Only the part after the common start, usually the score
+    std::size_t same = 0;
+    while( same < status.size() and same < shown_status_.size() and
+           status[same] == shown_status_[same] )
+    {
+        ++same;
+    }
+    move_cursor(frame, status_line(board_.size()), same + 1);
+    frame << status.substr(same) << CLEAR_LINE_END;
+    shown_status_ = status;
+}
+
+void TerminalView::write_frame(const std::string& frame)
+{
+    std::size_t written = 0;
+    while( written < frame.size() )
+    {
+        ssize_t count = write(STDOUT_FILENO, frame.data() + written,
+                              frame.size() - written);
+        if( count < 0 and errno == EINTR )
+        {
+            continue;
+        }
+        if( count <= 0 )
+        {
+            return;
+        }
+        written += count;
+    }
+    ++frames_;
+    bytes_ += frame.size();
+}
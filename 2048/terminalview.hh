@@ -0,0 +1,105 @@
+/* TerminalView
+ *
+ * Shows a GameBoard in a terminal and reads the keys, for playing over
+ * a slow link such as SSH.
+ *
+ * The terminal is put in raw mode, so every key arrives at once and
+ * isn't echoed, and the board is drawn on the alternate screen, which
+ * gives the old contents back when the view is closed. The first frame
+ * is the board as GameBoard::print prints it, with a status line below
+ * it. After that a frame only moves the cursor to the cells whose
+ * value changed and prints them again with NumberTile::print, and the
+ * end of the status line from where its text changed. A frame is
+ * collected in memory and sent with one write, so a move costs a few
+ * dozen bytes and a single packet.
+ *
+ * The arrow keys and WASD move, n starts the next game, and q or Ctrl-C
+ * quits. Esc doesn't quit: the escape sequence of an arrow may arrive
+ * split over several reads, and the incomplete part is kept for the
+ * next one, so a lone Esc can't be told apart from the start of one.
+*/
+
+#ifndef TERMINALVIEW_HH
+#define TERMINALVIEW_HH
+
+#include "gameboard.hh"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <termios.h>
+#include <vector>
+
+// A key read from the terminal, the moves have the values of Direction
+enum TerminalKey
+{
+    TERMINAL_UP,
+    TERMINAL_RIGHT,
+    TERMINAL_DOWN,
+    TERMINAL_LEFT,
+    TERMINAL_NEXT_GAME,
+    TERMINAL_QUIT
+};
+
+class TerminalView
+{
+public:
+    // Constructor, shows the given board. The terminal isn't touched
+    // before open().
+    explicit TerminalView(GameBoard& board);
+
+    // Destructor, closes the view.
+    ~TerminalView();
+
+    TerminalView(const TerminalView&) = delete;
+    TerminalView& operator=(const TerminalView&) = delete;
+
+    // Switches the terminal to raw mode and the alternate screen.
+    // Returns false, and prints the reason, if the input or the output
+    // isn't a terminal.
+    bool open();
+
+    // Gives the terminal back as it was.
+    void close();
+
+    // Draws the whole board and the status line, e.g. for a new game.
+    void draw_all(const std::string& status);
+
+    // Draws the cells that changed since the last frame, and the status
+    // line if it changed. Writes nothing, if nothing changed.
+    void draw_changes(const std::string& status);
+
+    // Waits for input and puts the keys that arrived in keys. Returns
+    // false, if the input ended.
+    bool read_keys(std::vector<TerminalKey>& keys);
+
+    // Number of frames and bytes written.
+    std::uint64_t frames() const;
+    std::uint64_t bytes() const;
+
+private:
+    GameBoard& board_;
+    bool open_;
+    termios saved_;
+
+    // Exponents and status line on the screen
+    std::vector<int> shown_;
+    std::string shown_status_;
+
+    // Input that ends in an incomplete escape sequence
+    std::string pending_;
+
+    std::uint64_t frames_;
+    std::uint64_t bytes_;
+
+    // Moves the cursor to the given line and column, counted from 1.
+    static void move_cursor(std::ostream& frame, int line, int column);
+
+    // Adds the status line from where it differs from the one shown,
+    // clearing the rest of the old one.
+    void add_status(std::ostream& frame, const std::string& status);
+
+    // Writes the frame in one write, or as few as the terminal takes.
+    void write_frame(const std::string& frame);
+};
+
+#endif // TERMINALVIEW_HH
@@ -0,0 +1,73 @@
+#include "tileatlas.hh"
+#include <QPainter>
+
+using namespace std;
+
+TileAtlas::TileAtlas()
+    : pixels(0)
+{
+}
+
+TileAtlas TileAtlas::build(const map<int, QString>& photos, int tilePixels)
+{
+    TileAtlas atlas;
+    atlas.pixels = tilePixels;
+
+    int count = static_cast<int>(photos.size());
+    int rows = (count + COLUMNS - 1) / COLUMNS;
+    atlas.image = QImage(COLUMNS * tilePixels, rows * tilePixels,
+                         QImage::Format_ARGB32_Premultiplied);
+    atlas.image.fill(Qt::transparent);
+
+    QPainter painter(&atlas.image);
+    int index = 0;
+    for ( auto& photo : photos ) {
+
+        // The exponent of the value is the place of the tile
+        int exponent = 0;
+        for ( int value = photo.first; value > 1; value /= 2 ) {
+            ++exponent;
+        }
+
+        QRect rect((index % COLUMNS) * tilePixels,
+                   (index / COLUMNS) * tilePixels, tilePixels, tilePixels);
+        QImage scaled = QImage(photo.second).scaled(tilePixels, tilePixels,
+                                                    Qt::KeepAspectRatio,
+                                                    Qt::SmoothTransformation);
+        painter.drawImage(rect.topLeft(), scaled);
+        atlas.rects.insert(exponent, rect);
+        ++index;
+    }
+    return atlas;
+}
+
+void TileAtlas::upload()
+{
+    atlasPixmap = QPixmap::fromImage(image);
+    image = QImage();
+}
+
+bool TileAtlas::isReady() const
+{
+    return !atlasPixmap.isNull();
+}
+
+int TileAtlas::tilePixels() const
+{
+    return pixels;
+}
+
+bool TileAtlas::contains(int exponent) const
+{
+    return isReady() && rects.contains(exponent);
+}
+
+QRect TileAtlas::sourceRect(int exponent) const
+{
+    return rects.value(exponent);
+}
+
+const QPixmap& TileAtlas::pixmap() const
+{
+    return atlasPixmap;
+}
@@ -0,0 +1,61 @@
+/* TileAtlas
+ *
+ * All the tile photos packed in one image, already scaled to the size
+ * of a tile on the screen. The photos are decoded and scaled once, and
+ * drawing a tile only copies a part of the atlas, so the first moves
+ * don't stop to decode photos.
+ *
+ * build() only uses QImage, so it can be run in a worker thread while
+ * the window is already shown. upload() turns the image into a pixmap
+ * and must be called in the GUI thread before the atlas is used.
+*/
+
+#ifndef TILEATLAS_HH
+#define TILEATLAS_HH
+
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QRect>
+#include <QString>
+#include <map>
+
+class TileAtlas
+{
+public:
+    // An empty atlas, that contains no tiles
+    TileAtlas();
+
+    // Packs the photos, given by the value of the tile, in an atlas
+    // where every tile is tilePixels x tilePixels pixels large
+    static TileAtlas build(const std::map<int, QString>& photos,
+                           int tilePixels);
+
+    // Moves the atlas to a pixmap, in the GUI thread
+    void upload();
+
+    // True, if the atlas has been built and uploaded
+    bool isReady() const;
+
+    // Size of a tile in the atlas, in pixels
+    int tilePixels() const;
+
+    // True, if the tile with the value 2^exponent is in the atlas
+    bool contains(int exponent) const;
+
+    // Part of the pixmap that has the tile with the value 2^exponent
+    QRect sourceRect(int exponent) const;
+
+    const QPixmap& pixmap() const;
+
+private:
+    // Number of tiles on a row of the atlas
+    static const int COLUMNS = 4;
+
+    QImage image;
+    QPixmap atlasPixmap;
+    QHash<int, QRect> rects;
+    int pixels;
+};
+
+#endif // TILEATLAS_HH
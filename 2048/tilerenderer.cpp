@@ -0,0 +1,143 @@
+#include "tilerenderer.hh"
+#include <QFontMetrics>
+#include <QPainter>
+
+namespace {
+
+// Colours of the tiles up to 2048, the ones beyond it go around
+// the colour wheel
+const QRgb RAMP[] = {0xcdc1b4, 0xeee4da, 0xede0c8, 0xf2b179, 0xf59563,
+                     0xf67c5f, 0xf65e3b, 0xedcf72, 0xedcc61, 0xedc850,
+                     0xedc53f, 0xedc22e};
+const int RAMP_LENGTH = sizeof(RAMP) / sizeof(RAMP[0]);
+
+// Values up to 2^19 are written out, larger ones as powers of two
+const int MAX_WRITTEN_EXPONENT = 19;
+
+// Part of the tile left around the tile and the text
+const qreal MARGIN = 0.04;
+const qreal TEXT_MARGIN = 0.12;
+
+}
+
+TileRenderer::TileRenderer()
+{
+}
+
+QPixmap TileRenderer::tile(int exponent, int size, qreal devicePixelRatio)
+{
+    quint64 key = tileKey(exponent, size, devicePixelRatio);
+    auto cached = tiles.constFind(key);
+    if ( cached != tiles.constEnd() ) {
+        return cached.value();
+    }
+
+    if ( tiles.size() >= MAX_CACHED_TILES ) {
+        clear();
+    }
+    QPixmap pix = drawTile(exponent, size, devicePixelRatio);
+    tiles.insert(key, pix);
+    return pix;
+}
+
+void TileRenderer::clear()
+{
+    tiles.clear();
+    fontSizes.clear();
+}
+
+int TileRenderer::cachedTiles() const
+{
+    return tiles.size();
+}
+
+quint64 TileRenderer::tileKey(int exponent, int size, qreal devicePixelRatio)
+{
+    // The ratio in hundredths is accurate enough for every screen
+    quint64 ratio = qRound(devicePixelRatio * 100);
+    return (quint64(exponent & 0xff) << 48) | (quint64(size & 0xffff) << 32)
+           | (ratio & 0xffffffff);
+}
+
+QPixmap TileRenderer::drawTile(int exponent, int size,
+                               qreal devicePixelRatio)
+{
+    int pixels = qMax(1, qRound(size * devicePixelRatio));
+    QPixmap pix(pixels, pixels);
+    pix.fill(Qt::transparent);
+
+    // Draw in device pixels, the ratio is set afterwards so that the
+    // pixmap is shown in the logical size
+    QPainter painter(&pix);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+
+    qreal margin = pixels * MARGIN;
+    QRectF rect(margin, margin, pixels - 2 * margin, pixels - 2 * margin);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(backgroundColor(exponent));
+    painter.drawRoundedRect(rect, pixels * 0.08, pixels * 0.08);
+
+    QString text = tileText(exponent);
+    QFont font = painter.font();
+    font.setBold(true);
+    font.setPixelSize(fontPixelSize(font, text, pixels));
+    painter.setFont(font);
+    painter.setPen(textColor(exponent));
+    painter.drawText(rect, Qt::AlignCenter, text);
+    painter.end();
+
+    pix.setDevicePixelRatio(devicePixelRatio);
+    return pix;
+}
+
+QColor TileRenderer::backgroundColor(int exponent)
+{
+    if ( exponent < RAMP_LENGTH ) {
+        return QColor(RAMP[exponent]);
+    }
+
+    // Darker and darker colours, turning around the colour wheel
+    int step = exponent - RAMP_LENGTH;
+    return QColor::fromHsv((50 + 37 * step) % 360, 160,
+                           qMax(70, 200 - 8 * step));
+}
+
+QColor TileRenderer::textColor(int exponent)
+{
+    // Dark text on the two lightest tiles, like in the photos
+    return exponent <= 2 ? QColor(0x776e65) : QColor(0xf9f6f2);
+}
+
+QString TileRenderer::tileText(int exponent)
+{
+    if ( exponent <= MAX_WRITTEN_EXPONENT ) {
+        return QString::number(1 << exponent);
+    }
+    return QString("2^%1").arg(exponent);
+}
+
+int TileRenderer::fontPixelSize(const QFont& font, const QString& text,
+                                int pixels)
+{
+    quint32 key = (quint32(text.size()) << 16) | quint32(pixels & 0xffff);
+    auto cached = fontSizes.constFind(key);
+    if ( cached != fontSizes.constEnd() ) {
+        return cached.value();
+    }
+
+    // Shrink the font until the text fits, leaving a margin around it
+    int room = qRound(pixels * (1 - 2 * TEXT_MARGIN));
+    int size = qMax(1, pixels / 2);
+    QFont sized = font;
+    while ( size > 1 ) {
+        sized.setPixelSize(size);
+        QFontMetrics metrics(sized);
+        if ( metrics.boundingRect(text).width() <= room ) {
+            break;
+        }
+        --size;
+    }
+    fontSizes.insert(key, size);
+    return size;
+}
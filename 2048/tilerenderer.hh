@@ -0,0 +1,67 @@
+/* TileRenderer
+ *
+ * Draws the tiles of the board procedurally instead of using the
+ * photos in icons.qrc: a rounded square coloured from a ramp by the
+ * exponent of the value, with the value written on it. Any value and
+ * any tile size can be drawn, and on high-DPI screens the tiles are
+ * drawn at the real pixel size.
+ *
+ * Every tile is drawn once for each (value, size, device pixel ratio)
+ * and kept in a cache, so redrawing the board only copies pixmaps. The
+ * font size that fits a text of a given length is cached too.
+*/
+
+#ifndef TILERENDERER_HH
+#define TILERENDERER_HH
+
+#include <QColor>
+#include <QFont>
+#include <QHash>
+#include <QPixmap>
+#include <QString>
+
+class TileRenderer
+{
+public:
+    TileRenderer();
+
+    // Returns the tile with the value 2^exponent, size x size logical
+    // pixels large, drawn for the given device pixel ratio
+    QPixmap tile(int exponent, int size, qreal devicePixelRatio);
+
+    // Forgets all the drawn tiles
+    void clear();
+
+    // Number of tiles in the cache
+    int cachedTiles() const;
+
+private:
+    // Drawn tiles by tileKey
+    QHash<quint64, QPixmap> tiles;
+
+    // Pixel sizes of the font by the length of the text and the size
+    // of the tile
+    QHash<quint32, int> fontSizes;
+
+    // At most this many tiles are kept, the cache is emptied when full
+    static const int MAX_CACHED_TILES = 4096;
+
+    // Packs the exponent, the size and the ratio in one key
+    static quint64 tileKey(int exponent, int size, qreal devicePixelRatio);
+
+    // Draws a tile that is not in the cache
+    QPixmap drawTile(int exponent, int size, qreal devicePixelRatio);
+
+    // Background and text colours of the tile with the given exponent
+    static QColor backgroundColor(int exponent);
+    static QColor textColor(int exponent);
+
+    // Text written on the tile
+    static QString tileText(int exponent);
+
+    // Largest bold font that fits the text of the given length in the
+    // tile, in device pixels
+    int fontPixelSize(const QFont& font, const QString& text, int pixels);
+};
+
+#endif // TILERENDERER_HH
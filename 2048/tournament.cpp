@@ -0,0 +1,197 @@
+#include "tournament.hh"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace
+{
+
+// 95% confidence
+const double Z = 1.96;
+
+// Percentiles of the score that are reported
+const int PERCENTILES[] = {10, 50, 90, 99};
+
+// Wilson score interval of the given number of successes
+void wilson_interval(std::uint64_t successes, std::uint64_t n,
+                     double& low, double& high)
+{
+    if( n == 0 )
+    {
+        low = 0.0;
+        high = 0.0;
+        return;
+    }
+    double p = double(successes) / n;
+    double denominator = 1.0 + Z * Z / n;
+    double center = (p + Z * Z / (2.0 * n)) / denominator;
+    double half = Z * std::sqrt(p * (1.0 - p) / n + Z * Z / (4.0 * n * n))
+                  / denominator;
+    low = std::max(0.0, center - half);
+    high = std::min(1.0, center + half);
+}
+
+}
+
+Tournament::Tournament(std::uint32_t first_seed, std::uint32_t games,
+                       int threads):
+    first_seed_(first_seed), games_(games), threads_(threads),
+    processes_(0), rng_mode_(LEGACY_RNG), telemetry_(nullptr)
+{
+}
+
+void Tournament::set_rng_mode(RngMode mode)
+{
+    rng_mode_ = mode;
+}
+
+void Tournament::set_telemetry(Telemetry* telemetry)
+{
+    telemetry_ = telemetry;
+}
+
+void Tournament::set_processes(int processes)
+{
+    processes_ = processes;
+}
+
+bool Tournament::add_strategy(const std::string& name)
+{
+    // With worker processes, a plugin that crashes while starting must
+    // not take this process down
+    bool known = processes_ > 0 ? ShardedRunner::check_strategy(name) :
+                                  static_cast<bool>(create_strategy(name));
+    if( not known )
+    {
+        return false;
+    }
+    Entry entry;
+    entry.strategy = name;
+    entry.seconds = 0.0;
+    entry.moves = 0;
+    entries_.push_back(entry);
+    return true;
+}
+
+bool Tournament::run(std::ostream& progress)
+{
+    bool ok = true;
+    for( Entry& entry : entries_ )
+    {
+        if( processes_ > 0 )
+        {
+            ShardedRunner runner(entry.strategy, processes_);
+            runner.set_rng_mode(rng_mode_);
+            ok = runner.run(first_seed_, games_, NO_GOAL, entry.records) and
+                 ok;
+            entry.seconds = runner.seconds();
+            entry.moves = runner.moves();
+            progress << entry.strategy << ": " << entry.records.size()
+                     << " games in " << entry.seconds << " s in "
+                     << runner.workers() << " processes" << std::endl;
+            runner.print_workers(progress);
+            continue;
+        }
+
+        BatchRunner runner(entry.strategy, threads_);
+        runner.set_rng_mode(rng_mode_);
+        runner.set_telemetry(telemetry_);
+        runner.run(first_seed_, games_, NO_GOAL, entry.records);
+        entry.seconds = runner.seconds();
+        entry.moves = runner.moves();
+        progress << entry.strategy << ": " << games_ << " games in "
+                 << entry.seconds << " s on " << runner.threads()
+                 << " threads" << std::endl;
+    }
+    return ok;
+}
+
+void Tournament::print_report(std::ostream& out) const
+{
+    for( const Entry& entry : entries_ )
+    {
+        print_entry(entry, out);
+    }
+}
+
+void Tournament::print_entry(const Entry& entry, std::ostream& out) const
+{
+    const std::vector<GameRecord>& records = entry.records;
+    std::uint64_t n = records.size();
+    out << "== " << entry.strategy << " (" << n << " games, seeds "
+        << first_seed_ << ".." << first_seed_ + games_ - 1 << ")"
+        << std::endl;
+    if( n == 0 )
+    {
+        return;
+    }
+
+    // Score
+    std::vector<std::uint32_t> scores;
+    double sum = 0.0;
+    for( const GameRecord& record : records )
+    {
+        scores.push_back(record.score);
+        sum += record.score;
+    }
+    double mean = sum / n;
+    double squares = 0.0;
+    for( std::uint32_t score : scores )
+    {
+        squares += (score - mean) * (score - mean);
+    }
+    double deviation = n > 1 ? std::sqrt(squares / (n - 1)) : 0.0;
+    std::sort(scores.begin(), scores.end());
+
+    out << std::fixed << std::setprecision(1);
+    out << "score: mean " << mean << " +- " << Z * deviation / std::sqrt(n)
+        << " (95% CI)";
+    for( int percentile : PERCENTILES )
+    {
+        out << ", p" << percentile << " "
+            << scores.at(std::min<std::uint64_t>(n - 1,
+                                                 n * percentile / 100));
+    }
+    out << std::endl;
+    out << "speed: " << std::setprecision(0)
+        << (entry.seconds > 0.0 ? entry.moves / entry.seconds : 0.0)
+        << " moves/s, " << std::setprecision(1)
+        << (entry.seconds > 0.0 ? n / entry.seconds : 0.0) << " games/s"
+        << std::endl;
+
+    // Win rate for every target, and the largest tiles
+    std::vector<std::uint64_t> largest(MAX_PACKED_EXPONENT + 1, 0);
+    for( const GameRecord& record : records )
+    {
+        ++largest.at(record.max_exponent);
+    }
+    out << "target   win rate   95% CI" << std::endl;
+    std::uint64_t reached = n;
+    for( int target = 0; target <= MAX_TARGET_EXPONENT; ++target )
+    {
+        if( target > 0 )
+        {
+            reached -= largest.at(target - 1);
+        }
+        if( target < MIN_TARGET_EXPONENT )
+        {
+            continue;
+        }
+        double low = 0.0;
+        double high = 0.0;
+        wilson_interval(reached, n, low, high);
+        out << "2^" << std::left << std::setw(6) << target << std::right
+            << std::setw(7) << 100.0 * reached / n << "%   ["
+            << 100.0 * low << ", " << 100.0 * high << "]" << std::endl;
+    }
+    out << "largest tile:";
+    for( int exponent = 0; exponent <= MAX_PACKED_EXPONENT; ++exponent )
+    {
+        if( largest.at(exponent) > 0 )
+        {
+            out << " " << (1 << exponent) << ": "
+                << 100.0 * largest.at(exponent) / n << "%";
+        }
+    }
+    out << std::endl << std::defaultfloat << std::setprecision(6);
+}
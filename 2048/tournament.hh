@@ -0,0 +1,84 @@
+/* Tournament
+ *
+ * Plays the same set of seeds with several strategies and compares
+ * them. Every game goes on until it is lost, so one run tells the win
+ * rate for every target the GUI allows (2^2 .. 2^15): a game that
+ * reached the target tile would have been won with that target. A
+ * packed board can't hold a larger tile, so larger targets aren't
+ * reported.
+ *
+ * The report has the win rates with 95% Wilson confidence intervals,
+ * the mean score with its confidence interval, score percentiles,
+ * the distribution of the largest tile and the speed in moves per
+ * second.
+ *
+ * The games can also be played in worker processes, see ShardedRunner.
+*/
+
+#ifndef TOURNAMENT_HH
+#define TOURNAMENT_HH
+
+#include "batchrunner.hh"
+#include "shardedrunner.hh"
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Target exponents reported, the range of targetSpinBox
+const int MIN_TARGET_EXPONENT = 2;
+const int MAX_TARGET_EXPONENT = MAX_PACKED_EXPONENT;
+
+class Tournament
+{
+public:
+    // Constructor, the seeds are [first_seed, first_seed + games).
+    // 0 threads means one per core.
+    Tournament(std::uint32_t first_seed, std::uint32_t games,
+               int threads = 0);
+
+    // Chooses the generator for the new tiles, see BatchRunner.
+    void set_rng_mode(RngMode mode);
+
+    // Counts every game in telemetry, see BatchRunner::set_telemetry.
+    void set_telemetry(Telemetry* telemetry);
+
+    // Plays the games in the given number of worker processes instead
+    // of threads of this one, 0 (default) plays them here. The games
+    // are not counted in telemetry then.
+    void set_processes(int processes);
+
+    // Adds a strategy to the tournament. Returns false, if there is
+    // no strategy with the given name. With worker processes the
+    // strategy is created in a forked process to check it, so
+    // set_processes() must be called first.
+    bool add_strategy(const std::string& name);
+
+    // Plays all the games, printing a line per strategy when done.
+    // Returns false, if a worker process failed.
+    bool run(std::ostream& progress);
+
+    // Prints the statistics of every strategy.
+    void print_report(std::ostream& out) const;
+
+private:
+    struct Entry
+    {
+        std::string strategy;
+        std::vector<GameRecord> records;
+        double seconds;
+        std::uint64_t moves;
+    };
+
+    std::uint32_t first_seed_;
+    std::uint32_t games_;
+    int threads_;
+    int processes_;
+    RngMode rng_mode_;
+    Telemetry* telemetry_;
+    std::vector<Entry> entries_;
+
+    // Prints the statistics of one strategy.
+    void print_entry(const Entry& entry, std::ostream& out) const;
+};
+
+#endif // TOURNAMENT_HH
@@ -0,0 +1,253 @@
+#include "transpositiontable.hh"
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <mutex>
+
+namespace
+{
+
+// Fibonacci hashing spreads the boards over the slots
+const std::uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+// The info word of an entry: the depth in the lowest 8 bits, the
+// generation of its searcher in the next 16 bits, the searcher in the
+// next 8 bits and a bit that marks the slot used
+const std::uint64_t DEPTH_MASK = 0xFF;
+const int GENERATION_SHIFT = 8;
+const std::uint64_t GENERATION_MASK = 0xFFFF;
+const int SEARCHER_SHIFT = 24;
+const std::uint64_t SEARCHER_MASK = 0xFF;
+const std::uint64_t USED_BIT = std::uint64_t(1) << 32;
+
+std::uint64_t to_bits(double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double from_bits(std::uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+const std::size_t MEGABYTE = 1024 * 1024;
+
+// Tables of shared_transposition_table by their size in megabytes
+std::mutex shared_tables_mutex;
+std::map<std::size_t, std::shared_ptr<TranspositionTable>> shared_tables;
+
+// Stripe of the counters used by the calling thread
+int counter_stripe()
+{
+    static std::atomic<int> next_stripe(0);
+    thread_local int stripe = next_stripe.fetch_add(1);
+    return stripe;
+}
+
+}
+
+TranspositionTable::TranspositionTable(std::size_t max_bytes):
+    slots_(MIN_SLOTS), shift_(64), next_searcher_(0)
+{
+    for( std::atomic<std::uint32_t>& generation : generations_ )
+    {
+        generation.store(0, std::memory_order_relaxed);
+    }
+    while( slots_ * 2 * sizeof(Entry) <= max_bytes )
+    {
+        slots_ *= 2;
+    }
+    for( std::size_t s = slots_; s > 1; s /= 2 )
+    {
+        --shift_;
+    }
+    entries_.reset(new Entry[slots_]);
+    clear();
+}
+
+std::size_t TranspositionTable::bytes() const
+{
+    return slots_ * sizeof(Entry);
+}
+
+bool TranspositionTable::probe(PackedBoard board, int depth, double& value)
+{
+    Counters& counter = counters();
+    counter.probes.fetch_add(1, std::memory_order_relaxed);
+
+    Entry& entry = slot(board);
+    std::uint64_t check = entry.check.load(std::memory_order_relaxed);
+    std::uint64_t bits = entry.value.load(std::memory_order_relaxed);
+    std::uint64_t info = entry.info.load(std::memory_order_relaxed);
+    if( (info & USED_BIT) == 0 )
+    {
+        return false;
+    }
+
+    // Another board, or a half written entry
+    if( (check ^ bits ^ info) != board )
+    {
+        counter.collisions.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if( int(info & DEPTH_MASK) != depth )
+    {
+        return false;
+    }
+    counter.hits.fetch_add(1, std::memory_order_relaxed);
+    value = from_bits(bits);
+    return true;
+}
+
+void TranspositionTable::store(PackedBoard board, int depth, double value,
+                               int searcher)
+{
+    Counters& counter = counters();
+    counter.stores.fetch_add(1, std::memory_order_relaxed);
+
+    Entry& entry = slot(board);
+    std::uint64_t generation = generations_[searcher].load(
+                std::memory_order_relaxed) & GENERATION_MASK;
+    std::uint64_t old_info = entry.info.load(std::memory_order_relaxed);
+    if( (old_info & USED_BIT) != 0 )
+    {
+        // A deeper entry of a search still in progress, of this
+        // searcher or another one, keeps its slot
+        std::uint64_t old_generation =
+                (old_info >> GENERATION_SHIFT) & GENERATION_MASK;
+        int old_searcher = (old_info >> SEARCHER_SHIFT) & SEARCHER_MASK;
+        std::uint64_t current = generations_[old_searcher].load(
+                    std::memory_order_relaxed) & GENERATION_MASK;
+        if( old_generation == current and
+            int(old_info & DEPTH_MASK) > depth )
+        {
+            counter.rejected.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::uint64_t old_board =
+                entry.check.load(std::memory_order_relaxed) ^
+                entry.value.load(std::memory_order_relaxed) ^ old_info;
+        if( old_board != board )
+        {
+            counter.replacements.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t bits = to_bits(value);
+    std::uint64_t info = USED_BIT |
+                         (std::uint64_t(searcher) << SEARCHER_SHIFT) |
+                         (generation << GENERATION_SHIFT) |
+                         (std::uint64_t(depth) & DEPTH_MASK);
+    entry.value.store(bits, std::memory_order_relaxed);
+    entry.info.store(info, std::memory_order_relaxed);
+    entry.check.store(board ^ bits ^ info, std::memory_order_relaxed);
+}
+
+int TranspositionTable::add_searcher()
+{
+    return next_searcher_.fetch_add(1, std::memory_order_relaxed)
+           % MAX_SEARCHERS;
+}
+
+void TranspositionTable::new_search(int searcher)
+{
+    generations_[searcher].fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+    for( std::size_t i = 0; i < slots_; ++i )
+    {
+        entries_[i].check.store(0, std::memory_order_relaxed);
+        entries_[i].value.store(0, std::memory_order_relaxed);
+        entries_[i].info.store(0, std::memory_order_relaxed);
+    }
+    for( Counters& counter : counters_ )
+    {
+        counter.probes.store(0, std::memory_order_relaxed);
+        counter.hits.store(0, std::memory_order_relaxed);
+        counter.collisions.store(0, std::memory_order_relaxed);
+        counter.stores.store(0, std::memory_order_relaxed);
+        counter.replacements.store(0, std::memory_order_relaxed);
+        counter.rejected.store(0, std::memory_order_relaxed);
+    }
+}
+
+TranspositionStatistics TranspositionTable::statistics() const
+{
+    TranspositionStatistics result = TranspositionStatistics();
+    for( const Counters& counter : counters_ )
+    {
+        result.probes += counter.probes.load(std::memory_order_relaxed);
+        result.hits += counter.hits.load(std::memory_order_relaxed);
+        result.collisions +=
+                counter.collisions.load(std::memory_order_relaxed);
+        result.stores += counter.stores.load(std::memory_order_relaxed);
+        result.replacements +=
+                counter.replacements.load(std::memory_order_relaxed);
+        result.rejected += counter.rejected.load(std::memory_order_relaxed);
+    }
+    for( std::size_t i = 0; i < slots_; ++i )
+    {
+        if( (entries_[i].info.load(std::memory_order_relaxed) & USED_BIT)
+            != 0 )
+        {
+            ++result.used;
+        }
+    }
+    result.slots = slots_;
+    return result;
+}
+
+void TranspositionTable::print_statistics(std::ostream& out) const
+{
+    TranspositionStatistics counts = statistics();
+    double hit_rate = counts.probes == 0 ?
+                0.0 : 100.0 * counts.hits / counts.probes;
+    double collision_rate = counts.probes == 0 ?
+                0.0 : 100.0 * counts.collisions / counts.probes;
+    out << "transposition table: " << bytes() / MEGABYTE << " MB, "
+        << counts.slots << " slots, " << std::fixed << std::setprecision(1)
+        << 100.0 * counts.used / counts.slots << "% used" << std::endl;
+    out << "  probes " << counts.probes << ", hits " << counts.hits
+        << " (" << hit_rate << "%), collisions " << counts.collisions
+        << " (" << collision_rate << "%)" << std::endl;
+    out << "  stores " << counts.stores << ", replaced "
+        << counts.replacements << ", kept deeper " << counts.rejected
+        << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+TranspositionTable::Entry& TranspositionTable::slot(PackedBoard board)
+{
+    return entries_[(board * HASH_MULTIPLIER) >> shift_];
+}
+
+TranspositionTable::Counters& TranspositionTable::counters()
+{
+    return counters_[counter_stripe() % COUNTER_STRIPES];
+}
+
+std::shared_ptr<TranspositionTable> shared_transposition_table(
+        std::size_t megabytes)
+{
+    std::lock_guard<std::mutex> lock(shared_tables_mutex);
+    std::shared_ptr<TranspositionTable>& table = shared_tables[megabytes];
+    if( not table )
+    {
+        table.reset(new TranspositionTable(megabytes * MEGABYTE));
+    }
+    return table;
+}
+
+void print_shared_transposition_tables(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(shared_tables_mutex);
+    for( const auto& table : shared_tables )
+    {
+        table.second->print_statistics(out);
+    }
+}
@@ -0,0 +1,156 @@
+/* TranspositionTable
+ *
+ * Remembers the values of the boards a search has already evaluated,
+ * shared by all the search threads of the process. The memory is
+ * allocated once when the table is made and never grows, however long
+ * the searches run.
+ *
+ * Probes and stores take no locks. An entry is three words, the value,
+ * the depth and a check word that is the board XORed with the other
+ * two. A thread that reads an entry while another one is writing it
+ * sees a check word that doesn't match, and treats the entry as
+ * missing, so a torn entry is never used.
+ *
+ * Every board has one slot. When two boards want the same slot, the
+ * one searched deeper keeps it, unless it is left over from an earlier
+ * search. Every search context, e.g. a strategy object, counts its own
+ * searches (see add_searcher), and an entry is left over only when the
+ * context that stored it has moved on to a new one, so the searches of
+ * the other threads don't age the entries of a search in progress. A
+ * value is only used for a search of the same depth.
+ *
+ * The searches key the table on the canonical board (see Symmetry), so
+ * the 8 images of a board share one entry. The images have the same
+ * value, apart from the rounding of the averages, so a search with the
+ * table plays like one without it except where two moves are that
+ * close.
+ *
+ * Used by ExpectimaxStrategy, e.g. "expectimax:3:tt64" shares a 64 MB
+ * table between all the threads of the process.
+*/
+
+#ifndef TRANSPOSITIONTABLE_HH
+#define TRANSPOSITIONTABLE_HH
+
+#include "packedboard.hh"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+
+// Largest table that can be asked for by name, in megabytes
+const std::size_t MAX_TRANSPOSITION_MEGABYTES = 1 << 16;
+
+// Counters of a table, see TranspositionTable::statistics
+struct TranspositionStatistics
+{
+    std::uint64_t probes;
+    std::uint64_t hits;
+
+    // Probes that found another board in the slot
+    std::uint64_t collisions;
+
+    std::uint64_t stores;
+
+    // Stores that wrote over another board, and stores that were
+    // dropped because the board in the slot was searched deeper
+    std::uint64_t replacements;
+    std::uint64_t rejected;
+
+    // Slots in use and all the slots
+    std::uint64_t used;
+    std::uint64_t slots;
+};
+
+class TranspositionTable
+{
+public:
+    // Constructor, the table takes at most the given number of bytes,
+    // but has at least MIN_SLOTS slots.
+    explicit TranspositionTable(std::size_t max_bytes);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Bytes taken by the slots.
+    std::size_t bytes() const;
+
+    // Looks for the value of the board searched to the given depth.
+    // Returns false, if it isn't in the table.
+    bool probe(PackedBoard board, int depth, double& value);
+
+    // Stores the value of the board searched to the given depth by
+    // the given searcher.
+    void store(PackedBoard board, int depth, double value, int searcher);
+
+    // Registers a search context and returns its number, for store and
+    // new_search. Past MAX_SEARCHERS the numbers are shared, and the
+    // contexts sharing one age each other's entries.
+    int add_searcher();
+
+    // Called when the given searcher searches a new move. Its entries
+    // of the earlier searches can then be replaced by shallower ones.
+    void new_search(int searcher);
+
+    // Empties the table and zeroes the counters.
+    void clear();
+
+    // Current counters. The number of slots in use is counted on the
+    // call, so this isn't meant for every move.
+    TranspositionStatistics statistics() const;
+
+    // Prints the counters, the hit rate and the occupancy.
+    void print_statistics(std::ostream& out) const;
+
+private:
+    struct Entry
+    {
+        std::atomic<std::uint64_t> check;
+        std::atomic<std::uint64_t> value;
+        std::atomic<std::uint64_t> info;
+    };
+
+    // Counters of the threads that share a stripe. The counters are
+    // striped so that the threads don't fight over one cache line.
+    struct Counters
+    {
+        std::atomic<std::uint64_t> probes;
+        std::atomic<std::uint64_t> hits;
+        std::atomic<std::uint64_t> collisions;
+        std::atomic<std::uint64_t> stores;
+        std::atomic<std::uint64_t> replacements;
+        std::atomic<std::uint64_t> rejected;
+        char padding[64 - 6 * sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    static const int COUNTER_STRIPES = 16;
+    static const std::size_t MIN_SLOTS = 1024;
+    static const int MAX_SEARCHERS = 256;
+
+    std::unique_ptr<Entry[]> entries_;
+    std::size_t slots_;
+    int shift_;
+    Counters counters_[COUNTER_STRIPES];
+
+    // Number of searches of every searcher, and the next free number
+    std::atomic<std::uint32_t> generations_[MAX_SEARCHERS];
+    std::atomic<int> next_searcher_;
+
+    // Slot of the given board.
+    Entry& slot(PackedBoard board);
+
+    // Counters of the calling thread.
+    Counters& counters();
+};
+
+// Returns the table of the given size shared by the whole process,
+// making it on the first call. All the strategies that ask for the
+// same size share one table, so the memory stays the same however many
+// threads search.
+std::shared_ptr<TranspositionTable> shared_transposition_table(
+        std::size_t megabytes);
+
+// Prints the statistics of every shared table.
+void print_shared_transposition_tables(std::ostream& out);
+
+#endif // TRANSPOSITIONTABLE_HH
@@ -0,0 +1,170 @@
+#include "wallgames.hh"
+#include "strategy.hh"
+#include <chrono>
+
+namespace
+{
+
+// Moves counted by a worker before they are added to the total
+const std::uint64_t MOVE_BATCH = 1024;
+
+}
+
+WallGames::WallGames(int count, const std::string& strategy):
+    count_(count), strategy_(strategy), slots_(new Slot[count]),
+    running_(false), next_seed_(0), moves_(0), games_(0)
+{
+    for( int i = 0; i < count_; ++i )
+    {
+        slots_[i].board = 0;
+        slots_[i].score = 0;
+    }
+}
+
+WallGames::~WallGames()
+{
+    stop();
+}
+
+bool WallGames::start(std::uint32_t first_seed, int moves_per_second,
+                      int threads)
+{
+    stop();
+    if( not create_strategy(strategy_) )
+    {
+        return false;
+    }
+    if( threads <= 0 )
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    if( threads <= 0 )
+    {
+        threads = 1;
+    }
+    if( threads > count_ )
+    {
+        threads = count_;
+    }
+
+    next_seed_ = first_seed;
+    moves_ = 0;
+    games_ = 0;
+    running_ = true;
+    for( int t = 0; t < threads; ++t )
+    {
+        workers_.push_back(std::thread(&WallGames::play, this, t, threads,
+                                       moves_per_second));
+    }
+    return true;
+}
+
+void WallGames::stop()
+{
+    running_ = false;
+    for( std::thread& worker : workers_ )
+    {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+int WallGames::count() const
+{
+    return count_;
+}
+
+PackedBoard WallGames::board(int index) const
+{
+    return slots_[index].board.load(std::memory_order_relaxed);
+}
+
+std::uint32_t WallGames::score(int index) const
+{
+    return slots_[index].score.load(std::memory_order_relaxed);
+}
+
+std::uint64_t WallGames::moves() const
+{
+    return moves_;
+}
+
+std::uint64_t WallGames::games() const
+{
+    return games_;
+}
+
+void WallGames::play(int first, int step, int moves_per_second)
+{
+    // Every game has its own strategy, as a strategy may keep state
+    // between the moves of a game
+    std::vector<PackedGame> games;
+    std::vector<std::unique_ptr<Strategy>> strategies;
+    std::vector<int> indices;
+    for( int i = first; i < count_; i += step )
+    {
+        std::uint32_t seed = next_seed_.fetch_add(1);
+        games.push_back(PackedGame());
+        games.back().start(seed, NO_GOAL);
+        strategies.push_back(create_strategy(strategy_));
+        strategies.back()->start_game(seed);
+        indices.push_back(i);
+    }
+
+    // Every round moves all the games of this worker once
+    std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+    std::uint64_t rounds = 0;
+    std::uint64_t moves = 0;
+    while( running_ )
+    {
+        for( std::size_t g = 0; g < games.size(); ++g )
+        {
+            PackedGame& game = games[g];
+            if( game.state() != PLAYING )
+            {
+                std::uint32_t seed = next_seed_.fetch_add(1);
+                game.start(seed, NO_GOAL);
+                strategies[g]->start_game(seed);
+                ++games_;
+            }
+            else
+            {
+                // If no move changes the board, any move loses the game
+                Direction dir = UP;
+                strategies[g]->choose(game.board(), dir);
+                game.step(legal_move(game.board(), dir));
+                ++moves;
+            }
+            Slot& slot = slots_[indices[g]];
+            slot.board.store(game.board(), std::memory_order_relaxed);
+            slot.score.store(game.score(), std::memory_order_relaxed);
+        }
+        if( moves >= MOVE_BATCH )
+        {
+            moves_ += moves;
+            moves = 0;
+        }
+
+        // Keep the pace, without catching up on the rounds missed
+        ++rounds;
+        if( moves_per_second > 0 )
+        {
+            std::chrono::steady_clock::time_point due = begin +
+                    std::chrono::microseconds(rounds * 1000000 /
+                                              moves_per_second);
+            std::chrono::steady_clock::time_point now =
+                    std::chrono::steady_clock::now();
+            if( due > now )
+            {
+                std::this_thread::sleep_until(due);
+            }
+            else
+            {
+                begin = now;
+                rounds = 0;
+            }
+        }
+    }
+    moves_ += moves;
+}
@@ -0,0 +1,80 @@
+/* WallGames
+ *
+ * Many games played at the same time by a strategy in worker threads,
+ * for watching bots on the wall view of the GUI.
+ *
+ * Every game publishes its packed board and score in atomics after
+ * each move, so the GUI reads a consistent board of every game
+ * without locking and without slowing the workers down. A game that
+ * ends is started again with the next seed.
+*/
+
+#ifndef WALLGAMES_HH
+#define WALLGAMES_HH
+
+#include "packedgame.hh"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class WallGames
+{
+public:
+    // Constructor, count games played with the given strategy.
+    WallGames(int count, const std::string& strategy);
+
+    // Destructor, stops the workers.
+    ~WallGames();
+
+    WallGames(const WallGames&) = delete;
+    WallGames& operator=(const WallGames&) = delete;
+
+    // Starts the games with the seeds first_seed, first_seed + 1, ...
+    // Every game makes moves_per_second moves per second, 0 meaning as
+    // fast as possible. 0 threads means one per core, but never more
+    // than there are games. Returns false, if the strategy doesn't
+    // exist.
+    bool start(std::uint32_t first_seed, int moves_per_second,
+               int threads = 0);
+
+    // Stops the workers, the boards stay as they are.
+    void stop();
+
+    // Number of games.
+    int count() const;
+
+    // Current board and score of a game.
+    PackedBoard board(int index) const;
+    std::uint32_t score(int index) const;
+
+    // Moves made and games finished since the start.
+    std::uint64_t moves() const;
+    std::uint64_t games() const;
+
+private:
+    // Published state of one game, on a cache line of its own so that
+    // the workers don't share lines
+    struct Slot
+    {
+        std::atomic<PackedBoard> board;
+        std::atomic<std::uint32_t> score;
+        char padding[64 - sizeof(std::atomic<PackedBoard>)
+                     - sizeof(std::atomic<std::uint32_t>)];
+    };
+
+    int count_;
+    std::string strategy_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<bool> running_;
+    std::atomic<std::uint32_t> next_seed_;
+    std::atomic<std::uint64_t> moves_;
+    std::atomic<std::uint64_t> games_;
+    std::vector<std::thread> workers_;
+
+    // Plays the games first, first + step, ... until stopped.
+    void play(int first, int step, int moves_per_second);
+};
+
+#endif // WALLGAMES_HH
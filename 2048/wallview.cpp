@@ -0,0 +1,149 @@
+#include "wallview.hh"
+#include <QCloseEvent>
+#include <QGuiApplication>
+#include <QPainter>
+#include <QScreen>
+
+using namespace std;
+
+WallView::WallView(int rows, int columns, int slotSize,
+                   const string& strategy, QWidget* parent)
+    : QGraphicsView(parent)
+    , rows(rows)
+    , columns(columns)
+    , slotSize(slotSize)
+    , games(rows * columns, strategy)
+{
+    setWindowTitle("2048");
+
+    scene = new QGraphicsScene(this);
+    scene->setSceneRect(0, 0, columns * boardStride() - GAP,
+                        rows * boardStride() - GAP);
+    setScene(scene);
+
+    // The squares never change, so they are drawn once, and the view
+    // repaints the bounding rectangle of the changed boards when there
+    // are many of them
+    setCacheMode(QGraphicsView::CacheBackground);
+    setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+    setOptimizationFlags(QGraphicsView::DontSavePainterState
+                         | QGraphicsView::DontAdjustForAntialiasing);
+
+    for ( int i = 0; i < rows * columns; ++i ) {
+        BoardItem* board = new BoardItem(SIZE, slotSize);
+        board->setPos(boardPosition(i));
+        scene->addItem(board);
+        boards.push_back(board);
+    }
+
+    // The boards are read once per display refresh
+    frameTimer = new QTimer(this);
+    frameTimer->setTimerType(Qt::PreciseTimer);
+    qreal refreshRate = QGuiApplication::primaryScreen()->refreshRate();
+    frameTimer->setInterval(qMax(1, qRound(1000.0 / refreshRate)));
+    connect(frameTimer, &QTimer::timeout, this, &WallView::renderFrame);
+}
+
+void WallView::setAtlas(const TileAtlas* atlas)
+{
+    for ( BoardItem* board : boards ) {
+        board->setAtlas(atlas);
+    }
+}
+
+void WallView::setFallback(function<QPixmap(int)> fallback)
+{
+    for ( BoardItem* board : boards ) {
+        board->setFallback(fallback);
+    }
+}
+
+void WallView::setAtlasEnabled(bool enabled)
+{
+    for ( BoardItem* board : boards ) {
+        board->setAtlasEnabled(enabled);
+    }
+}
+
+bool WallView::start(uint firstSeed, int movesPerSecond)
+{
+    if ( !games.start(firstSeed, movesPerSecond) ) {
+        return false;
+    }
+    statsClock.start();
+    frames = 0;
+    boardsRepainted = 0;
+    movesAtStats = 0;
+    frameTimer->start();
+    return true;
+}
+
+void WallView::stop()
+{
+    frameTimer->stop();
+    games.stop();
+}
+
+void WallView::drawBackground(QPainter* painter, const QRectF& rect)
+{
+    QGraphicsView::drawBackground(painter, rect);
+    for ( int i = 0; i < rows * columns; ++i ) {
+        QPointF position = boardPosition(i);
+        QRectF area(position, QSizeF(SIZE * slotSize, SIZE * slotSize));
+        if ( !area.intersects(rect) ) {
+            continue;
+        }
+        for ( int y = 0; y < SIZE; ++y ) {
+            for ( int x = 0; x < SIZE; ++x ) {
+                painter->drawRect(QRectF(position.x() + x * slotSize,
+                                         position.y() + y * slotSize,
+                                         slotSize, slotSize));
+            }
+        }
+    }
+}
+
+void WallView::closeEvent(QCloseEvent* event)
+{
+    stop();
+    event->accept();
+}
+
+void WallView::renderFrame()
+{
+    // Only the boards that changed ask for a repaint
+    for ( int i = 0; i < games.count(); ++i ) {
+        if ( boards.at(i)->setBoard(games.board(i)) ) {
+            ++boardsRepainted;
+        }
+    }
+    ++frames;
+
+    // Tell how the wall keeps up about once a second
+    qint64 elapsed = statsClock.elapsed();
+    if ( elapsed >= 1000 ) {
+        quint64 moves = games.moves();
+        setWindowTitle(QString("2048 - %1 fps, %2 boards/frame, "
+                               "%3 moves/s, %4 games")
+                       .arg(frames * 1000.0 / elapsed, 0, 'f', 1)
+                       .arg(double(boardsRepainted) / frames, 0, 'f', 1)
+                       .arg(qRound64((moves - movesAtStats) * 1000.0
+                                     / elapsed))
+                       .arg(games.games()));
+        statsClock.restart();
+        frames = 0;
+        boardsRepainted = 0;
+        movesAtStats = moves;
+    }
+}
+
+QPointF WallView::boardPosition(int index) const
+{
+    return QPointF(index % columns * boardStride(),
+                   index / columns * boardStride());
+}
+
+int WallView::boardStride() const
+{
+    return SIZE * slotSize + GAP;
+}
@@ -0,0 +1,87 @@
+/* WallView
+ *
+ * A window with a grid of games played by a strategy in the
+ * background, for watching bots. All the boards are items of one
+ * scene: a BoardItem per game draws its tiles from the tile atlas and
+ * the empty squares are in the cached background, so a frame only
+ * copies the tiles of the boards that changed since the last one.
+ *
+ * The games run in the worker threads of WallGames, the frame timer
+ * only reads their boards, so the speed of the games doesn't depend
+ * on the frame rate and the other way round. The title tells the frame
+ * rate and the number of boards repainted per frame.
+*/
+
+#ifndef WALLVIEW_HH
+#define WALLVIEW_HH
+
+#include "boarditem.hh"
+#include "tileatlas.hh"
+#include "wallgames.hh"
+#include <QElapsedTimer>
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QTimer>
+#include <functional>
+#include <vector>
+
+class WallView : public QGraphicsView
+{
+    Q_OBJECT
+
+public:
+    // Constructor, rows x columns games played with the given strategy,
+    // see create_strategy. The tiles are slotSize pixels.
+    WallView(int rows, int columns, int slotSize,
+             const std::string& strategy, QWidget* parent = nullptr);
+
+    // Same as in BoardItem, for every board
+    void setAtlas(const TileAtlas* atlas);
+    void setFallback(std::function<QPixmap(int exponent)> fallback);
+    void setAtlasEnabled(bool enabled);
+
+    // Starts the games with the seeds firstSeed, firstSeed + 1, ...
+    // Returns false, if the strategy doesn't exist.
+    bool start(uint firstSeed, int movesPerSecond);
+
+    // Stops the games
+    void stop();
+
+protected:
+    // Draws the empty squares of every board
+    void drawBackground(QPainter* painter, const QRectF& rect) override;
+
+    // The games are stopped when the window is closed
+    void closeEvent(QCloseEvent* event) override;
+
+private slots:
+    // Shows the current boards of the games
+    void renderFrame();
+
+private:
+    int rows;
+    int columns;
+    int slotSize;
+
+    // Space between the boards
+    const int GAP = 8;
+
+    QGraphicsScene* scene;
+    std::vector<BoardItem*> boards;
+    WallGames games;
+    QTimer* frameTimer;
+
+    // Frames drawn and boards repainted since the title was updated
+    QElapsedTimer statsClock;
+    int frames = 0;
+    int boardsRepainted = 0;
+    quint64 movesAtStats = 0;
+
+    // Position of the board with the given index in the scene
+    QPointF boardPosition(int index) const;
+
+    // Size of one board with the gap after it
+    int boardStride() const;
+};
+
+#endif // WALLVIEW_HH